@@ -0,0 +1 @@
+../../src/accountActivity.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/accountState.h
\ No newline at end of file
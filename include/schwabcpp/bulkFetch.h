@@ -0,0 +1 @@
+../../src/bulkFetch.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/candleStore.h
\ No newline at end of file
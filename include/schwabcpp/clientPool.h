@@ -0,0 +1 @@
+../../src/clientPool.h
\ No newline at end of file
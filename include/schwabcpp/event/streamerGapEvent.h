@@ -0,0 +1 @@
+../../../src/event/streamerGapEvent.h
\ No newline at end of file
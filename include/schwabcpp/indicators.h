@@ -0,0 +1 @@
+../../src/indicators.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/ioOptions.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/optionChain.h
\ No newline at end of file
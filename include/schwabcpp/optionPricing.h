@@ -0,0 +1 @@
+../../src/optionPricing.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/positionTable.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/rateLimiter.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../../src/schema/candleColumns.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/streamerData.h
\ No newline at end of file
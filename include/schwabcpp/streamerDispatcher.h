@@ -0,0 +1 @@
+../../src/streamerDispatcher.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/streamerStateTable.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../src/symbolTable.h
\ No newline at end of file
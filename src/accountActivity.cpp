@@ -0,0 +1,55 @@
+#include "accountActivity.h"
+
+namespace schwabcpp {
+
+namespace {
+
+// the side codes come in both spellings ("SellShort", "SELL_SHORT"), compare them loosely
+bool sameCode(std::string_view code, std::string_view lowercase)
+{
+    size_t i = 0;
+    for (char c : code) {
+        if (c == '_') {
+            continue;
+        }
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        if (i == lowercase.size() || c != lowercase[i]) {
+            return false;
+        }
+        ++i;
+    }
+    return i == lowercase.size();
+}
+
+}
+
+AccountActivity::Type AccountActivity::toType(std::string_view messageType)
+{
+    if (messageType == "OrderCreated")          return Type::OrderCreated;
+    if (messageType == "OrderAccepted")         return Type::OrderAccepted;
+    if (messageType == "OrderRejected")         return Type::OrderRejected;
+    // "you are out", the order is done without a (complete) fill
+    if (messageType == "OrderUROutCompleted")   return Type::OrderCanceled;
+    if (messageType == "ChangeAccepted")        return Type::OrderReplaced;
+    // OrderFillCompleted, OrderPartialFill, ...
+    if (messageType.find("Fill") != std::string_view::npos) {
+        return Type::Fill;
+    }
+
+    return Type::Other;
+}
+
+AccountActivity::Side AccountActivity::toSide(std::string_view code)
+{
+    if (sameCode(code, "buy") || sameCode(code, "buytoopen"))               return Side::Buy;
+    if (sameCode(code, "sell") || sameCode(code, "selltoclose"))            return Side::Sell;
+    if (sameCode(code, "sellshort") || sameCode(code, "selltoopen") ||
+        sameCode(code, "sellshortexempt"))                                  return Side::SellShort;
+    if (sameCode(code, "buytocover") || sameCode(code, "buytoclose"))       return Side::BuyToCover;
+
+    return Side::Unknown;
+}
+
+}
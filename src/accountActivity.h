@@ -0,0 +1,80 @@
+#ifndef __ACCOUNT_ACTIVITY_H__
+#define __ACCOUNT_ACTIVITY_H__
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "schwabcpp/positionTable.h"
+#include "schwabcpp/symbolTable.h"
+#include "schwabcpp/utils/clock.h"
+
+namespace schwabcpp {
+
+//
+// One decoded event of the ACCT_ACTIVITY stream (the orders and fills of the accounts).
+//
+// * The message data is a json document of its own, only what it takes to follow the orders and
+//   the positions is extracted: the order, its legs (when the event carries them) and the
+//   execution of a fill. The quantities and prices are converted from the streamer's decimals.
+//
+// * The string values point into the received frame, they are only valid during the handler call.
+//   The event is reused between calls. Copy what you need.
+//
+struct AccountActivity {
+
+    enum class Type : char {
+        OrderCreated,
+        OrderAccepted,
+        OrderRejected,
+        OrderCanceled,      // canceled or expired
+        OrderReplaced,      // the replacement is created as a new order
+        Fill,               // partial or complete
+        Other,              // the order workflow in between (and the subscription confirmation)
+    };
+
+    enum class Side : char {
+        Buy,
+        Sell,
+        SellShort,
+        BuyToCover,
+        Unknown,
+    };
+
+    // the message type (field 2)
+    static Type                 toType(std::string_view messageType);
+    // "Buy", "SellShort", "BUY_TO_COVER", "SellToOpen", ...
+    static Side                 toSide(std::string_view code);
+
+    struct Leg {
+        std::string_view        legId;
+        SymbolId                symbolId = SymbolTable::InvalidId;
+        std::string_view        symbol;         // owned by the symbol table, always valid
+        Position::AssetType     assetType = Position::AssetType::Unknown;
+        Side                    side = Side::Unknown;
+        double                  quantity = 0.0;
+    };
+
+    Type                        type = Type::Other;
+    std::string_view            messageType;
+    std::string_view            accountNumber;
+    std::string_view            orderId;
+    int64_t                     timestamp = 0;  // milliseconds since epoch, as stamped by the streamer
+
+    // the legs of the order, when the event carries it (e.g. OrderCreated)
+    std::vector<Leg>            legs;
+
+    // -- the execution of a fill
+    std::string_view            legId;          // empty if the order has a single leg
+    std::string_view            executionId;
+    double                      quantity = 0.0;
+    double                      price = 0.0;
+
+    // the whole message data
+    std::string_view            data;
+
+    inline clock::time_point    timePoint() const { return clock::time_point(std::chrono::milliseconds(timestamp)); }
+};
+
+}
+
+#endif
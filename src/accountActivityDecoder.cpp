@@ -0,0 +1,226 @@
+#include "accountActivityDecoder.h"
+#include "utils/jsonScanner.h"
+#include "utils/numberParser.h"
+
+namespace schwabcpp {
+
+namespace {
+
+using Token = JsonScanner::Token;
+
+// deeper than any event document, past that it's garbage
+const static int s_maxDepth = 32;
+
+struct Context {
+    SymbolTable&                symbols;
+    std::pmr::memory_resource&  scratch;
+    AccountActivity&            activity;
+    int                         legDepth = 0;   // of the entries of the order legs
+};
+
+// a string value, unescaped into the scratch space if it has to
+std::string_view text(const JsonScanner& scanner, std::pmr::memory_resource& scratch)
+{
+    std::string_view raw = scanner.text();
+    if (!scanner.hasEscape()) {
+        return raw;
+    }
+    char* out = static_cast<char*>(scratch.allocate(raw.size(), 1));
+    return std::string_view(out, JsonScanner::unescape(raw, out));
+}
+
+// the ids come as strings or numbers
+bool isId(Token token)
+{
+    return token == Token::String || token == Token::Number;
+}
+
+// The amounts are decimals like {"lo":"1500000","signScale":12}: the low 64 bits of the unscaled
+// value, the sign in bit 0 of signScale and the scale in the bits above (here 1.5).
+// Plain numbers are taken as they are. `out` is left alone if the value is not an amount.
+// Returns false on malformed input.
+bool decodeAmount(JsonScanner& scanner, Token first, double& out)
+{
+    if (first == Token::Number) {
+        NumberParser::parseDouble(scanner.text(), out);
+        return true;
+    }
+    if (first != Token::BeginObject) {
+        return scanner.skipValue(first);
+    }
+
+    int64_t lo = 0;
+    int64_t signScale = 0;
+    bool valid = false;
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        if (key == "lo" && isId(value)) {
+            valid = NumberParser::parseLong(scanner.text(), lo);
+        } else if (key == "signScale" && value == Token::Number) {
+            NumberParser::parseLong(scanner.text(), signScale);
+        } else if (!scanner.skipValue(value)) {
+            // "mid" and "hi" are beyond any quantity or price
+            return false;
+        }
+    }
+
+    if (valid) {
+        double result = static_cast<double>(lo);
+        for (int64_t scale = (signScale >> 1) & 0xff; scale > 0; --scale) {
+            result /= 10.0;
+        }
+        out = signScale & 1 ? -result : result;
+    }
+
+    return true;
+}
+
+bool decodeObject(JsonScanner& scanner, Context& context, AccountActivity::Leg* leg, int depth);
+
+// any value, the objects and arrays are searched too
+bool decodeValue(JsonScanner& scanner, Token first, Context& context, AccountActivity::Leg* leg, int depth)
+{
+    if (first == Token::BeginObject) {
+        return decodeObject(scanner, context, leg, depth + 1);
+    }
+    if (first != Token::BeginArray) {
+        return scanner.skipValue(first);
+    }
+
+    for (Token token = scanner.next(); token != Token::EndArray; token = scanner.next()) {
+        if (!decodeValue(scanner, token, context, leg, depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// the scanner is positioned right after the '[' of the order legs
+bool decodeLegs(JsonScanner& scanner, Context& context, int depth)
+{
+    for (Token token = scanner.next(); token != Token::EndArray; token = scanner.next()) {
+        if (token != Token::BeginObject) {
+            if (!scanner.skipValue(token)) {
+                return false;
+            }
+            continue;
+        }
+
+        AccountActivity::Leg& leg = context.activity.legs.emplace_back();
+        context.legDepth = depth + 1;
+        if (!decodeObject(scanner, context, &leg, depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// the scanner is positioned right after the '{' of the object
+bool decodeObject(JsonScanner& scanner, Context& context, AccountActivity::Leg* leg, int depth)
+{
+    if (depth > s_maxDepth) {
+        return false;
+    }
+
+    AccountActivity& activity = context.activity;
+
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        bool decoded = true;
+        if (key == "OrderLegs" && value == Token::BeginArray && !leg) {
+            decoded = decodeLegs(scanner, context, depth);
+        } else if (key == "SchwabOrderID" && isId(value) && !leg) {
+            // the order comes first, the nested ones (e.g. the parent) don't override it
+            if (activity.orderId.empty()) {
+                activity.orderId = text(scanner, context.scratch);
+            }
+        } else if ((key == "LegID" || key == "LegId") && isId(value)) {
+            std::string_view& legId = leg ? leg->legId : activity.legId;
+            if (legId.empty()) {
+                legId = text(scanner, context.scratch);
+            }
+        } else if (leg) {
+            // -- an entry of the order legs
+            if (key == "Symbol" && value == Token::String) {
+                if (leg->symbolId == SymbolTable::InvalidId) {
+                    leg->symbolId = context.symbols.intern(text(scanner, context.scratch));
+                    leg->symbol = context.symbols.name(leg->symbolId);
+                }
+            } else if (key == "SecurityType" && value == Token::String) {
+                std::string_view type = scanner.text();
+                if (type == "Equity") {
+                    leg->assetType = Position::AssetType::Equity;
+                } else if (type == "Option") {
+                    leg->assetType = Position::AssetType::Option;
+                } else {
+                    leg->assetType = Position::toAssetType(type);
+                }
+            } else if (key == "BuySellCode" && value == Token::String) {
+                leg->side = AccountActivity::toSide(scanner.text());
+            } else if (key == "Quantity" && depth == context.legDepth) {
+                // the ordered quantity, not one of the nested ones
+                decoded = decodeAmount(scanner, value, leg->quantity);
+            } else {
+                decoded = decodeValue(scanner, value, context, leg, depth);
+            }
+        } else {
+            // -- the execution of a fill
+            if ((key == "ExecutionId" || key == "ExecutionID") && isId(value)) {
+                if (activity.executionId.empty()) {
+                    activity.executionId = text(scanner, context.scratch);
+                }
+            } else if (key == "ExecutionQuantity") {
+                decoded = decodeAmount(scanner, value, activity.quantity);
+            } else if (key == "ExecutionPrice") {
+                decoded = decodeAmount(scanner, value, activity.price);
+            } else {
+                decoded = decodeValue(scanner, value, context, leg, depth);
+            }
+        }
+
+        if (!decoded) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
+
+namespace AccountActivityDecoder {
+
+bool decode(std::string_view data,
+            SymbolTable& symbols,
+            std::pmr::memory_resource& scratch,
+            AccountActivity& activity)
+{
+    // {"SchwabOrderID":"...","AccountNumber":"...","BaseEvent":{"EventType":"...","<EventType>":{...}}}
+    JsonScanner scanner(data);
+    if (scanner.next() != Token::BeginObject) {
+        return false;
+    }
+
+    Context context{ symbols, scratch, activity };
+    if (!decodeObject(scanner, context, nullptr, 0)) {
+        return false;
+    }
+
+    return scanner.next() == Token::End;
+}
+
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef __ACCOUNT_ACTIVITY_DECODER_H__
+#define __ACCOUNT_ACTIVITY_DECODER_H__
+
+#include <memory_resource>
+#include <string_view>
+#include "accountActivity.h"
+
+namespace schwabcpp {
+
+//
+// Decodes the message data of an ACCT_ACTIVITY event (field 3, a json document in a string) in a
+// single pass without building a json tree.
+//
+// * The documents nest the order a few levels deep and the nesting depends on the event, the
+//   decoder picks the keys it needs wherever they are: the order id, the entries of "OrderLegs"
+//   (id, symbol, security type, side, quantity) and the execution of a fill (leg id, execution
+//   id, quantity, price).
+//
+namespace AccountActivityDecoder {
+
+// Fills the order, legs and execution of `activity` (the rest is left as is), the symbols are
+// interned. The strings with escapes are unescaped into `scratch`.
+// Returns false if the data is malformed.
+bool                            decode(std::string_view data,
+                                       SymbolTable& symbols,
+                                       std::pmr::memory_resource& scratch,
+                                       AccountActivity& activity);
+
+}
+
+}
+
+#endif
@@ -0,0 +1,268 @@
+#include "accountState.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace schwabcpp {
+
+using Side = AccountActivity::Side;
+
+namespace {
+
+// the average price of a side after adding `quantity` at `price`
+double averagePrice(double heldQuantity, double heldPrice, double quantity, double price)
+{
+    double total = heldQuantity + quantity;
+    return total > 0.0 ? (heldQuantity * heldPrice + quantity * price) / total : 0.0;
+}
+
+// moves the position by a fill, the settled quantities only move with the snapshots
+void fill(Position& position, Side side, double quantity, double price)
+{
+    switch (side) {
+        case Side::Buy:
+            position.averageLongPrice = averagePrice(position.longQuantity, position.averageLongPrice, quantity, price);
+            position.longQuantity += quantity;
+            break;
+        case Side::Sell:
+            position.longQuantity = std::max(position.longQuantity - quantity, 0.0);
+            break;
+        case Side::SellShort:
+            position.averageShortPrice = averagePrice(position.shortQuantity, position.averageShortPrice, quantity, price);
+            position.shortQuantity += quantity;
+            break;
+        case Side::BuyToCover:
+            position.shortQuantity = std::max(position.shortQuantity - quantity, 0.0);
+            break;
+        case Side::Unknown:
+            break;
+    }
+
+    position.averagePrice = position.longQuantity > 0.0 ? position.averageLongPrice : position.averageShortPrice;
+}
+
+}
+
+std::optional<PositionTable::Change> AccountState::apply(const AccountActivity& activity)
+{
+    if (activity.orderId.empty()) {
+        return std::nullopt;
+    }
+
+    std::lock_guard lock(m_mutex);
+
+    Order* order = updateOrder(activity);
+    if (!order) {
+        if (activity.type == AccountActivity::Type::Fill) {
+            LOG_WARN("Fill of the unknown order {}, the positions are stale until reconciled.", activity.orderId);
+            m_stale = true;
+        }
+        return std::nullopt;
+    }
+
+    switch (activity.type) {
+        case AccountActivity::Type::OrderAccepted:
+            if (order->status == Order::Status::Created) {
+                order->status = Order::Status::Accepted;
+            }
+            break;
+        case AccountActivity::Type::OrderRejected:  order->status = Order::Status::Rejected; break;
+        case AccountActivity::Type::OrderCanceled:  order->status = Order::Status::Canceled; break;
+        case AccountActivity::Type::OrderReplaced:  order->status = Order::Status::Replaced; break;
+        case AccountActivity::Type::Fill:           return applyFill(*order, activity);
+        default:                                    break;
+    }
+
+    return std::nullopt;
+}
+
+AccountState::Order* AccountState::updateOrder(const AccountActivity& activity)
+{
+    auto it = m_orders.find(std::string(activity.orderId));
+    if (it == m_orders.end()) {
+        // only an event with the legs can create it, the others don't say what it trades
+        if (activity.legs.empty()) {
+            return nullptr;
+        }
+        it = m_orders.emplace(std::string(activity.orderId), Order()).first;
+        it->second.orderId = activity.orderId;
+        it->second.accountNumber = activity.accountNumber;
+    }
+
+    Order& order = it->second;
+    order.timestamp = activity.timestamp;
+
+    // the legs, what they filled stays
+    for (const AccountActivity::Leg& leg : activity.legs) {
+        auto target = std::find_if(order.legs.begin(), order.legs.end(),
+                                   [&leg](const Order::Leg& known) { return known.legId == leg.legId; });
+        if (target == order.legs.end()) {
+            target = order.legs.emplace(order.legs.end());
+            target->legId = leg.legId;
+        }
+
+        if (leg.symbolId != SymbolTable::InvalidId) {
+            target->symbolId = leg.symbolId;
+            target->symbol = leg.symbol;
+        }
+        if (leg.assetType != Position::AssetType::Unknown) {
+            target->assetType = leg.assetType;
+        }
+        if (leg.side != Side::Unknown) {
+            target->side = leg.side;
+        }
+        if (leg.quantity > 0.0) {
+            target->quantity = leg.quantity;
+        }
+    }
+
+    return &order;
+}
+
+std::optional<PositionTable::Change> AccountState::applyFill(Order& order, const AccountActivity& activity)
+{
+    // e.g. the completion of a fill without its execution
+    if (activity.quantity <= 0.0) {
+        return std::nullopt;
+    }
+
+    Order::Leg* leg = nullptr;
+    for (Order::Leg& known : order.legs) {
+        if (known.legId == activity.legId) {
+            leg = &known;
+            break;
+        }
+    }
+    if (!leg && order.legs.size() == 1) {
+        leg = &order.legs.front();
+    }
+    if (!leg || leg->symbolId == SymbolTable::InvalidId || leg->side == Side::Unknown) {
+        LOG_WARN("Fill of order {} without a known leg, the positions are stale until reconciled.", order.orderId);
+        m_stale = true;
+        return std::nullopt;
+    }
+
+    if (!activity.executionId.empty()) {
+        if (std::find(order.executions.begin(), order.executions.end(), activity.executionId) != order.executions.end()) {
+            return std::nullopt;
+        }
+        order.executions.emplace_back(activity.executionId);
+    }
+
+    // -- the order
+    leg->averageFillPrice = averagePrice(leg->filledQuantity, leg->averageFillPrice, activity.quantity, activity.price);
+    leg->filledQuantity += activity.quantity;
+
+    bool filled = std::all_of(order.legs.begin(), order.legs.end(),
+                              [](const Order::Leg& known) { return known.filledQuantity >= known.quantity; });
+    order.status = filled ? Order::Status::Filled : Order::Status::PartiallyFilled;
+
+    // -- the position
+    PositionTable& table = m_positions[order.accountNumber];
+
+    Position position;
+    if (const Position* open = table.find(leg->symbolId)) {
+        position = *open;
+    } else {
+        position.symbolId = leg->symbolId;
+        position.symbol = leg->symbol;
+        position.assetType = leg->assetType;
+    }
+    fill(position, leg->side, activity.quantity, activity.price);
+
+    return table.apply(position);
+}
+
+std::vector<PositionTable::Change> AccountState::reconcile(const std::string& accountNumber, std::span<const Position> positions)
+{
+    std::lock_guard lock(m_mutex);
+    return m_positions[accountNumber].update(positions);
+}
+
+void AccountState::reconciled()
+{
+    std::lock_guard lock(m_mutex);
+    m_stale = false;
+    std::erase_if(m_orders, [](const auto& entry) { return entry.second.finished(); });
+}
+
+bool AccountState::stale() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stale;
+}
+
+std::vector<std::string> AccountState::accounts() const
+{
+    std::lock_guard lock(m_mutex);
+
+    std::vector<std::string> result;
+    result.reserve(m_positions.size());
+    for (const auto& [accountNumber, _] : m_positions) {
+        result.push_back(accountNumber);
+    }
+
+    return result;
+}
+
+std::optional<Position> AccountState::position(const std::string& accountNumber, SymbolId id) const
+{
+    std::lock_guard lock(m_mutex);
+
+    auto it = m_positions.find(accountNumber);
+    if (it == m_positions.end()) {
+        return std::nullopt;
+    }
+    const Position* position = it->second.find(id);
+    if (!position) {
+        return std::nullopt;
+    }
+
+    return *position;
+}
+
+std::vector<Position> AccountState::positions(const std::string& accountNumber) const
+{
+    std::lock_guard lock(m_mutex);
+
+    std::vector<Position> result;
+    auto it = m_positions.find(accountNumber);
+    if (it == m_positions.end()) {
+        return result;
+    }
+
+    const PositionTable& table = it->second;
+    result.reserve(table.size());
+    for (SymbolId id : table.symbols()) {
+        result.push_back(*table.find(id));
+    }
+
+    return result;
+}
+
+std::optional<AccountState::Order> AccountState::order(const std::string& orderId) const
+{
+    std::lock_guard lock(m_mutex);
+
+    auto it = m_orders.find(orderId);
+    if (it == m_orders.end()) {
+        return std::nullopt;
+    }
+
+    return it->second;
+}
+
+std::vector<AccountState::Order> AccountState::workingOrders(const std::string& accountNumber) const
+{
+    std::lock_guard lock(m_mutex);
+
+    std::vector<Order> result;
+    for (const auto& [_, order] : m_orders) {
+        if (!order.finished() && (accountNumber.empty() || order.accountNumber == accountNumber)) {
+            result.push_back(order);
+        }
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,115 @@
+#ifndef __ACCOUNT_STATE_H__
+#define __ACCOUNT_STATE_H__
+
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "schwabcpp/accountActivity.h"
+#include "schwabcpp/positionTable.h"
+
+namespace schwabcpp {
+
+//
+// The orders and positions of the accounts, kept current from the ACCT_ACTIVITY stream
+// (see `Client::trackAccountActivity(...)`) instead of polling the account.
+//
+// * A fill moves the position of its symbol as soon as it is streamed: the quantities, and the
+//   average price of the side it opened. The market values and profit/loss stay the ones of the
+//   last rest snapshot, the quotes are the place for those.
+//
+// * The fill events only tell which order and leg were filled, not what was traded. The orders
+//   are followed from their creation, a fill of an order created before the tracking started (or
+//   during a gap) can't be applied. The state is `stale()` then, until the next reconciliation.
+//
+// * `reconcile(...)` replaces the positions of an account with a rest snapshot, the snapshot has
+//   the last word. The client does it when the tracking starts and after every reconnection of the
+//   streamer (the events of the gap are lost). A fill racing the snapshot is only corrected by the
+//   next one.
+//
+// * An execution reported by several events is applied once.
+//
+// * Thread-safe (the stream applies, the rest reconciles, anyone reads), the accessors return copies.
+//
+class AccountState
+{
+public:
+    struct Order {
+
+        enum class Status : char {
+            Created,
+            Accepted,
+            PartiallyFilled,
+            Filled,
+            Canceled,
+            Rejected,
+            Replaced,
+        };
+
+        struct Leg {
+            std::string             legId;
+            SymbolId                symbolId = SymbolTable::InvalidId;
+            std::string_view        symbol;         // owned by the symbol table, always valid
+            Position::AssetType     assetType = Position::AssetType::Unknown;
+            AccountActivity::Side   side = AccountActivity::Side::Unknown;
+            double                  quantity = 0.0;
+            double                  filledQuantity = 0.0;
+            double                  averageFillPrice = 0.0;
+        };
+
+        std::string                 orderId;
+        std::string                 accountNumber;
+        Status                      status = Status::Created;
+        int64_t                     timestamp = 0;  // of the last event
+        std::vector<Leg>            legs;
+        std::vector<std::string>    executions;     // the ids of the applied ones
+
+        // filled, canceled, rejected or replaced
+        bool                        finished() const { return status >= Status::Filled; }
+    };
+
+    // Applies an event of the stream. Returns the position the fill changed, if it did.
+    std::optional<PositionTable::Change>
+                                    apply(const AccountActivity& activity);
+
+    // Replaces the positions of the account with a rest snapshot (the whole account), returns the
+    // differences, i.e. what the stream missed.
+    std::vector<PositionTable::Change>
+                                    reconcile(const std::string& accountNumber, std::span<const Position> positions);
+
+    // after every account got reconciled: no longer stale, the finished orders are forgotten
+    void                            reconciled();
+
+    bool                            stale() const;
+
+    // -- positions
+    std::vector<std::string>        accounts() const;
+    std::optional<Position>         position(const std::string& accountNumber, SymbolId id) const;
+    // the open ones
+    std::vector<Position>           positions(const std::string& accountNumber) const;
+
+    // -- orders (since the tracking started, the finished ones until the next reconciliation)
+    std::optional<Order>            order(const std::string& orderId) const;
+    // the ones not finished yet, of an account (all of them if empty)
+    std::vector<Order>              workingOrders(const std::string& accountNumber = {}) const;
+
+private:
+    // the order of the event, nullptr if it was never created
+    Order*                          updateOrder(const AccountActivity& activity);
+    std::optional<PositionTable::Change>
+                                    applyFill(Order& order, const AccountActivity& activity);
+
+private:
+    std::unordered_map<std::string, PositionTable>
+                                    m_positions;        // by account number
+    std::unordered_map<std::string, Order>
+                                    m_orders;           // by order id
+    bool                            m_stale = false;
+    mutable std::mutex              m_mutex;
+};
+
+}
+
+#endif
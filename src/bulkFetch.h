@@ -0,0 +1,40 @@
+#ifndef __BULK_FETCH_H__
+#define __BULK_FETCH_H__
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace schwabcpp {
+
+//
+// Tuning of the bulk requests (e.g. `Client::priceHistoryBulk`). The requests are multiplexed on
+// the http engine, this bounds how many are in flight. Their pace is up to the rate limiter of the
+// client (see `Client::setRateLimit`).
+//
+struct BulkFetchOptions {
+
+    // requests in flight at once (queued in the rate limiter included)
+    size_t                      maxConcurrency = 32;
+};
+
+//
+// Outcome of a bulk request.
+//
+struct BulkFetchStats {
+    size_t                      requested = 0;
+    size_t                      succeeded = 0;
+    size_t                      failed = 0;
+    std::vector<std::string>    failedSymbols;
+
+    std::chrono::milliseconds   elapsed{ 0 };
+
+    double                      symbolsPerSecond() const
+    {
+        return elapsed.count() > 0 ? (succeeded + failed) * 1000.0 / elapsed.count() : 0.0;
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,309 @@
+#include "candleDecoder.h"
+#include "utils/jsonScanner.h"
+#include "utils/numberParser.h"
+
+namespace schwabcpp {
+
+namespace {
+
+using Token = JsonScanner::Token;
+
+// a candle is around 110 bytes of json, reserve for the lot upfront
+const static size_t s_bytesPerCandle = 100;
+
+enum CandleField : char {
+    Open     = 1 << 0,
+    High     = 1 << 1,
+    Low      = 1 << 2,
+    Close    = 1 << 3,
+    Volume   = 1 << 4,
+    Datetime = 1 << 5,
+
+    AllFields = Open | High | Low | Close | Volume | Datetime,
+};
+
+}
+
+struct CandleDecoder::Cursor {
+    JsonScanner                             scanner;
+    size_t                                  size;
+    bool                                    last;
+
+    // End if the token might be cut by the end of the text (more is coming)
+    Token next()
+    {
+        Token token = scanner.next();
+        if (last) {
+            return token;
+        }
+
+        // a cut string or literal (or malformed, the last chunk tells)
+        if (token == Token::Error) {
+            return Token::End;
+        }
+        // a number might go on in the next chunk
+        if (token == Token::Number && scanner.position() == size) {
+            return Token::End;
+        }
+
+        return token;
+    }
+
+    // the rest of the value, false if it doesn't end in this text
+    Step skip(Token first)
+    {
+        if (scanner.skipValue(first)) {
+            return Step::Progress;
+        }
+        return last ? Step::Failed : Step::NeedMore;
+    }
+};
+
+CandleDecoder::CandleDecoder(CandleList& out)
+    : m_state(State::Start)
+    , m_push([&out](const Candle& candle) { out.candles.push_back(candle); })
+    , m_symbol(out.symbol)
+    , m_empty(out.empty)
+    , m_previousClose(out.previousClose)
+    , m_previousCloseDate(out.previousCloseDate)
+    , m_hasCandles(false)
+    , m_hasSymbol(false)
+    , m_hasEmpty(false)
+{
+    out.candles.clear();
+    out.previousClose = std::nullopt;
+    out.previousCloseDate = std::nullopt;
+}
+
+CandleDecoder::CandleDecoder(CandleColumns& out)
+    : m_state(State::Start)
+    , m_push([&out](const Candle& candle) { out.push_back(candle); })
+    , m_symbol(out.symbol)
+    , m_empty(out.empty)
+    , m_previousClose(out.previousClose)
+    , m_previousCloseDate(out.previousCloseDate)
+    , m_hasCandles(false)
+    , m_hasSymbol(false)
+    , m_hasEmpty(false)
+{
+    out.datetime.clear();
+    out.open.clear();
+    out.high.clear();
+    out.low.clear();
+    out.close.clear();
+    out.volume.clear();
+    out.previousClose = std::nullopt;
+    out.previousCloseDate = std::nullopt;
+}
+
+bool CandleDecoder::feed(std::string_view chunk)
+{
+    if (m_state == State::Done || m_state == State::Failed) {
+        return m_state != State::Failed;
+    }
+
+    if (m_pending.empty()) {
+        // decoded in place, only the cut tail is copied
+        m_pending.assign(chunk.substr(advance(chunk, false)));
+    } else {
+        m_pending.append(chunk);
+        m_pending.erase(0, advance(m_pending, false));
+    }
+
+    return m_state != State::Failed;
+}
+
+bool CandleDecoder::finish()
+{
+    if (m_state != State::Done && m_state != State::Failed) {
+        advance(m_pending, true);
+    }
+    m_pending.clear();
+
+    return m_state == State::Done && m_hasCandles && m_hasSymbol && m_hasEmpty;
+}
+
+bool CandleDecoder::decode(std::string_view response, CandleList& out)
+{
+    CandleDecoder decoder(out);
+    out.candles.reserve(response.size() / s_bytesPerCandle);
+
+    return decoder.feed(response) && decoder.finish();
+}
+
+bool CandleDecoder::decode(std::string_view response, CandleColumns& out)
+{
+    CandleDecoder decoder(out);
+    out.reserve(response.size() / s_bytesPerCandle);
+
+    return decoder.feed(response) && decoder.finish();
+}
+
+size_t CandleDecoder::advance(std::string_view text, bool last)
+{
+    Cursor cursor{ JsonScanner(text), text.size(), last };
+
+    // every step is all or nothing, a cut one is done again with the next chunk
+    size_t consumed = 0;
+    while (m_state != State::Done) {
+        Step result = step(cursor);
+        if (result == Step::Failed || (result == Step::NeedMore && last)) {
+            m_state = State::Failed;
+            break;
+        }
+        if (result == Step::NeedMore) {
+            break;
+        }
+        consumed = cursor.scanner.position();
+    }
+
+    return consumed;
+}
+
+CandleDecoder::Step CandleDecoder::step(Cursor& cursor)
+{
+    Token token = cursor.next();
+    if (token == Token::End) {
+        return Step::NeedMore;
+    }
+
+    switch (m_state) {
+        case State::Start:
+            if (token != Token::BeginObject) {
+                return Step::Failed;
+            }
+            m_state = State::Response;
+            return Step::Progress;
+
+        case State::Candles:
+            if (token == Token::EndArray) {
+                m_state = State::Response;
+                return Step::Progress;
+            }
+            if (token != Token::BeginObject) {
+                return Step::Failed;
+            }
+            return stepCandle(cursor);
+
+        case State::Response:
+            break;
+
+        default:
+            return Step::Failed;
+    }
+
+    if (token == Token::EndObject) {
+        m_state = State::Done;
+        return Step::Progress;
+    }
+    if (token != Token::String) {
+        return Step::Failed;
+    }
+    std::string_view key = cursor.scanner.text();
+    bool escapedKey = cursor.scanner.hasEscape();
+
+    Token value = cursor.next();
+    if (value == Token::End) {
+        return Step::NeedMore;
+    }
+
+    if (escapedKey) {
+        // none of ours
+        return cursor.skip(value);
+    }
+
+    if (key == "candles" && value == Token::BeginArray) {
+        m_state = State::Candles;
+        m_hasCandles = true;
+    } else if (key == "symbol" && value == Token::String) {
+        std::string_view raw = cursor.scanner.text();
+        if (cursor.scanner.hasEscape()) {
+            m_symbol.resize(raw.size());
+            m_symbol.resize(JsonScanner::unescape(raw, m_symbol.data()));
+        } else {
+            m_symbol.assign(raw);
+        }
+        m_hasSymbol = true;
+    } else if (key == "empty" && (value == Token::True || value == Token::False)) {
+        m_empty = value == Token::True;
+        m_hasEmpty = true;
+    } else if (key == "previousClose" && value == Token::Number) {
+        double previousClose = 0.0;
+        if (!NumberParser::parseDouble(cursor.scanner.text(), previousClose)) {
+            return Step::Failed;
+        }
+        m_previousClose = previousClose;
+    } else if (key == "previousCloseDate" && value == Token::Number) {
+        int64_t previousCloseDate = 0;
+        if (!NumberParser::parseLong(cursor.scanner.text(), previousCloseDate)) {
+            return Step::Failed;
+        }
+        m_previousCloseDate = previousCloseDate;
+    } else {
+        return cursor.skip(value);
+    }
+
+    return Step::Progress;
+}
+
+CandleDecoder::Step CandleDecoder::stepCandle(Cursor& cursor)
+{
+    Candle candle;
+    int found = 0;
+
+    for (Token token = cursor.next(); token != Token::EndObject; token = cursor.next()) {
+        if (token == Token::End) {
+            return Step::NeedMore;
+        }
+        if (token != Token::String) {
+            return Step::Failed;
+        }
+        std::string_view key = cursor.scanner.text();
+
+        Token value = cursor.next();
+        if (value == Token::End) {
+            return Step::NeedMore;
+        }
+        if (value != Token::Number) {
+            Step skipped = cursor.skip(value);
+            if (skipped != Step::Progress) {
+                return skipped;
+            }
+            continue;
+        }
+
+        bool parsed = true;
+        if (key == "open") {
+            parsed = NumberParser::parseDouble(cursor.scanner.text(), candle.open);
+            found |= Open;
+        } else if (key == "high") {
+            parsed = NumberParser::parseDouble(cursor.scanner.text(), candle.high);
+            found |= High;
+        } else if (key == "low") {
+            parsed = NumberParser::parseDouble(cursor.scanner.text(), candle.low);
+            found |= Low;
+        } else if (key == "close") {
+            parsed = NumberParser::parseDouble(cursor.scanner.text(), candle.close);
+            found |= Close;
+        } else if (key == "volume") {
+            parsed = NumberParser::parseLong(cursor.scanner.text(), candle.volume);
+            found |= Volume;
+        } else if (key == "datetime") {
+            parsed = NumberParser::parseLong(cursor.scanner.text(), candle.datetime);
+            found |= Datetime;
+        }
+
+        if (!parsed) {
+            return Step::Failed;
+        }
+    }
+
+    if (found != AllFields) {
+        return Step::Failed;
+    }
+
+    m_push(candle);
+    return Step::Progress;
+}
+
+}
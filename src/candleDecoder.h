@@ -0,0 +1,81 @@
+#ifndef __CANDLE_DECODER_H__
+#define __CANDLE_DECODER_H__
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include "schema/candleColumns.h"
+#include "schema/candleList.h"
+
+namespace schwabcpp {
+
+class JsonScanner;
+
+//
+// Decodes price history responses straight into the candles (or the columns) while scanning the
+// text, no json document in between and no key lookups per candle.
+//
+// * Push based: `feed(...)` it the response as it arrives (from the curl write callback), every
+//   complete candle is decoded right away and only the incomplete tail of a chunk is kept. The
+//   decoding overlaps the transfer and the whole body is never held.
+//
+// * `finish()` returns false if the text was not a well formed price history response (missing
+//   fields included), the output is then unspecified. Once failed, the rest is ignored.
+//
+class CandleDecoder
+{
+public:
+    explicit                                CandleDecoder(CandleList& out);
+    explicit                                CandleDecoder(CandleColumns& out);
+
+    // false once failed
+    bool                                    feed(std::string_view chunk);
+    // end of the response
+    bool                                    finish();
+
+    // the whole response at once
+    static bool                             decode(std::string_view response, CandleList& out);
+    static bool                             decode(std::string_view response, CandleColumns& out);
+
+private:
+    enum class State : char {
+        Start,      // before the root object
+        Response,   // the fields of the root object
+        Candles,    // the elements of the candles array
+        Done,
+        Failed,
+    };
+
+    enum class Step : char {
+        Progress,
+        NeedMore,   // the next token or candle is cut by the end of the chunk
+        Failed,
+    };
+
+    // the scanner over the text at hand, `last` if no more text is coming
+    struct Cursor;
+
+    // decodes what it can of `text`, returns how much was consumed
+    size_t                                  advance(std::string_view text, bool last);
+    Step                                    step(Cursor& cursor);
+    Step                                    stepCandle(Cursor& cursor);
+
+private:
+    State                                   m_state;
+    std::string                             m_pending;  // the unconsumed tail of the previous chunks
+
+    // -- output
+    std::function<void(const Candle&)>      m_push;
+    std::string&                            m_symbol;
+    bool&                                   m_empty;
+    std::optional<double>&                  m_previousClose;
+    std::optional<clock::rep>&              m_previousCloseDate;
+
+    bool                                    m_hasCandles;
+    bool                                    m_hasSymbol;
+    bool                                    m_hasEmpty;
+};
+
+}
+
+#endif
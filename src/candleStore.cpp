@@ -0,0 +1,335 @@
+#include "candleStore.h"
+#include "utils/logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace schwabcpp {
+
+namespace {
+
+const static char s_metaMagic[8] = { 'S', 'C', 'P', 'C', 'A', 'N', 'D', 'L' };
+const static uint32_t s_metaVersion = 1;
+
+// in the order of CandleStore::Series::Column
+const static char* const s_columnNames[] = { "datetime", "open", "high", "low", "close", "volume" };
+
+// symbols like "BRK/B" or "$SPX" as a directory name
+std::string directoryName(const std::string& symbol)
+{
+    std::string result = symbol;
+    for (char& c : result) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-') {
+            c = '_';
+        }
+    }
+    return result;
+}
+
+bool writeAll(int fd, const void* data, size_t length, off_t offset)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (length > 0) {
+        ssize_t written = pwrite(fd, bytes, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= written;
+        offset += written;
+    }
+    return true;
+}
+
+}
+
+// -- Series
+CandleStore::Series::Mapping::~Mapping()
+{
+    if (data) {
+        munmap(data, length);
+    }
+}
+
+CandleColumnsView CandleStore::Series::view() const
+{
+    return { datetime(), open(), high(), low(), close(), volume() };
+}
+
+CandleColumnsView CandleStore::Series::view(int64_t from, int64_t to) const
+{
+    std::span<const int64_t> datetimes = datetime();
+    auto first = std::lower_bound(datetimes.begin(), datetimes.end(), from);
+    auto last = std::upper_bound(first, datetimes.end(), to);
+
+    return view().subview(first - datetimes.begin(), last - first);
+}
+
+CandleList CandleStore::Series::toCandleList(const std::string& symbol, int64_t from, int64_t to) const
+{
+    CandleColumnsView candles = view(from, to);
+
+    CandleList result;
+    result.symbol = symbol;
+    result.candles.reserve(candles.size());
+    for (size_t i = 0; i < candles.size(); ++i) {
+        result.candles.push_back({
+            .close = candles.close[i],
+            .datetime = candles.datetime[i],
+            .high = candles.high[i],
+            .low = candles.low[i],
+            .open = candles.open[i],
+            .volume = candles.volume[i],
+        });
+    }
+    result.empty = result.candles.empty();
+
+    return result;
+}
+
+CandleColumns CandleStore::Series::toCandleColumns(const std::string& symbol, int64_t from, int64_t to) const
+{
+    CandleColumnsView candles = view(from, to);
+
+    CandleColumns result;
+    result.symbol = symbol;
+    result.datetime.assign(candles.datetime.begin(), candles.datetime.end());
+    result.open.assign(candles.open.begin(), candles.open.end());
+    result.high.assign(candles.high.begin(), candles.high.end());
+    result.low.assign(candles.low.begin(), candles.low.end());
+    result.close.assign(candles.close.begin(), candles.close.end());
+    result.volume.assign(candles.volume.begin(), candles.volume.end());
+    result.empty = candles.size() == 0;
+
+    return result;
+}
+
+// -- CandleStore
+CandleStore::CandleStore(std::filesystem::path root)
+    : m_root(std::move(root))
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_root, ec);
+    if (ec) {
+        LOG_ERROR("Unable to create the candle store directory {}: {}", m_root.string(), ec.message());
+    }
+}
+
+std::optional<CandleStore::Series> CandleStore::open(const Key& key) const
+{
+    std::lock_guard lock(m_mutex);
+
+    const std::filesystem::path path = seriesPath(key);
+
+    Meta meta;
+    if (!readMeta(path / "meta", meta)) {
+        return std::nullopt;
+    }
+
+    Series series;
+    series.m_count = meta.count;
+    series.m_coveredFrom = meta.coveredFrom;
+    series.m_coveredTo = meta.coveredTo;
+
+    if (meta.count == 0) {
+        return series;
+    }
+
+    // every column is 8 bytes per candle, the files might be longer (overwritten tail)
+    const size_t length = meta.count * sizeof(int64_t);
+    for (int column = 0; column < Series::ColumnCount; ++column) {
+        const std::filesystem::path columnPath = path / s_columnNames[column];
+
+        int fd = ::open(columnPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOG_ERROR("Unable to open candle column {}.", columnPath.string());
+            return std::nullopt;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < length) {
+            LOG_ERROR("Candle column {} is shorter than its series.", columnPath.string());
+            ::close(fd);
+            return std::nullopt;
+        }
+
+        void* data = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // the mapping keeps the file
+        if (data == MAP_FAILED) {
+            LOG_ERROR("Unable to map candle column {}.", columnPath.string());
+            return std::nullopt;
+        }
+
+        series.m_columns[column] = std::make_shared<const Series::Mapping>(data, length);
+    }
+
+    return series;
+}
+
+bool CandleStore::append(const Key& key, const std::vector<Candle>& candles, int64_t coveredTo)
+{
+    std::lock_guard lock(m_mutex);
+
+    const std::filesystem::path path = seriesPath(key);
+
+    Meta meta;
+    if (!readMeta(path / "meta", meta)) {
+        LOG_ERROR("Candle series {} not found, write it first.", path.string());
+        return false;
+    }
+
+    // overwrite from the first candle that is not older than the appended ones
+    size_t offset = meta.count;
+    if (!candles.empty() && offset > 0) {
+        std::ifstream file(path / s_columnNames[Series::Datetime], std::ios::binary);
+        while (offset > 0) {
+            int64_t datetime = 0;
+            file.seekg((offset - 1) * sizeof(int64_t));
+            if (!file.read(reinterpret_cast<char*>(&datetime), sizeof(datetime))) {
+                LOG_ERROR("Unable to read candle series {}.", path.string());
+                return false;
+            }
+            if (datetime < candles.front().datetime) {
+                break;
+            }
+            --offset;
+        }
+    }
+
+    if (!writeColumns(path, candles, offset)) {
+        return false;
+    }
+
+    meta.count = offset + candles.size();
+    meta.coveredTo = std::max(meta.coveredTo, coveredTo);
+    return writeMeta(path / "meta", meta);
+}
+
+bool CandleStore::write(const Key& key, const std::vector<Candle>& candles, int64_t coveredFrom, int64_t coveredTo)
+{
+    std::lock_guard lock(m_mutex);
+
+    const std::filesystem::path path = seriesPath(key);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path, ec);
+    if (ec) {
+        LOG_ERROR("Unable to create candle series {}: {}", path.string(), ec.message());
+        return false;
+    }
+
+    // new files swapped in, the series already mapped keep the old ones
+    if (!writeColumns(path, candles, 0, ".tmp")) {
+        return false;
+    }
+    for (const char* name : s_columnNames) {
+        std::filesystem::rename(path / (std::string(name) + ".tmp"), path / name, ec);
+        if (ec) {
+            LOG_ERROR("Unable to replace candle column {}: {}", (path / name).string(), ec.message());
+            return false;
+        }
+    }
+
+    Meta meta;
+    std::memcpy(meta.magic, s_metaMagic, sizeof(meta.magic));
+    meta.version = s_metaVersion;
+    meta.reserved = 0;
+    meta.count = candles.size();
+    meta.coveredFrom = coveredFrom;
+    meta.coveredTo = coveredTo;
+    return writeMeta(path / "meta", meta);
+}
+
+std::filesystem::path CandleStore::seriesPath(const Key& key) const
+{
+    return m_root
+         / directoryName(key.symbol)
+         / (key.frequencyType.toString() + std::to_string(key.frequency) + (key.extendedHours ? "-ext" : ""));
+}
+
+bool CandleStore::readMeta(const std::filesystem::path& path, Meta& meta)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&meta), sizeof(meta))) {
+        return false;
+    }
+
+    if (std::memcmp(meta.magic, s_metaMagic, sizeof(meta.magic)) != 0 || meta.version != s_metaVersion) {
+        LOG_WARN("Ignoring candle series {}, unknown format.", path.parent_path().string());
+        return false;
+    }
+
+    return true;
+}
+
+bool CandleStore::writeMeta(const std::filesystem::path& path, const Meta& meta)
+{
+    // written aside and renamed, a reader never sees half of it
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(&meta), sizeof(meta))) {
+            LOG_ERROR("Unable to write {}.", temporary.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) {
+        LOG_ERROR("Unable to replace {}: {}", path.string(), ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+bool CandleStore::writeColumns(const std::filesystem::path& path,
+                               const std::vector<Candle>& candles,
+                               size_t offset,
+                               const std::string& suffix)
+{
+    std::vector<int64_t> integers(candles.size());
+    std::vector<double> reals(candles.size());
+
+    for (int column = 0; column < Series::ColumnCount; ++column) {
+        const void* data = nullptr;
+        switch (column) {
+            case Series::Datetime: std::transform(candles.begin(), candles.end(), integers.begin(), [](const Candle& candle) { return candle.datetime; }); data = integers.data(); break;
+            case Series::Open: std::transform(candles.begin(), candles.end(), reals.begin(), [](const Candle& candle) { return candle.open; }); data = reals.data(); break;
+            case Series::High: std::transform(candles.begin(), candles.end(), reals.begin(), [](const Candle& candle) { return candle.high; }); data = reals.data(); break;
+            case Series::Low: std::transform(candles.begin(), candles.end(), reals.begin(), [](const Candle& candle) { return candle.low; }); data = reals.data(); break;
+            case Series::Close: std::transform(candles.begin(), candles.end(), reals.begin(), [](const Candle& candle) { return candle.close; }); data = reals.data(); break;
+            case Series::Volume: std::transform(candles.begin(), candles.end(), integers.begin(), [](const Candle& candle) { return candle.volume; }); data = integers.data(); break;
+        }
+
+        const std::filesystem::path columnPath = path / (s_columnNames[column] + suffix);
+        int fd = ::open(columnPath.c_str(), O_WRONLY | O_CREAT | (suffix.empty() ? 0 : O_TRUNC), 0644);
+        if (fd < 0) {
+            LOG_ERROR("Unable to open candle column {} for writing.", columnPath.string());
+            return false;
+        }
+
+        bool written = writeAll(fd, data, candles.size() * sizeof(int64_t), offset * sizeof(int64_t));
+        ::close(fd);
+        if (!written) {
+            LOG_ERROR("Unable to write candle column {}.", columnPath.string());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,142 @@
+#ifndef __CANDLE_STORE_H__
+#define __CANDLE_STORE_H__
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "schwabcpp/schema/candleColumns.h"
+#include "schwabcpp/schema/candleList.h"
+#include "schwabcpp/types/frequencyType.h"
+#include "schwabcpp/utils/clock.h"
+
+namespace schwabcpp {
+
+//
+// Price history kept on disk, one series per (symbol, frequency).
+//
+// * Columnar: a series is a directory with one file per column (datetime, open, high, low, close,
+//   volume) plus a small meta file (candle count and the time range the series covers). Reading
+//   maps the columns, opening a series is a few mmap calls no matter how long it is.
+//
+// * Grows at the tail. `append(...)` overwrites the candles from the first appended one onwards
+//   (the last stored candle might have been in progress when it was fetched) and extends the
+//   covered range. `write(...)` replaces the whole series.
+//
+// * A `Series` stays valid while the store is written to. An append might update its last candles
+//   in place, a replaced series is swapped in by renaming (the old mappings keep the old files).
+//
+// * One writer per store directory (Thread-Safe within the process, not across processes).
+//
+// * Datetimes are epoch milliseconds, like the candles of the api.
+//
+class CandleStore
+{
+public:
+    struct Key {
+        std::string                         symbol;
+        FrequencyType                       frequencyType;
+        int                                 frequency;
+        bool                                extendedHours;
+    };
+
+    class Series {
+    public:
+        size_t                              size() const { return m_count; }
+        bool                                empty() const { return m_count == 0; }
+
+        std::span<const int64_t>            datetime() const { return column<int64_t>(Datetime); }
+        std::span<const double>             open() const { return column<double>(Open); }
+        std::span<const double>             high() const { return column<double>(High); }
+        std::span<const double>             low() const { return column<double>(Low); }
+        std::span<const double>             close() const { return column<double>(Close); }
+        std::span<const int64_t>            volume() const { return column<int64_t>(Volume); }
+
+        // the range the series was fetched for (might start or end with no candle, e.g. a weekend)
+        int64_t                             coveredFrom() const { return m_coveredFrom; }
+        int64_t                             coveredTo() const { return m_coveredTo; }
+
+        // all the candles, not copied
+        CandleColumnsView                   view() const;
+
+        // the candles within [from, to]
+        CandleColumnsView                   view(int64_t from, int64_t to) const;
+        CandleList                          toCandleList(const std::string& symbol, int64_t from, int64_t to) const;
+        CandleColumns                       toCandleColumns(const std::string& symbol, int64_t from, int64_t to) const;
+
+    private:
+        friend class CandleStore;
+
+        enum Column : char {
+            Datetime,
+            Open,
+            High,
+            Low,
+            Close,
+            Volume,
+
+            ColumnCount,
+        };
+
+        struct Mapping {
+                                            Mapping(void* data, size_t length) : data(data), length(length) {}
+                                            ~Mapping();
+            void*                           data;
+            size_t                          length;
+        };
+
+        template <typename T>
+        std::span<const T>                  column(Column column) const
+        {
+            return m_count ? std::span<const T>(static_cast<const T*>(m_columns[column]->data), m_count) : std::span<const T>();
+        }
+
+        size_t                              m_count = 0;
+        int64_t                             m_coveredFrom = 0;
+        int64_t                             m_coveredTo = 0;
+        std::shared_ptr<const Mapping>      m_columns[ColumnCount];
+    };
+
+    explicit                                CandleStore(std::filesystem::path root);
+
+    // nullopt if the series is not stored (or unreadable)
+    std::optional<Series>                   open(const Key& key) const;
+
+    // `candles` sorted by datetime, the covered range is extended to `coveredTo`
+    bool                                    append(const Key& key, const std::vector<Candle>& candles, int64_t coveredTo);
+    bool                                    write(const Key& key, const std::vector<Candle>& candles, int64_t coveredFrom, int64_t coveredTo);
+
+    const std::filesystem::path&            root() const { return m_root; }
+
+private:
+    struct Meta {
+        char                                magic[8];
+        uint32_t                            version;
+        uint32_t                            reserved;
+        uint64_t                            count;
+        int64_t                             coveredFrom;
+        int64_t                             coveredTo;
+    };
+
+    std::filesystem::path                   seriesPath(const Key& key) const;
+
+    static bool                             readMeta(const std::filesystem::path& path, Meta& meta);
+    static bool                             writeMeta(const std::filesystem::path& path, const Meta& meta);
+    // writes the columns of `candles` at candle index `offset`
+    static bool                             writeColumns(const std::filesystem::path& path,
+                                                         const std::vector<Candle>& candles,
+                                                         size_t offset,
+                                                         const std::string& suffix = "");
+
+private:
+    std::filesystem::path                   m_root;
+    mutable std::mutex                      m_mutex;
+};
+
+}
+
+#endif
@@ -1,11 +1,18 @@
 #include "client.h"
+#include "candleDecoder.h"
+#include "clientContext.h"
+#include "optionChainDecoder.h"
+#include "positionDecoder.h"
+#include "quoteDecoder.h"
 #include "schema/userPreference.h"
 #include "streamer.h"
+#include "responseCache.h"
 #include "base64.hpp"
 #include "nlohmann/json.hpp"
 #include "utils/logger.h"
 
 #include <curl/curl.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <chrono>
@@ -27,6 +34,29 @@ size_t writeCallback(void* contents, size_t size, size_t nmemb, std::string* buf
     return totalSize;
 }
 
+// a response handed over as it arrives, unless it is an error (collected for the message)
+struct StreamTarget {
+    CURL*                                   curl;
+    const std::function<void(std::string_view)>*
+                                            onData;
+    std::string*                            errorBody;
+};
+
+size_t streamCallback(void* contents, size_t size, size_t nmemb, StreamTarget* target)
+{
+    size_t totalSize = size * nmemb;
+
+    long status = 0;
+    curl_easy_getinfo(target->curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status < 400) {
+        (*target->onData)(std::string_view(static_cast<char*>(contents), totalSize));
+    } else {
+        target->errorBody->append(static_cast<char*>(contents), totalSize);
+    }
+
+    return totalSize;
+}
+
 std::string defaultOAuthUrlRequestCallback(OAuthUrlRequestEvent& event)
 {
     // requests the redirected url from terminal
@@ -53,17 +83,64 @@ void defaultOAuthCompleteCallback(OAuthCompleteEvent& event)
     }
 }
 
+// -- requests
+
+// the queries sorted, the same request is the same key
+std::string cacheKey(const std::string& url, const std::unordered_map<std::string, std::string>& queries)
+{
+    std::vector<std::pair<std::string, std::string>> sorted(queries.begin(), queries.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    std::string key = url;
+    for (const auto& [name, value] : sorted) {
+        key += "&" + name + "=" + value;
+    }
+    return key;
+}
+
+void embedQueries(std::string& url, const std::unordered_map<std::string, std::string>& queries)
+{
+    if (!queries.empty()) {
+        std::string queryString = std::accumulate(
+            queries.begin(),
+            queries.end(),
+            std::string(),
+            [] (std::string acc, const std::pair<std::string, std::string>& val) {
+                if (!acc.empty()) {
+                    acc += "&";
+                }
+                return acc + val.first + "=" + val.second;
+            }
+        );
+        url += "?" + queryString;
+    }
+}
+
 // -- some static variables
 
-const static std::string tokenCacheFile = ".tokens.json";
+const static std::string s_defaultTokenCacheFile = ".tokens.json";
 const static std::string s_traderAPIBaseUrl = "https://api.schwabapi.com/trader/v1";
 const static std::string s_marketAPIBaseUrl = "https://api.schwabapi.com/marketdata/v1";
 
+// how long the responses are cached
+const static std::chrono::milliseconds s_accountSummaryTtl = std::chrono::seconds(3);
+const static std::chrono::milliseconds s_marketHoursTtl = std::chrono::hours(1);
+
+// the quotes endpoint takes at most 500 symbols per call, and the url has to stay reasonable
+const static size_t s_maxQuotesPerRequest = 500;
+const static size_t s_maxQuotesSymbolsLength = 6000;
+
 }
 
-Client::Client(const std::string& key, const std::string& secret, std::shared_ptr<spdlog::logger> logger)
+Client::Client(const std::string& key,
+               const std::string& secret,
+               std::shared_ptr<spdlog::logger> logger,
+               const IoOptions& ioOptions)
     : m_key(key)
     , m_secret(secret)
+    , m_tokenCacheFile(s_defaultTokenCacheFile)
+    , m_pooled(false)
+    , m_pendingJobs(0)
     , m_eventCallback({})   // default empty callback
 {
     // create a logger unless one is already provided
@@ -75,16 +152,45 @@ Client::Client(const std::string& key, const std::string& secret, std::shared_pt
         Logger::init(spdlog::level::debug);
     }
 
-    // we are going to to a bunch of curl, init it here
-    curl_global_init(CURL_GLOBAL_DEFAULT);
+    // standalone client, create our own context (this inits curl)
+    m_context = std::make_shared<ClientContext>(ioOptions);
+    m_rateLimiter = std::make_shared<RateLimiter>(m_context->ioContext());
+    m_responseCache = std::make_unique<ResponseCache>();
 
     LOG_INFO("Schwab client initialized.");
 }
 
+Client::Client(const std::string& key,
+               const std::string& secret,
+               std::shared_ptr<ClientContext> context,
+               const std::string& tokenCacheFile)
+    : m_key(key)
+    , m_secret(secret)
+    , m_tokenCacheFile(tokenCacheFile)
+    , m_context(context)
+    , m_pooled(true)
+    , m_pendingJobs(0)
+    , m_eventCallback({})   // default empty callback
+{
+    m_rateLimiter = std::make_shared<RateLimiter>(m_context->ioContext());
+    m_responseCache = std::make_unique<ResponseCache>();
+
+    LOG_DEBUG("Schwab client initialized. (token cache: {})", m_tokenCacheFile);
+}
+
 Client::~Client()
 {
     LOG_INFO("Stopping client...");
 
+    // the async jobs call back into us, wait for them
+    {
+        std::unique_lock lock(m_mutexPendingJobs);
+        if (m_pendingJobs) {
+            LOG_TRACE("Waiting for {} pending async request(s)...", m_pendingJobs);
+        }
+        m_cvPendingJobs.wait(lock, [this] { return m_pendingJobs == 0; });
+    }
+
     // reset streamer
     m_streamer.reset();
 
@@ -92,8 +198,13 @@ Client::~Client()
     LOG_TRACE("Shutting down token checker daemon...");
     m_tokenCheckerDaemon.stop();  // this blocks
 
-    // curl cleanup
-    curl_global_cleanup();
+    // the pool owns the logger and the context, nothing else to release
+    if (m_pooled) {
+        return;
+    }
+
+    // release the context (joins the io context thread and cleans up curl)
+    m_context.reset();
 
     // now, we relase the logger
     Logger::releaseLogger();
@@ -147,12 +258,14 @@ bool Client::connect()
         // also cache user preference
         updateUserPreference();
 
-        // start the token checker daemon
-        LOG_DEBUG("Launching token checker daemon...");
-        m_tokenCheckerDaemon.start(
-            std::chrono::seconds(30),
-            std::bind(&Client::checkTokensAndReauth, this)
-        );
+        // start the token checker daemon (the pool staggers the checks of its clients itself)
+        if (!m_pooled) {
+            LOG_DEBUG("Launching token checker daemon...");
+            m_tokenCheckerDaemon.start(
+                std::chrono::seconds(30),
+                std::bind(&Client::checkTokensAndReauth, this)
+            );
+        }
 
         // create the streamer (do this last so that the user preference is ready to use)
         m_streamer = std::make_unique<Streamer>(this);
@@ -202,8 +315,538 @@ void Client::setStreamerDataHandler(std::function<void(const std::string&)> hand
     m_streamer->setDataHandler(handler);
 }
 
+void Client::setStreamerLevelOneEquityHandler(std::function<void(const LevelOneEquityUpdate&)> handler)
+{
+    m_streamer->setLevelOneEquityHandler(handler);
+}
+
+void Client::setStreamerSymbolFilter(const std::vector<std::string>& symbols)
+{
+    m_streamer->setSymbolFilter(symbols);
+}
+
+void Client::setStreamerLevelOneEquityFieldMask(const StreamerField::LevelOneEquityMask& mask)
+{
+    m_streamer->setLevelOneEquityFieldMask(mask);
+}
+
+void Client::setStreamerLevelOneOptionHandler(std::function<void(const LevelOneOptionUpdate&)> handler)
+{
+    m_streamer->setLevelOneOptionHandler(handler);
+}
+
+void Client::setStreamerLevelOneOptionFieldMask(const StreamerField::LevelOneOptionMask& mask)
+{
+    m_streamer->setLevelOneOptionFieldMask(mask);
+}
+
+void Client::setStreamerLevelOneFuturesHandler(std::function<void(const LevelOneFuturesUpdate&)> handler)
+{
+    m_streamer->setLevelOneFuturesHandler(handler);
+}
+
+void Client::setStreamerLevelOneFuturesFieldMask(const StreamerField::LevelOneFuturesMask& mask)
+{
+    m_streamer->setLevelOneFuturesFieldMask(mask);
+}
+
+void Client::setStreamerLevelOneForexHandler(std::function<void(const LevelOneForexUpdate&)> handler)
+{
+    m_streamer->setLevelOneForexHandler(handler);
+}
+
+void Client::setStreamerLevelOneForexFieldMask(const StreamerField::LevelOneForexMask& mask)
+{
+    m_streamer->setLevelOneForexFieldMask(mask);
+}
+
+void Client::setStreamerFixedPointPrices(bool enabled, uint32_t decimals)
+{
+    m_streamer->setFixedPointPrices(enabled, decimals);
+}
+
+SymbolId Client::getStreamerSymbolId(const std::string& symbol)
+{
+    return m_streamer->symbolTable().intern(symbol);
+}
+
+void Client::setStreamerDispatcherWorkers(size_t workers)
+{
+    m_streamer->setDispatcherWorkers(workers);
+}
+
+void Client::trackAccountActivity(std::shared_ptr<AccountState> state, std::function<void(const AccountActivity&)> handler)
+{
+    if (!m_streamer) {
+        LOG_ERROR("Client not connected, unable to track the account activity.");
+        return;
+    }
+
+    {
+        std::lock_guard lock(m_mutexAccountState);
+        m_accountState = state;
+    }
+
+    // the handler sees the state with the event applied
+    m_streamer->setAccountActivityHandler([state, handler](const AccountActivity& activity) {
+        state->apply(activity);
+        if (handler) {
+            handler(activity);
+        }
+    });
+    m_streamer->subscribeAccountActivity();
+
+    // the stream moves the positions from here on
+    reconcileAccountState();
+}
+
+bool Client::reconcileAccountState()
+{
+    std::shared_ptr<AccountState> state;
+    {
+        std::lock_guard lock(m_mutexAccountState);
+        state = m_accountState;
+    }
+    if (!state || !m_streamer) {
+        LOG_ERROR("No account activity tracked, nothing to reconcile.");
+        return false;
+    }
+
+    bool reconciled = true;
+    std::vector<Position> positions;
+    for (const std::string& accountNumber : getLinkedAccounts()) {
+        positions.clear();
+        if (!fetchPositions(accountNumber, positions)) {
+            reconciled = false;
+            continue;
+        }
+
+        std::vector<PositionTable::Change> changes = state->reconcile(accountNumber, positions);
+        if (!changes.empty()) {
+            LOG_DEBUG("Reconciled account {}, {} position(s) changed by the snapshot.", accountNumber, changes.size());
+        }
+    }
+
+    if (reconciled) {
+        state->reconciled();
+    }
+
+    return reconciled;
+}
+
+void Client::clearResponseCache()
+{
+    m_responseCache->clear();
+}
+
+void Client::setCandleStore(std::shared_ptr<CandleStore> store)
+{
+    std::lock_guard lock(m_mutexCandleStore);
+    m_candleStore = store;
+}
+
+void Client::setRateLimit(double requestsPerMinute, double burst)
+{
+    m_rateLimiter->setRate(requestsPerMinute, burst);
+}
+
+RateLimiter::Stats Client::getRateLimiterStats(RateLimiter::Priority priority) const
+{
+    return m_rateLimiter->stats(priority);
+}
+
+std::vector<StreamerDispatcher::WorkerStats> Client::getStreamerDispatcherStats() const
+{
+    return m_streamer->getDispatcherStats();
+}
+
 // -- sync api
 AccountSummary Client::accountSummary(const std::string& accountNumber) const
+{
+    return cachedRequest<AccountSummary>(accountSummaryRequest(accountNumber), &Client::parseAccountSummary);
+}
+
+AccountsSummaryMap Client::accountSummary() const
+{
+    return cachedRequest<AccountsSummaryMap>(accountSummaryRequest(), &Client::parseAccountsSummaryMap);
+}
+
+std::vector<PositionTable::Change> Client::updatePositions(const std::string& accountNumber,
+                                                           PositionTable& table,
+                                                           bool revaluations) const
+{
+    if (!m_streamer) {
+        LOG_ERROR("Client not connected, unable to fetch positions.");
+        return {};
+    }
+    {
+        std::lock_guard lock(m_mutexLinkedAccounts);
+        if (!m_linkedAccounts.contains(accountNumber)) {
+            LOG_ERROR("Unknown account {}, unable to fetch positions.", accountNumber);
+            return {};
+        }
+    }
+
+    std::vector<Position> positions;
+    positions.reserve(table.size());
+    if (!fetchPositions(accountNumber, positions)) {
+        return {};
+    }
+
+    return table.update(positions, revaluations);
+}
+
+bool Client::fetchPositions(const std::string& accountNumber, std::vector<Position>& positions) const
+{
+    RestRequest request = accountPositionsRequest(accountNumber);
+    bool succeeded = false;
+    std::string response = syncRequest(std::move(request.url), std::move(request.queries), request.priority, &succeeded);
+    if (!succeeded) {
+        LOG_ERROR("Unable to fetch the positions of account {}.", accountNumber);
+        return false;
+    }
+
+    if (!PositionDecoder::decode(response, m_streamer->symbolTable(), positions)) {
+        LOG_ERROR("Malformed positions response of account {}.", accountNumber);
+        return false;
+    }
+
+    return true;
+}
+
+CandleList Client::priceHistory(const std::string& ticker,
+                                PeriodType periodType,
+                                int period,
+                                FrequencyType frequencyType,
+                                int frequency,
+                                std::optional<clock::time_point> start,
+                                std::optional<clock::time_point> end,
+                                bool needExtendedHoursData,
+                                bool needPreviousClose) const
+{
+    // from disk if we can (needs a start date, the periods are relative to now, and the store
+    // doesn't have the previous close)
+    if (start.has_value() && !needPreviousClose) {
+        if (std::shared_ptr<CandleStore> store = getCandleStore()) {
+            auto [from, to] = storedRange(start.value(), end);
+            std::optional<CandleStore::Series> series = updateStoredSeries(*store, ticker, periodType, period, frequencyType, frequency,
+                                                                           from, to, needExtendedHoursData);
+            if (series) {
+                return series->toCandleList(ticker, from, to);
+            }
+        }
+    }
+
+    RestRequest request = priceHistoryRequest(ticker, periodType, period, frequencyType, frequency,
+                                              start, end, needExtendedHoursData, needPreviousClose);
+    return streamPriceHistory<CandleList>(request, &Client::parseCandleList);
+}
+
+CandleColumns Client::priceHistoryColumns(const std::string& ticker,
+                                          PeriodType periodType,
+                                          int period,
+                                          FrequencyType frequencyType,
+                                          int frequency,
+                                          std::optional<clock::time_point> start,
+                                          std::optional<clock::time_point> end,
+                                          bool needExtendedHoursData,
+                                          bool needPreviousClose) const
+{
+    if (start.has_value() && !needPreviousClose) {
+        if (std::shared_ptr<CandleStore> store = getCandleStore()) {
+            auto [from, to] = storedRange(start.value(), end);
+            std::optional<CandleStore::Series> series = updateStoredSeries(*store, ticker, periodType, period, frequencyType, frequency,
+                                                                           from, to, needExtendedHoursData);
+            if (series) {
+                return series->toCandleColumns(ticker, from, to);
+            }
+        }
+    }
+
+    RestRequest request = priceHistoryRequest(ticker, periodType, period, frequencyType, frequency,
+                                              start, end, needExtendedHoursData, needPreviousClose);
+    return streamPriceHistory<CandleColumns>(request, &Client::parseCandleColumns);
+}
+
+OptionChain Client::optionChain(const std::string& symbol,
+                                std::optional<int> strikeCount,
+                                std::optional<clock::time_point> fromDate,
+                                std::optional<clock::time_point> toDate) const
+{
+    RestRequest request = optionChainRequest(symbol, strikeCount, fromDate, toDate);
+    return parseOptionChain(syncRequest(std::move(request.url), std::move(request.queries), request.priority));
+}
+
+MarketHours Client::marketHours(MarketType marketType, std::optional<clock::time_point> utc) const
+{
+    return cachedRequest<MarketHours>(marketHoursRequest(marketType, utc), [marketType](const std::string& response) {
+        return parseMarketHours(response, marketType);
+    });
+}
+
+// -- candle store
+std::shared_ptr<CandleStore> Client::getCandleStore() const
+{
+    std::lock_guard lock(m_mutexCandleStore);
+    return m_candleStore;
+}
+
+std::pair<int64_t, int64_t> Client::storedRange(clock::time_point start, std::optional<clock::time_point> end)
+{
+    auto toMilliseconds = [](clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    };
+
+    const clock::time_point now = clock::now();
+    return { toMilliseconds(start), toMilliseconds(std::min(end.value_or(now), now)) };
+}
+
+std::optional<CandleStore::Series> Client::updateStoredSeries(CandleStore& store,
+                                                              const std::string& ticker,
+                                                              PeriodType periodType,
+                                                              int period,
+                                                              FrequencyType frequencyType,
+                                                              int frequency,
+                                                              int64_t from,
+                                                              int64_t to,
+                                                              bool needExtendedHoursData) const
+{
+    using std::chrono::milliseconds;
+
+    const CandleStore::Key key{ ticker, frequencyType, frequency, needExtendedHoursData };
+
+    // fetches [rangeFrom, rangeTo], empty if failed
+    auto fetchRange = [&](int64_t rangeFrom, int64_t rangeTo, bool& succeeded) {
+        RestRequest request = priceHistoryRequest(ticker, periodType, period, frequencyType, frequency,
+                                                  clock::time_point(milliseconds(rangeFrom)),
+                                                  clock::time_point(milliseconds(rangeTo)),
+                                                  needExtendedHoursData, false);
+        return streamPriceHistory<CandleList>(request, &Client::parseCandleList, &succeeded);
+    };
+
+    std::optional<CandleStore::Series> series = store.open(key);
+    if (!series || from < series->coveredFrom()) {
+        // nothing stored, or older candles than stored: fetch the whole range and replace the series
+        const int64_t fetchTo = series ? std::max(to, series->coveredTo()) : to;
+
+        bool succeeded = false;
+        CandleList fetched = fetchRange(from, fetchTo, succeeded);
+        if (!succeeded) {
+            LOG_WARN("Unable to fetch the price history of {}, serving what is stored.", ticker);
+        } else if (store.write(key, fetched.candles, from, fetchTo)) {
+            series = store.open(key);
+        } else {
+            LOG_WARN("Unable to store the price history of {}.", ticker);
+            return std::nullopt;
+        }
+    } else if (to > series->coveredTo()) {
+        // the tail, from the last stored candle (it might have been in progress)
+        const int64_t tailFrom = series->empty() ? series->coveredTo() : series->datetime().back();
+
+        bool succeeded = false;
+        CandleList fetched = fetchRange(tailFrom, to, succeeded);
+        if (!succeeded) {
+            LOG_WARN("Unable to fetch the recent price history of {}, serving what is stored.", ticker);
+        } else if (store.append(key, fetched.candles, to)) {
+            series = store.open(key);
+        }
+
+        LOG_TRACE("Fetched {} recent candle(s) of {}.", fetched.candles.size(), ticker);
+    }
+
+    return series;
+}
+
+// -- bulk api
+BulkFetchStats Client::priceHistoryBulk(const std::vector<std::string>& tickers,
+                                        PeriodType periodType,
+                                        int period,
+                                        FrequencyType frequencyType,
+                                        int frequency,
+                                        std::optional<clock::time_point> start,
+                                        std::optional<clock::time_point> end,
+                                        bool needExtendedHoursData,
+                                        bool needPreviousClose,
+                                        PriceHistoryResultFn onResult,
+                                        const BulkFetchOptions& options)
+{
+    using steady = std::chrono::steady_clock;
+
+    BulkFetchStats stats;
+    stats.requested = tickers.size();
+
+    // shared with the completions
+    size_t inFlight = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    const size_t maxConcurrency = std::max<size_t>(options.maxConcurrency, 1);
+    const steady::time_point startTime = steady::now();
+
+    LOG_DEBUG("Fetching the price history of {} symbol(s)...", tickers.size());
+
+    for (const std::string& ticker : tickers) {
+        // wait for a free slot
+        {
+            std::unique_lock lock(mutex);
+            waitForRequests(lock, cv, [&] { return inFlight < maxConcurrency; });
+            ++inFlight;
+        }
+
+        // behind everything else in the rate limiter
+        RestRequest request = priceHistoryRequest(ticker, periodType, period, frequencyType, frequency,
+                                                  start, end, needExtendedHoursData, needPreviousClose);
+        request.priority = RateLimiter::Priority::Bulk;
+
+        // decoded while it arrives, the candles are ready when the transfer is done
+        struct Decoded {
+            CandleList                      candles;
+            CandleDecoder                   decoder{ candles };
+        };
+        auto decoded = std::make_shared<Decoded>();
+
+        submitRequest(
+            std::move(request),
+            [&, ticker, decoded](std::exception_ptr error, std::string) {
+                if (!error && !decoded->decoder.finish()) {
+                    LOG_ERROR("Malformed price history response of {}.", ticker);
+                    error = std::make_exception_ptr(std::runtime_error("Malformed price history response."));
+                }
+                CandleList candles = error ? CandleList{} : std::move(decoded->candles);
+
+                std::lock_guard lock(mutex);
+                if (error) {
+                    ++stats.failed;
+                    stats.failedSymbols.push_back(ticker);
+                } else {
+                    ++stats.succeeded;
+                }
+
+                if (onResult) {
+                    try {
+                        onResult(ticker, error, std::move(candles));
+                    } catch (const std::exception& e) {
+                        LOG_ERROR("Bulk price history callback of {} threw: {}", ticker, e.what());
+                    }
+                }
+
+                --inFlight;
+                cv.notify_all();
+            },
+            [decoded](std::string_view chunk) {
+                decoded->decoder.feed(chunk);
+            }
+        );
+    }
+
+    // wait for the stragglers
+    {
+        std::unique_lock lock(mutex);
+        waitForRequests(lock, cv, [&] { return inFlight == 0; });
+    }
+
+    stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(steady::now() - startTime);
+
+    LOG_DEBUG("Fetched the price history of {} symbol(s) in {} ms ({:.1f}/s), {} failed.",
+              stats.succeeded, stats.elapsed.count(), stats.symbolsPerSecond(), stats.failed);
+
+    return stats;
+}
+
+std::vector<LevelOneEquityQuote> Client::quotes(const std::vector<std::string>& symbols,
+                                                const std::vector<StreamerField::LevelOneEquity>& fields)
+{
+    if (!m_streamer) {
+        LOG_ERROR("Client not connected, unable to fetch quotes.");
+        return {};
+    }
+    // the ids of the streamed updates
+    SymbolTable& symbolTable = m_streamer->symbolTable();
+
+    StreamerField::LevelOneEquityMask mask;
+    if (fields.empty()) {
+        mask.set();
+    }
+    for (StreamerField::LevelOneEquity field : fields) {
+        mask.set(static_cast<size_t>(field));
+    }
+    std::string sections = QuoteDecoder::sections(mask);
+    if (sections.empty()) {
+        sections = "quote";
+    }
+
+    // as many symbols per request as it takes
+    struct Batch {
+        std::string                     symbols;
+        size_t                          count = 0;
+        std::vector<LevelOneEquityQuote>
+                                        quotes;
+    };
+    std::vector<Batch> batches;
+    for (const std::string& symbol : symbols) {
+        if (batches.empty() ||
+            batches.back().count >= s_maxQuotesPerRequest ||
+            batches.back().symbols.size() + 1 + symbol.size() > s_maxQuotesSymbolsLength)
+        {
+            batches.emplace_back();
+        }
+
+        Batch& batch = batches.back();
+        if (!batch.symbols.empty()) {
+            batch.symbols += ",";
+        }
+        batch.symbols += symbol;
+        ++batch.count;
+    }
+
+    // all in flight at once, the rate limiter paces them
+    size_t pending = batches.size();
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    for (Batch& batch : batches) {
+        HttpRequestQueries queries = {
+            {"symbols", batch.symbols},
+            {"fields", sections},
+            {"indicative", "false"},
+        };
+
+        submitRequest(
+            { s_marketAPIBaseUrl + "/quotes", std::move(queries) },
+            [&](std::exception_ptr error, std::string response) {
+                std::vector<LevelOneEquityQuote> decoded;
+                if (error) {
+                    LOG_ERROR("Unable to fetch the quotes of {} symbol(s).", batch.count);
+                } else if (!QuoteDecoder::decode(response, symbolTable, mask, decoded)) {
+                    LOG_ERROR("Malformed quotes response.");
+                }
+
+                std::lock_guard lock(mutex);
+                batch.quotes = std::move(decoded);
+                --pending;
+                cv.notify_all();
+            }
+        );
+    }
+
+    {
+        std::unique_lock lock(mutex);
+        waitForRequests(lock, cv, [&] { return pending == 0; });
+    }
+
+    std::vector<LevelOneEquityQuote> result;
+    result.reserve(symbols.size());
+    for (Batch& batch : batches) {
+        std::move(batch.quotes.begin(), batch.quotes.end(), std::back_inserter(result));
+    }
+
+    LOG_TRACE("Fetched {} quote(s) of {} symbol(s) in {} request(s).", result.size(), symbols.size(), batches.size());
+
+    return result;
+}
+
+// -- requests and responses
+Client::RestRequest Client::accountSummaryRequest(const std::string& accountNumber) const
 {
     std::string finalUrl = s_traderAPIBaseUrl + "/accounts";
 
@@ -219,17 +862,10 @@ AccountSummary Client::accountSummary(const std::string& accountNumber) const
         // {"fields", "positions"}
     };
 
-    // process the json data
-    return json::parse(
-        std::move(
-            syncRequest(
-                finalUrl, std::move(queries)
-            )
-        )
-    ).get<AccountSummary>();
+    return { std::move(finalUrl), std::move(queries), RateLimiter::Priority::High, s_accountSummaryTtl };
 }
 
-AccountsSummaryMap Client::accountSummary() const
+Client::RestRequest Client::accountSummaryRequest() const
 {
     std::string finalUrl = s_traderAPIBaseUrl + "/accounts";
 
@@ -237,25 +873,29 @@ AccountsSummaryMap Client::accountSummary() const
         // {"fields", "positions"}
     };
 
-    // process the json data
-    return json::parse(
-        std::move(
-            syncRequest(
-                finalUrl, std::move(queries)
-            )
-        )
-    ).get<AccountsSummaryMap>();
+    return { std::move(finalUrl), std::move(queries), RateLimiter::Priority::High, s_accountSummaryTtl };
 }
 
-CandleList Client::priceHistory(const std::string& ticker,
-                                PeriodType periodType,
-                                int period,
-                                FrequencyType frequencyType,
-                                int frequency,
-                                std::optional<clock::time_point> start,
-                                std::optional<clock::time_point> end,
-                                bool needExtendedHoursData,
-                                bool needPreviousClose) const
+Client::RestRequest Client::accountPositionsRequest(const std::string& accountNumber) const
+{
+    RestRequest request = accountSummaryRequest(accountNumber);
+    request.queries.emplace("fields", "positions");
+
+    // polled for the changes, not cached
+    request.ttl = std::chrono::milliseconds(0);
+
+    return request;
+}
+
+Client::RestRequest Client::priceHistoryRequest(const std::string& ticker,
+                                                PeriodType periodType,
+                                                int period,
+                                                FrequencyType frequencyType,
+                                                int frequency,
+                                                std::optional<clock::time_point> start,
+                                                std::optional<clock::time_point> end,
+                                                bool needExtendedHoursData,
+                                                bool needPreviousClose) const
 {
     std::string finalUrl = s_marketAPIBaseUrl + "/pricehistory";
 
@@ -270,22 +910,16 @@ CandleList Client::priceHistory(const std::string& ticker,
     };
 
     if (start.has_value()) {
-        queries.emplace("startDate", std::to_string(start.value().time_since_epoch().count()));
+        queries.emplace("startDate", std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(start.value().time_since_epoch()).count()));
     }
     if (end.has_value()) {
-        queries.emplace("endDate", std::to_string(end.value().time_since_epoch().count()));
+        queries.emplace("endDate", std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(end.value().time_since_epoch()).count()));
     }
 
-    return json::parse(
-        std::move(
-            syncRequest(
-                finalUrl, std::move(queries)
-            )
-        )
-    ).get<CandleList>();
+    return { std::move(finalUrl), std::move(queries) };
 }
 
-MarketHours Client::marketHours(MarketType marketType, std::optional<clock::time_point> utc) const
+Client::RestRequest Client::marketHoursRequest(MarketType marketType, std::optional<clock::time_point> utc) const
 {
     // NOTE:
     // The API is returning garbage when market type is anything but Equity for some reason.
@@ -309,14 +943,124 @@ MarketHours Client::marketHours(MarketType marketType, std::optional<clock::time
         {"date", oss.str()},
     };
 
-    // send
-    json response = json::parse(
-        std::move(
-            syncRequest(
-                finalUrl, std::move(queries)
-            )
-        )
-    );
+    return { std::move(finalUrl), std::move(queries), RateLimiter::Priority::Normal, s_marketHoursTtl };
+}
+
+Client::RestRequest Client::optionChainRequest(const std::string& symbol,
+                                                std::optional<int> strikeCount,
+                                                std::optional<clock::time_point> fromDate,
+                                                std::optional<clock::time_point> toDate) const
+{
+    std::string finalUrl = s_marketAPIBaseUrl + "/chains";
+
+    // format as YYYY-MM-DD
+    auto toDateString = [](clock::time_point time) {
+        std::time_t t = clock::to_time_t(time);
+        std::tm tm = *std::gmtime(&t);
+
+        std::ostringstream oss;
+        oss << std::put_time(&tm, "%Y-%m-%d");
+        return oss.str();
+    };
+
+    HttpRequestQueries queries = {
+        {"symbol", symbol},
+        {"contractType", "ALL"},
+        {"strategy", "SINGLE"},
+        {"includeUnderlyingQuote", "false"},
+    };
+    if (strikeCount.has_value()) {
+        queries.emplace("strikeCount", std::to_string(strikeCount.value()));
+    }
+    if (fromDate.has_value()) {
+        queries.emplace("fromDate", toDateString(fromDate.value()));
+    }
+    if (toDate.has_value()) {
+        queries.emplace("toDate", toDateString(toDate.value()));
+    }
+
+    return { std::move(finalUrl), std::move(queries) };
+}
+
+AccountSummary Client::parseAccountSummary(const std::string& response)
+{
+    return json::parse(response).get<AccountSummary>();
+}
+
+AccountsSummaryMap Client::parseAccountsSummaryMap(const std::string& response)
+{
+    return json::parse(response).get<AccountsSummaryMap>();
+}
+
+CandleList Client::parseCandleList(const std::string& response)
+{
+    // straight into the candles, the history can be millions of them
+    CandleList result;
+    if (CandleDecoder::decode(response, result)) {
+        return result;
+    }
+
+    // not what we expected, let the json parser tell what is wrong
+    return json::parse(response).get<CandleList>();
+}
+
+CandleColumns Client::parseCandleColumns(const std::string& response)
+{
+    CandleColumns result;
+    if (CandleDecoder::decode(response, result)) {
+        return result;
+    }
+
+    return json::parse(response).get<CandleColumns>();
+}
+
+OptionChain Client::parseOptionChain(const std::string& response)
+{
+    OptionChain result;
+    if (!OptionChainDecoder::decode(response, result)) {
+        throw std::runtime_error("Malformed option chain response.");
+    }
+
+    return result;
+}
+
+template <typename Result>
+Result Client::streamPriceHistory(const RestRequest& request,
+                                  Result (*parse)(const std::string&),
+                                  bool* succeeded) const
+{
+    Result result;
+    CandleDecoder decoder(result);
+
+    bool requestSucceeded = false;
+    std::string response = syncRequest(request.url, request.queries, request.priority, &requestSucceeded, [&decoder](std::string_view chunk) {
+        decoder.feed(chunk);
+    });
+
+    bool decoded = requestSucceeded && decoder.finish();
+    if (requestSucceeded && !decoded) {
+        LOG_ERROR("Malformed price history response from {}.", request.url);
+    }
+
+    if (succeeded) {
+        *succeeded = decoded;
+        return decoded ? std::move(result) : Result{};
+    }
+
+    if (!requestSucceeded) {
+        // the error response (or the empty one)
+        return parse(response);
+    }
+    if (!decoded) {
+        throw std::runtime_error("Malformed price history response.");
+    }
+
+    return result;
+}
+
+MarketHours Client::parseMarketHours(const std::string& response, MarketType marketType)
+{
+    json data = json::parse(response);
 
     // response is in the form of
     // {
@@ -330,8 +1074,8 @@ MarketHours Client::marketHours(MarketType marketType, std::optional<clock::time
     //
     // I'll retrieve the 1st data matching the market type
     MarketHours result;
-    if (response.contains(marketType.toString())) {
-        auto matched = response[marketType.toString()];
+    if (data.contains(marketType.toString())) {
+        auto matched = data[marketType.toString()];
         for (auto it = matched.begin(); it != matched.end(); ++it) {
             it.value().get_to(result);
             break;
@@ -341,29 +1085,27 @@ MarketHours Client::marketHours(MarketType marketType, std::optional<clock::time
     return std::move(result);
 }
 
-std::string Client::syncRequest(std::string url, HttpRequestQueries queries) const
+std::string Client::syncRequest(std::string url,
+                                HttpRequestQueries queries,
+                                RateLimiter::Priority priority,
+                                bool* succeeded,
+                                const DataFn& onData) const
 {
+    if (succeeded) {
+        *succeeded = false;
+    }
+
     // initialize to empty
     std::string response("{}");
 
-    // init curl
-    CURL* curl = curl_easy_init();
-    if (curl) {
+    // wait for our turn rather than getting rejected
+    m_rateLimiter->acquire(priority);
+
+    // a pooled handle, the connection to the host is most likely still open
+    HttpHandlePool::Handle handle = m_context->httpHandles().acquire();
+    if (CURL* curl = handle.get()) {
         // embed queries
-        if (!queries.empty()) {
-            std::string queryString = std::accumulate(
-                queries.begin(),
-                queries.end(),
-                std::string(),
-                [] (std::string acc, const std::pair<std::string, std::string>& val) {
-                    if (!acc.empty()) {
-                        acc += "&";
-                    }
-                    return acc + val.first + "=" + val.second;
-                }
-            );
-            url += "?" + queryString;
-        }
+        embedQueries(url, queries);
 
         LOG_TRACE("Request URL: {}", url);
 
@@ -380,8 +1122,14 @@ std::string Client::syncRequest(std::string url, HttpRequestQueries queries) con
 
         // write callback
         response.clear();
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        StreamTarget streamTarget{ curl, &onData, &response };
+        if (onData) {
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, streamCallback);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &streamTarget);
+        } else {
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+        }
 
         // send
         CURLcode res = curl_easy_perform(curl);
@@ -390,16 +1138,154 @@ std::string Client::syncRequest(std::string url, HttpRequestQueries queries) con
             LOG_ERROR("In {}, curl_easy_perform(...) failed: {}", __PRETTY_FUNCTION__, curl_easy_strerror(res));
         } else {
             LOG_TRACE("Response data: {}", response);
+
+            long status = 0;
+            curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+            if (status == 429) {
+                LOG_WARN("Request rejected by the api rate limit, consider lowering the client rate limit.");
+            }
+            if (succeeded) {
+                *succeeded = status < 400;
+            }
         }
 
-        // cleanup
+        // cleanup (the handle goes back to the pool)
         curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
     }
 
     return response;
 }
 
+// completion token plumbing
+net::any_io_executor Client::getExecutor() const
+{
+    return m_context->ioContext().get_executor();
+}
+
+Client::ParsedResponse Client::fetch(RestRequest request, ParseFn parse) const
+{
+    if (request.ttl.count() <= 0) {
+        return parse(syncRequest(std::move(request.url), std::move(request.queries), request.priority));
+    }
+
+    return m_responseCache->get(cacheKey(request.url, request.queries), request.ttl, [this, &request, &parse]() -> ParsedResponse {
+        bool succeeded = false;
+        std::string response = syncRequest(request.url, request.queries, request.priority, &succeeded);
+
+        // don't cache a failure
+        return succeeded ? parse(response) : nullptr;
+    });
+}
+
+void Client::fetchAsync(RestRequest request,
+                        ParseFn parse,
+                        std::function<void(std::exception_ptr, ParsedResponse)> done)
+{
+    // the parsing is part of the fetch, the callers of a coalesced request share the result
+    auto submit = [this, parse = std::move(parse)](RestRequest request, ResponseCache::DoneFn done) {
+        submitRequest(std::move(request), [parse, done = std::move(done)](std::exception_ptr error, std::string response) {
+            ParsedResponse parsed;
+            if (!error) {
+                try {
+                    parsed = parse(response);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            done(error, std::move(parsed));
+        });
+    };
+
+    if (request.ttl.count() <= 0) {
+        submit(std::move(request), std::move(done));
+        return;
+    }
+
+    const std::string key = cacheKey(request.url, request.queries);
+    const std::chrono::milliseconds ttl = request.ttl;
+    m_responseCache->getAsync(
+        key,
+        ttl,
+        [submit, request = std::move(request)](ResponseCache::DoneFn done) {
+            submit(request, std::move(done));
+        },
+        std::move(done)
+    );
+}
+
+void Client::submitRequest(RestRequest request,
+                           std::function<void(std::exception_ptr, std::string)> done,
+                           DataFn onData)
+{
+    HttpEngine::Request httpRequest;
+    httpRequest.url = std::move(request.url);
+    httpRequest.onData = std::move(onData);
+    embedQueries(httpRequest.url, request.queries);
+
+    {
+        std::lock_guard lock(m_mutexPendingJobs);
+        ++m_pendingJobs;
+    }
+
+    // queued in the rate limiter until our turn (the engine never sees more than the budget)
+    m_rateLimiter->acquireAsync(request.priority, [this, httpRequest = std::move(httpRequest), done = std::move(done)]() mutable {
+        // the token might have been refreshed while we were waiting
+        httpRequest.headers.push_back("Authorization: Bearer " + getAccessToken());
+
+        // the engine thread only hands the response off, the rest pool does the parsing
+        m_context->httpEngine().submit(std::move(httpRequest), [this, done = std::move(done)](CURLcode result, long status, std::string body) mutable {
+            net::post(m_context->restPool(), [this, done = std::move(done), result, status, body = std::move(body)]() mutable {
+                std::exception_ptr error;
+                if (result != CURLE_OK) {
+                    error = std::make_exception_ptr(std::runtime_error(std::string("Request failed: ") + curl_easy_strerror(result)));
+                } else if (status >= 400) {
+                    // rate limited, expired token, unknown symbol...
+                    LOG_ERROR("Async request failed with http status {}: {}", status, body);
+                    error = std::make_exception_ptr(std::runtime_error("Request failed with http status " + std::to_string(status) + "."));
+                } else {
+                    LOG_TRACE("Async response data ({}): {}", status, body);
+                }
+
+                done(error, std::move(body));
+
+                std::lock_guard lock(m_mutexPendingJobs);
+                if (--m_pendingJobs == 0) {
+                    m_cvPendingJobs.notify_all();
+                }
+            });
+        });
+    });
+}
+
+void Client::waitForRequests(std::unique_lock<std::mutex>& lock,
+                             std::condition_variable& cv,
+                             const std::function<bool()>& done)
+{
+    if (!m_context->ioContext().get_executor().running_in_this_thread()) {
+        cv.wait(lock, done);
+        return;
+    }
+
+    while (!done()) {
+        lock.unlock();
+        std::chrono::steady_clock::time_point next = m_rateLimiter->serve();
+        lock.lock();
+
+        cv.wait_until(lock, next, done);
+    }
+}
+
+void Client::addQuoteWaiter(const std::string& symbol,
+                            std::function<void(std::exception_ptr, LevelOneEquityQuote)> fn)
+{
+    if (!m_streamer) {
+        fn(std::make_exception_ptr(std::runtime_error("Streamer not available, connect first.")), LevelOneEquityQuote{});
+        return;
+    }
+
+    m_streamer->addQuoteWaiter(symbol, std::move(fn));
+}
+
 // async api (mostly for interacting with the streamer)
 //
 // It is safe to call all these functions before the streamer starts. All these requests are queued.
@@ -410,6 +1296,24 @@ void Client::subscribeLevelOneEquities(const std::vector<std::string>& tickers,
     m_streamer->subscribeLevelOneEquities(tickers, fields);
 }
 
+void Client::subscribeLevelOneOptions(const std::vector<std::string>& contracts,
+                                      const std::vector<StreamerField::LevelOneOption>& fields)
+{
+    m_streamer->subscribeLevelOneOptions(contracts, fields);
+}
+
+void Client::subscribeLevelOneFutures(const std::vector<std::string>& futures,
+                                      const std::vector<StreamerField::LevelOneFutures>& fields)
+{
+    m_streamer->subscribeLevelOneFutures(futures, fields);
+}
+
+void Client::subscribeLevelOneForex(const std::vector<std::string>& pairs,
+                                    const std::vector<StreamerField::LevelOneForex>& fields)
+{
+    m_streamer->subscribeLevelOneForex(pairs, fields);
+}
+
 // -- Thread Safe Accessors
 std::vector<std::string>
 Client::getLinkedAccounts() const
@@ -459,8 +1363,8 @@ bool Client::loadTokens()
 
     LOG_DEBUG("Loading token cache...");
 
-    if (std::filesystem::exists(tokenCacheFile)) {
-        std::ifstream tokenCache(tokenCacheFile);
+    if (std::filesystem::exists(m_tokenCacheFile)) {
+        std::ifstream tokenCache(m_tokenCacheFile);
         if (tokenCache.good()) {
             json cachedData;
             tokenCache >> cachedData;
@@ -606,13 +1510,13 @@ bool Client::writeTokens(AccessTokenResponse responseData)
         result = true;
 
         // cache the tokens
-        std::ofstream tokenCache(tokenCacheFile, std::ofstream::trunc);
+        std::ofstream tokenCache(m_tokenCacheFile, std::ofstream::trunc);
         if (tokenCache.is_open()) {
             tokenCache << json(responseData).dump(4);
 
-            LOG_DEBUG("Tokens cached to {}.", tokenCacheFile);
+            LOG_DEBUG("Tokens cached to {}.", m_tokenCacheFile);
         } else {
-            LOG_ERROR("Unable to open {} for caching.", tokenCacheFile);
+            LOG_ERROR("Unable to open {} for caching.", m_tokenCacheFile);
         }
     } else {
         LOG_ERROR("Unable to get tokens. Error: {}, {}", responseData.error.error, responseData.error.description);
@@ -644,13 +1548,13 @@ bool Client::writeTokens(RefreshTokenResponse responseData)
         result = true;
 
         // cache the tokens
-        std::ofstream tokenCache(tokenCacheFile, std::ofstream::trunc);
+        std::ofstream tokenCache(m_tokenCacheFile, std::ofstream::trunc);
         if (tokenCache.is_open()) {
             tokenCache << json(responseData).dump(4);
 
-            LOG_DEBUG("Tokens cached to {}.", tokenCacheFile);
+            LOG_DEBUG("Tokens cached to {}.", m_tokenCacheFile);
         } else {
-            LOG_ERROR("Unable to open {} for caching.", tokenCacheFile);
+            LOG_ERROR("Unable to open {} for caching.", m_tokenCacheFile);
         }
     } else {
         LOG_ERROR("Unable to get access token. Error: {}, {}", responseData.error.error, responseData.error.description);
@@ -668,9 +1572,9 @@ void Client::getTokens(const std::string& grantType, const std::string& code, st
     // initialize to empty
     responseData = "{}";
 
-    // init curl
-    CURL* curl = curl_easy_init();
-    if (curl) {
+    // a pooled handle, the connection to the host is most likely still open
+    HttpHandlePool::Handle handle = m_context->httpHandles().acquire();
+    if (CURL* curl = handle.get()) {
         // set the url for the post request
         curl_easy_setopt(curl, CURLOPT_URL, __accessTokenURL.c_str());
 
@@ -703,9 +1607,8 @@ void Client::getTokens(const std::string& grantType, const std::string& code, st
             LOG_TRACE("Response data: {}", json::parse(responseData).dump(4));
         }
 
-        // cleanup
+        // cleanup (the handle goes back to the pool)
         curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
     }
 }
 
@@ -808,7 +1711,7 @@ void Client::updateLinkedAccounts()
 {
     std::string url = s_traderAPIBaseUrl + "/accounts/accountNumbers";
     try {
-        std::vector<json> accountNumbersData = json::parse(syncRequest(url));
+        std::vector<json> accountNumbersData = json::parse(syncRequest(url, {}, RateLimiter::Priority::High));
         {
             std::lock_guard lock(m_mutexLinkedAccounts);
             for (const auto& data : accountNumbersData) {
@@ -827,7 +1730,7 @@ void Client::updateUserPreference()
 {
     std::string url = s_traderAPIBaseUrl + "/userPreference";
     try {
-        auto data = json::parse(syncRequest(url));
+        auto data = json::parse(syncRequest(url, {}, RateLimiter::Priority::High));
         {
             std::lock_guard lock(m_mutexUserPreference);
             data.get_to(m_userPreference);
@@ -2,11 +2,24 @@
 #define __CLIENT_H__
 
 #include <string>
+#include <string_view>
 #include <mutex>
 #include <memory>
+#include <exception>
+#include <condition_variable>
+#include "schwabcpp/ioOptions.h"
+#include "schwabcpp/optionChain.h"
+#include "schwabcpp/accountState.h"
+#include "schwabcpp/positionTable.h"
+#include "schwabcpp/bulkFetch.h"
+#include "schwabcpp/candleStore.h"
+#include "schwabcpp/rateLimiter.h"
 #include "schwabcpp/streamerField.h"
+#include "schwabcpp/streamerData.h"
+#include "schwabcpp/streamerDispatcher.h"
 #include "schwabcpp/event/oAuthCompleteEvent.h"
 #include "schwabcpp/event/oAuthUrlRequestEvent.h"
+#include "schwabcpp/event/streamerGapEvent.h"
 #include "schwabcpp/schema/accessTokenResponse.h"
 #include "schwabcpp/schema/accountSummary.h"
 #include "schwabcpp/schema/candleList.h"
@@ -19,13 +32,25 @@
 #include "schwabcpp/utils/timer.h"
 #include "schwabcpp/utils/clock.h"
 
+// NOTE: boost is very heavy, maintain minimal include headers
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
 namespace spdlog {
 class logger;
 }
 
 namespace schwabcpp {
 
+namespace net = boost::asio;
+
 class Streamer;
+class ClientContext;
+class ClientPool;
+class ResponseCache;
 
 class Client
 {
@@ -36,7 +61,8 @@ public:
                                         Client(
                                             const std::string& key,
                                             const std::string& secret,
-                                            std::shared_ptr<spdlog::logger> logger
+                                            std::shared_ptr<spdlog::logger> logger,
+                                            const IoOptions& ioOptions = {}
                                         );
                                         ~Client();
 
@@ -54,10 +80,55 @@ public:
 
     void                                setStreamerDataHandler(std::function<void(const std::string&)> handler);
 
+    // Typed streamer data. The frames are decoded only for the symbols in the filter (all if empty)
+    // and only the fields in the mask are converted. Set these before starting the streamer.
+    void                                setStreamerLevelOneEquityHandler(std::function<void(const LevelOneEquityUpdate&)> handler);
+    void                                setStreamerSymbolFilter(const std::vector<std::string>& symbols);
+    void                                setStreamerLevelOneEquityFieldMask(const StreamerField::LevelOneEquityMask& mask);
+    void                                setStreamerLevelOneOptionHandler(std::function<void(const LevelOneOptionUpdate&)> handler);
+    void                                setStreamerLevelOneOptionFieldMask(const StreamerField::LevelOneOptionMask& mask);
+    void                                setStreamerLevelOneFuturesHandler(std::function<void(const LevelOneFuturesUpdate&)> handler);
+    void                                setStreamerLevelOneFuturesFieldMask(const StreamerField::LevelOneFuturesMask& mask);
+    void                                setStreamerLevelOneForexHandler(std::function<void(const LevelOneForexUpdate&)> handler);
+    void                                setStreamerLevelOneForexFieldMask(const StreamerField::LevelOneForexMask& mask);
+
+    // decode the prices as fixed point integers (FieldValue::asFixed) instead of doubles,
+    // with at most 9 decimals (more are clamped and logged)
+    void                                setStreamerFixedPointPrices(bool enabled, uint32_t decimals = 4);
+
+    // the id the typed updates carry for this symbol
+    SymbolId                            getStreamerSymbolId(const std::string& symbol);
+
+    // Runs the typed handlers on a pool of workers (0 -> on the io thread, the default).
+    // The updates of a symbol are still handled in order. Set it before starting the streamer,
+    // it is ignored (and logged) while the streamer runs.
+    void                                setStreamerDispatcherWorkers(size_t workers);
+    std::vector<StreamerDispatcher::WorkerStats>
+                                        getStreamerDispatcherStats() const;
+
+    // Keeps `state` current with the streamed account activity (ACCT_ACTIVITY) instead of polling:
+    // the orders are followed and their fills move the positions as they arrive. The positions of
+    // the linked accounts are reconciled with a rest snapshot right away (blocking) and after every
+    // reconnection of the streamer. `handler` (optional) runs on the io context thread once the
+    // event is applied to the state. Set it up before starting the streamer.
+    void                                trackAccountActivity(std::shared_ptr<AccountState> state,
+                                                             std::function<void(const AccountActivity&)> handler = {});
+
+    // Replaces the positions of the tracked state with a rest snapshot of every linked account
+    // (e.g. once it went `stale()`). Blocking, returns false if an account failed (still stale).
+    bool                                reconcileAccountState();
+
     // --- sync api --- (returns string response, user is responsible of parsing)
     using HttpRequestQueries = std::unordered_map<std::string, std::string>;
     AccountSummary                      accountSummary(const std::string& accountNumber) const;
     AccountsSummaryMap                  accountSummary() const;
+
+    // The positions of the account merged into `table` (keep it between the polls), returns what
+    // changed since its previous update (the revalued positions too with `revaluations`).
+    // The symbol ids are the ones of the streamed updates. Nothing changes if the request failed.
+    std::vector<PositionTable::Change>  updatePositions(const std::string& accountNumber,
+                                                        PositionTable& table,
+                                                        bool revaluations = false) const;
     CandleList                          priceHistory(const std::string& ticker,
                                                      PeriodType periodType,
                                                      int period,
@@ -69,9 +140,203 @@ public:
                                                      bool needPreviousClose) const;
     MarketHours                         marketHours(MarketType marketType, std::optional<clock::time_point> utc = std::nullopt) const;
 
+    // same as `priceHistory`, decoded into one array per field
+    CandleColumns                       priceHistoryColumns(const std::string& ticker,
+                                                            PeriodType periodType,
+                                                            int period,
+                                                            FrequencyType frequencyType,
+                                                            int frequency,
+                                                            std::optional<clock::time_point> start,
+                                                            std::optional<clock::time_point> end,
+                                                            bool needExtendedHoursData,
+                                                            bool needPreviousClose) const;
+
+    // The contracts of the symbol (calls and puts), `strikeCount` strikes around the money (all if not
+    // set) expiring within [fromDate, toDate] (days).
+    OptionChain                         optionChain(const std::string& symbol,
+                                                    std::optional<int> strikeCount = std::nullopt,
+                                                    std::optional<clock::time_point> fromDate = std::nullopt,
+                                                    std::optional<clock::time_point> toDate = std::nullopt) const;
+
+    // --- response cache ---
+    // The account summaries (a few seconds) and the market hours (an hour, the day is part of the
+    // request) are cached, sync and async api alike. Concurrent identical requests share one
+    // request and one parse.
+    void                                clearResponseCache();
+
+    // --- candle store ---
+    // With a store set, `priceHistory(Columns)` requests with a start date are served from disk. Only what
+    // the store doesn't cover yet is fetched (usually the tail since the last call) and stored.
+    // The previous close is not stored, the requests that need it always go to the api.
+    void                                setCandleStore(std::shared_ptr<CandleStore> store);
+
+    // --- rate limiting ---
+    // All the rest requests go through a token bucket (120 requests per minute and a burst of 10
+    // by default, the api limit is per app). Over budget, the requests wait their turn by priority
+    // instead of failing.
+    void                                setRateLimit(double requestsPerMinute, double burst);
+    RateLimiter::Stats                  getRateLimiterStats(RateLimiter::Priority priority) const;
+
+    // --- bulk api ---
+    // Fetches the price history of many symbols, the same parameters for all of them.
+    // Blocks until every symbol completed. The requests are multiplexed on the http engine, at most
+    // `options.maxConcurrency` in flight, at the bulk priority of the rate limiter.
+    // `onResult` is called as each symbol completes (in completion order, one at a time, from the
+    // rest pool), with the error if the symbol failed.
+    // Can be called from the io context (e.g. a streamer handler or a coroutine on `getExecutor()`),
+    // the io context is blocked meanwhile though: no streamed data and no async completions.
+    using PriceHistoryResultFn = std::function<void(const std::string&, std::exception_ptr, CandleList)>;
+    BulkFetchStats                      priceHistoryBulk(const std::vector<std::string>& tickers,
+                                                         PeriodType periodType,
+                                                         int period,
+                                                         FrequencyType frequencyType,
+                                                         int frequency,
+                                                         std::optional<clock::time_point> start,
+                                                         std::optional<clock::time_point> end,
+                                                         bool needExtendedHoursData,
+                                                         bool needPreviousClose,
+                                                         PriceHistoryResultFn onResult,
+                                                         const BulkFetchOptions& options = {});
+
+    // Quote snapshot of the symbols, as the same quotes the streamer delivers (the fields are
+    // converted like the streamed ones, all of them if `fields` is empty). Long lists are split in
+    // as few requests as the url allows, fetched concurrently. Invalid symbols are left out.
+    // Blocks, but can be called from the io context (e.g. a streamer handler with no dispatcher
+    // workers), no streamed data is handled meanwhile though.
+    std::vector<LevelOneEquityQuote>    quotes(const std::vector<std::string>& symbols,
+                                               const std::vector<StreamerField::LevelOneEquity>& fields = {});
+
+    // --- async api with completion tokens ---
+    // The completion signature is void(std::exception_ptr, Result). Defaults to coroutines:
+    //      CandleList candles = co_await client.priceHistoryAsync(...);
+    //      LevelOneEquityQuote quote = co_await client.nextQuote("AAPL");
+    // but callbacks, net::use_future, etc. work too.
+    // The requests are multiplexed by the http engine of the context (one thread for all of them),
+    // the responses are parsed on the rest pool and the completion runs on the executor associated
+    // with the token (the coroutine's), otherwise on the io context.
+    // Unlike the sync api, transport failures complete with an error instead of an empty result.
+    net::any_io_executor                getExecutor() const;
+
+    template <typename CompletionToken = net::use_awaitable_t<>>
+    auto                                accountSummaryAsync(const std::string& accountNumber, CompletionToken&& token = {})
+    {
+        return asyncRequest<AccountSummary>(
+            accountSummaryRequest(accountNumber),
+            &Client::parseAccountSummary,
+            std::forward<CompletionToken>(token)
+        );
+    }
+
+    // all the linked accounts
+    template <typename CompletionToken = net::use_awaitable_t<>>
+    auto                                accountSummariesAsync(CompletionToken&& token = {})
+    {
+        return asyncRequest<AccountsSummaryMap>(
+            accountSummaryRequest(),
+            &Client::parseAccountsSummaryMap,
+            std::forward<CompletionToken>(token)
+        );
+    }
+
+    template <typename CompletionToken = net::use_awaitable_t<>>
+    auto                                priceHistoryAsync(const std::string& ticker,
+                                                          PeriodType periodType,
+                                                          int period,
+                                                          FrequencyType frequencyType,
+                                                          int frequency,
+                                                          std::optional<clock::time_point> start,
+                                                          std::optional<clock::time_point> end,
+                                                          bool needExtendedHoursData,
+                                                          bool needPreviousClose,
+                                                          CompletionToken&& token = {})
+    {
+        return asyncRequest<CandleList>(
+            priceHistoryRequest(ticker, periodType, period, frequencyType, frequency,
+                                start, end, needExtendedHoursData, needPreviousClose),
+            &Client::parseCandleList,
+            std::forward<CompletionToken>(token)
+        );
+    }
+
+    template <typename CompletionToken = net::use_awaitable_t<>>
+    auto                                priceHistoryColumnsAsync(const std::string& ticker,
+                                                                 PeriodType periodType,
+                                                                 int period,
+                                                                 FrequencyType frequencyType,
+                                                                 int frequency,
+                                                                 std::optional<clock::time_point> start,
+                                                                 std::optional<clock::time_point> end,
+                                                                 bool needExtendedHoursData,
+                                                                 bool needPreviousClose,
+                                                                 CompletionToken&& token = {})
+    {
+        return asyncRequest<CandleColumns>(
+            priceHistoryRequest(ticker, periodType, period, frequencyType, frequency,
+                                start, end, needExtendedHoursData, needPreviousClose),
+            &Client::parseCandleColumns,
+            std::forward<CompletionToken>(token)
+        );
+    }
+
+    template <typename CompletionToken = net::use_awaitable_t<>>
+    auto                                optionChainAsync(const std::string& symbol,
+                                                         std::optional<int> strikeCount = std::nullopt,
+                                                         std::optional<clock::time_point> fromDate = std::nullopt,
+                                                         std::optional<clock::time_point> toDate = std::nullopt,
+                                                         CompletionToken&& token = {})
+    {
+        return asyncRequest<OptionChain>(
+            optionChainRequest(symbol, strikeCount, fromDate, toDate),
+            &Client::parseOptionChain,
+            std::forward<CompletionToken>(token)
+        );
+    }
+
+    template <typename CompletionToken = net::use_awaitable_t<>>
+    auto                                marketHoursAsync(MarketType marketType,
+                                                         std::optional<clock::time_point> utc = std::nullopt,
+                                                         CompletionToken&& token = {})
+    {
+        return asyncRequest<MarketHours>(
+            marketHoursRequest(marketType, utc),
+            [marketType](const std::string& response) { return parseMarketHours(response, marketType); },
+            std::forward<CompletionToken>(token)
+        );
+    }
+
+    // Completes with the next streamed update of the symbol. The symbol has to be subscribed.
+    // Fails with a std::runtime_error if the streamer stops first.
+    template <typename CompletionToken = net::use_awaitable_t<>>
+    auto                                nextQuote(const std::string& symbol, CompletionToken&& token = {})
+    {
+        return net::async_initiate<CompletionToken, void(std::exception_ptr, LevelOneEquityQuote)>(
+            [this](auto handler, const std::string& symbol) {
+                // the waiters are std::functions, the handler might be move only
+                auto sharedHandler = std::make_shared<decltype(handler)>(std::move(handler));
+                auto executor = net::get_associated_executor(*sharedHandler, getExecutor());
+                addQuoteWaiter(symbol, [sharedHandler, executor](std::exception_ptr error, LevelOneEquityQuote quote) {
+                    net::post(executor, [sharedHandler, error, quote = std::move(quote)]() mutable {
+                        (*sharedHandler)(error, std::move(quote));
+                    });
+                });
+            },
+            token,
+            symbol
+        );
+    }
+
     // --- async api --- (mostly for interacting with the streamer)
     void                                subscribeLevelOneEquities(const std::vector<std::string>& tickers,
                                                                   const std::vector<StreamerField::LevelOneEquity>& fields);
+    // the contracts are option symbols like "AAPL  240119C00190000" (see OptionChain)
+    void                                subscribeLevelOneOptions(const std::vector<std::string>& contracts,
+                                                                 const std::vector<StreamerField::LevelOneOption>& fields);
+    // futures like "/ES" (the active contract) or "/ESZ24"
+    void                                subscribeLevelOneFutures(const std::vector<std::string>& futures,
+                                                                 const std::vector<StreamerField::LevelOneFutures>& fields);
+    // currency pairs like "EUR/USD"
+    void                                subscribeLevelOneForex(const std::vector<std::string>& pairs,
+                                                               const std::vector<StreamerField::LevelOneForex>& fields);
 
     // --- getters to cached data, available if connection established (thread-safe)
     std::vector<std::string>            getLinkedAccounts() const;
@@ -96,6 +361,17 @@ private:
     // updates the token
     UpdateStatus                        updateTokens();
 
+    // --- Pooled Construction ---
+    // Used by the ClientPool. The client runs on the shared context, doesn't touch the
+    // global logger and leaves the token checking to the pool.
+    friend class ClientPool;
+                                        Client(
+                                            const std::string& key,
+                                            const std::string& secret,
+                                            std::shared_ptr<ClientContext> context,
+                                            const std::string& tokenCacheFile
+                                        );
+
     // --- Accessors for Streamer Class (Thread-Safe) ---
     friend class Streamer;
     std::string                         getAccessToken() const;
@@ -108,7 +384,146 @@ private:
     void                                updateLinkedAccounts();
     void                                updateUserPreference();
 
-    std::string                         syncRequest(std::string url, HttpRequestQueries queries = {}) const;
+    // response chunks, as they arrive
+    using DataFn = std::function<void(std::string_view)>;
+
+    // `succeeded` is set if the request went through and the status is not an error
+    // with `onData`, a successful response is handed over as it arrives instead of returned
+    std::string                         syncRequest(std::string url,
+                                                    HttpRequestQueries queries = {},
+                                                    RateLimiter::Priority priority = RateLimiter::Priority::Normal,
+                                                    bool* succeeded = nullptr,
+                                                    const DataFn& onData = nullptr) const;
+
+    // -- Requests and responses of the rest api (shared by the sync and async api)
+    struct RestRequest {
+        std::string                     url;
+        HttpRequestQueries              queries;
+        RateLimiter::Priority           priority = RateLimiter::Priority::Normal;
+        std::chrono::milliseconds       ttl{ 0 };   // cached for, 0 -> not cached
+    };
+    RestRequest                         accountSummaryRequest(const std::string& accountNumber) const;
+    RestRequest                         accountSummaryRequest() const;
+    RestRequest                         accountPositionsRequest(const std::string& accountNumber) const;
+    RestRequest                         priceHistoryRequest(const std::string& ticker,
+                                                            PeriodType periodType,
+                                                            int period,
+                                                            FrequencyType frequencyType,
+                                                            int frequency,
+                                                            std::optional<clock::time_point> start,
+                                                            std::optional<clock::time_point> end,
+                                                            bool needExtendedHoursData,
+                                                            bool needPreviousClose) const;
+    RestRequest                         marketHoursRequest(MarketType marketType, std::optional<clock::time_point> utc) const;
+    RestRequest                         optionChainRequest(const std::string& symbol,
+                                                           std::optional<int> strikeCount,
+                                                           std::optional<clock::time_point> fromDate,
+                                                           std::optional<clock::time_point> toDate) const;
+
+    static AccountSummary               parseAccountSummary(const std::string& response);
+    static AccountsSummaryMap           parseAccountsSummaryMap(const std::string& response);
+    static CandleList                   parseCandleList(const std::string& response);
+    static MarketHours                  parseMarketHours(const std::string& response, MarketType marketType);
+
+    static CandleColumns                parseCandleColumns(const std::string& response);
+    static OptionChain                  parseOptionChain(const std::string& response);
+
+    // price history (CandleList or CandleColumns) decoded while the response arrives,
+    // a failed request goes through `parse` like the other requests,
+    // or is an empty result with `succeeded` (as in `syncRequest`)
+    template <typename Result>
+    Result                              streamPriceHistory(const RestRequest& request,
+                                                           Result (*parse)(const std::string&),
+                                                           bool* succeeded = nullptr) const;
+
+    // the positions of a linked account (appended), false if the request failed
+    bool                                fetchPositions(const std::string& accountNumber, std::vector<Position>& positions) const;
+
+    // -- Candle Store
+    std::shared_ptr<CandleStore>        getCandleStore() const;
+    // the range of the stored series to serve, in epoch milliseconds (the end capped to now)
+    static std::pair<int64_t, int64_t>  storedRange(clock::time_point start, std::optional<clock::time_point> end);
+    // fetches what the series doesn't cover of [from, to] and stores it,
+    // nullopt if the series can't be served (nothing stored and the fetch or the store failed)
+    std::optional<CandleStore::Series>  updateStoredSeries(CandleStore& store,
+                                                           const std::string& ticker,
+                                                           PeriodType periodType,
+                                                           int period,
+                                                           FrequencyType frequencyType,
+                                                           int frequency,
+                                                           int64_t from,
+                                                           int64_t to,
+                                                           bool needExtendedHoursData) const;
+
+    // -- Cached Requests
+    // the parsed response, type erased (the request decides the type)
+    using ParsedResponse = std::shared_ptr<const void>;
+    using ParseFn = std::function<ParsedResponse(const std::string&)>;
+
+    // null if the request failed and is not cached
+    ParsedResponse                      fetch(RestRequest request, ParseFn parse) const;
+    void                                fetchAsync(RestRequest request,
+                                                   ParseFn parse,
+                                                   std::function<void(std::exception_ptr, ParsedResponse)> done);
+
+    template <typename Result>
+    Result                              cachedRequest(RestRequest request, std::function<Result(const std::string&)> parse) const
+    {
+        ParsedResponse parsed = fetch(std::move(request), [&parse](const std::string& response) -> ParsedResponse {
+            return std::make_shared<const Result>(parse(response));
+        });
+
+        // failed, same as the uncached requests: whatever the parser makes of the empty response
+        return parsed ? *std::static_pointer_cast<const Result>(parsed) : parse("{}");
+    }
+
+    // -- Completion Token Plumbing
+    // hands the request to the http engine, `done` runs on the rest pool with the body,
+    // the destructor waits for the pending ones
+    // with `onData`, a successful response is handed over as it arrives (on the engine thread)
+    // and `done` gets an empty body
+    void                                submitRequest(RestRequest request,
+                                                      std::function<void(std::exception_ptr, std::string)> done,
+                                                      DataFn onData = nullptr);
+    // Blocks until `done`, for the sync calls waiting on submitted requests. On the io context
+    // thread the rate limiter's timer can't fire meanwhile, the queued requests are released from here.
+    void                                waitForRequests(std::unique_lock<std::mutex>& lock,
+                                                        std::condition_variable& cv,
+                                                        const std::function<bool()>& done);
+    void                                addQuoteWaiter(const std::string& symbol,
+                                                       std::function<void(std::exception_ptr, LevelOneEquityQuote)> fn);
+
+    template <typename Result, typename CompletionToken>
+    auto                                asyncRequest(RestRequest request,
+                                                     std::function<Result(const std::string&)> parse,
+                                                     CompletionToken&& token)
+    {
+        return net::async_initiate<CompletionToken, void(std::exception_ptr, Result)>(
+            [this](auto handler, RestRequest request, std::function<Result(const std::string&)> parse) {
+                // the engine takes std::functions, the handler might be move only
+                auto sharedHandler = std::make_shared<decltype(handler)>(std::move(handler));
+                auto executor = net::get_associated_executor(*sharedHandler, getExecutor());
+                fetchAsync(
+                    std::move(request),
+                    [parse](const std::string& response) -> ParsedResponse {
+                        return std::make_shared<const Result>(parse(response));
+                    },
+                    [sharedHandler, executor](std::exception_ptr error, ParsedResponse parsed) {
+                        Result result{};
+                        if (!error && parsed) {
+                            result = *std::static_pointer_cast<const Result>(parsed);
+                        }
+                        net::post(executor, [sharedHandler, error, result = std::move(result)]() mutable {
+                            (*sharedHandler)(error, std::move(result));
+                        });
+                    }
+                );
+            },
+            token,
+            std::move(request),
+            std::move(parse)
+        );
+    }
 
 private:
     // --- active tokens ---
@@ -121,17 +536,33 @@ private:
     // --- app credentials ---
     std::string                         m_key;
     std::string                         m_secret;
+    std::string                         m_tokenCacheFile;
+
+    // --- shared resources (io context, http connection cache) ---
+    std::shared_ptr<ClientContext>      m_context;
+    std::shared_ptr<RateLimiter>        m_rateLimiter;  // shared, its timer outlives us
+    std::unique_ptr<ResponseCache>      m_responseCache;
+    std::shared_ptr<CandleStore>        m_candleStore;
+    bool                                m_pooled;
 
     // --- to protect access to members ---
     mutable std::mutex                  m_mutexTokens;
     mutable std::mutex                  m_mutexLinkedAccounts;
     mutable std::mutex                  m_mutexUserPreference;
+    mutable std::mutex                  m_mutexCandleStore;
+    mutable std::mutex                  m_mutexAccountState;
 
     // --- token checker daemon ---
     Timer                               m_tokenCheckerDaemon;
 
     // --- streamer ---
     std::unique_ptr<Streamer>           m_streamer;
+    std::shared_ptr<AccountState>       m_accountState;     // tracked from the account activity
+
+    // --- pending jobs of the async api ---
+    size_t                              m_pendingJobs;
+    std::mutex                          m_mutexPendingJobs;
+    std::condition_variable             m_cvPendingJobs;
 
     // --- event callback ---
     EventCallbackFn                     m_eventCallback;
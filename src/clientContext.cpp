@@ -0,0 +1,149 @@
+#include "clientContext.h"
+#include "utils/logger.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace schwabcpp {
+
+namespace {
+
+// the blocking rest calls of the async api run on these
+const static size_t s_restThreadCount = 4;
+
+}
+
+ClientContext::ClientContext(const IoOptions& ioOptions)
+    : m_ioOptions(ioOptions)
+    , m_sslContext(ssl::context::sslv23)
+    , m_workGuard(net::make_work_guard(m_ioContext))
+    , m_restPool(s_restThreadCount)
+    , m_httpShare(nullptr)
+{
+    // we are going to to a bunch of curl, init it here
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // share dns, tls sessions and connections between all the requests of this context
+    m_httpShare = curl_share_init();
+    if (m_httpShare) {
+        curl_share_setopt(m_httpShare, CURLSHOPT_LOCKFUNC, &ClientContext::lockHttpShare);
+        curl_share_setopt(m_httpShare, CURLSHOPT_UNLOCKFUNC, &ClientContext::unlockHttpShare);
+        curl_share_setopt(m_httpShare, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(m_httpShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_httpShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(m_httpShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    } else {
+        LOG_WARN("Unable to create curl share handle, requests will not share connections.");
+    }
+    m_httpHandles = std::make_unique<HttpHandlePool>(m_httpShare);
+    m_httpEngine = std::make_unique<HttpEngine>();
+
+    // ssl context settings
+    m_sslContext.set_verify_mode(ssl::verify_peer);
+    m_sslContext.load_verify_file("/etc/ssl/cert.pem");  // THIS IS REQUIRED
+
+    // run the io context
+    m_ioContextThread = std::thread(&ClientContext::runIoContext, this);
+}
+
+ClientContext::~ClientContext()
+{
+    // the engine hands its responses to the rest pool, stop it first (fails what is in flight)
+    LOG_TRACE("Stopping client context http engine...");
+    m_httpEngine.reset();
+
+    // the rest jobs post their completions to the io context, finish them first
+    LOG_TRACE("Stopping client context rest pool...");
+    m_restPool.join();
+
+    LOG_TRACE("Stopping client context io context...");
+    // not using boost::asio::io_context::stop so that the io context
+    // will wait for the pending disconnect calls to finish before exiting
+    m_workGuard.reset();
+    if (m_ioContextThread.joinable()) {
+        m_ioContextThread.join();
+    }
+
+    // curl cleanup (the handles first, they are attached to the share)
+    m_httpHandles.reset();
+    if (m_httpShare) {
+        curl_share_cleanup(m_httpShare);
+    }
+    curl_global_cleanup();
+}
+
+void ClientContext::runIoContext()
+{
+    if (m_ioOptions.ioThreadCpu >= 0) {
+        pinIoContextThread();
+    }
+
+    if (m_ioOptions.busyPoll) {
+        LOG_DEBUG("IO context thread busy polling. (spin before block: {} us)", m_ioOptions.spinBeforeBlock.count());
+        busyPollIoContext();
+    } else {
+        m_ioContext.run();
+    }
+
+    LOG_TRACE("IO context thread terminated.");
+}
+
+void ClientContext::busyPollIoContext()
+{
+    const bool blockWhenIdle = m_ioOptions.spinBeforeBlock.count() > 0;
+    auto lastWork = std::chrono::steady_clock::now();
+
+    // poll() and run_one() return once the work guard is gone and the work is done (stopped)
+    while (!m_ioContext.stopped()) {
+        if (m_ioContext.poll()) {
+            if (blockWhenIdle) {
+                lastWork = std::chrono::steady_clock::now();
+            }
+            continue;
+        }
+
+        if (blockWhenIdle && std::chrono::steady_clock::now() - lastWork > m_ioOptions.spinBeforeBlock) {
+            // been idle for a while, wait for the next event without burning the core
+            m_ioContext.run_one();
+            lastWork = std::chrono::steady_clock::now();
+            continue;
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+}
+
+void ClientContext::pinIoContextThread()
+{
+#ifdef __linux__
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(m_ioOptions.ioThreadCpu, &cpuSet);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+    if (result != 0) {
+        LOG_WARN("Unable to pin the io context thread to cpu {}. Error: {}", m_ioOptions.ioThreadCpu, result);
+    } else {
+        LOG_DEBUG("IO context thread pinned to cpu {}.", m_ioOptions.ioThreadCpu);
+    }
+#else
+    LOG_WARN("Pinning the io context thread is not supported on this platform.");
+#endif
+}
+
+void ClientContext::lockHttpShare(void*, int data, int, void* userptr)
+{
+    static_cast<ClientContext*>(userptr)->m_mutexHttpShare[data % 8].lock();
+}
+
+void ClientContext::unlockHttpShare(void*, int data, void* userptr)
+{
+    static_cast<ClientContext*>(userptr)->m_mutexHttpShare[data % 8].unlock();
+}
+
+}
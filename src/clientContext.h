@@ -0,0 +1,90 @@
+#ifndef __CLIENT_CONTEXT_H__
+#define __CLIENT_CONTEXT_H__
+
+#include <mutex>
+#include <thread>
+
+// NOTE: boost is very heavy, maintain minimal include headers
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/ssl/context.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <curl/curl.h>
+#include "ioOptions.h"
+#include "httpHandlePool.h"
+#include "httpEngine.h"
+
+namespace schwabcpp {
+
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+
+//
+// The resources that can be shared between clients.
+//
+// * A standalone `Client` creates its own context. A `ClientPool` creates one and hands it to every
+//   client it hosts so that all the logins run on one event loop and one http connection cache.
+//
+// * The io context thread is launched on construction and joined on destruction. Every websocket
+//   created with this context runs on that thread, nothing else spawns a thread per connection.
+//
+// * The async rest api multiplexes its requests on the http engine (one thread, http/2), the responses
+//   are parsed on a small thread pool and the completions are posted back to the executor of the
+//   caller (the io context by default).
+//
+// * The io options pick how the io context thread runs (blocking or busy polling, pinned or not)
+//   and how the websocket sockets are tuned.
+//
+class ClientContext
+{
+public:
+    explicit                                ClientContext(const IoOptions& ioOptions = {});
+                                            ~ClientContext();
+
+    net::io_context&                        ioContext() { return m_ioContext; }
+    ssl::context&                           sslContext() { return m_sslContext; }
+
+    net::thread_pool&                       restPool() { return m_restPool; }
+
+    const IoOptions&                        ioOptions() const { return m_ioOptions; }
+
+    // curl share handle for dns, tls session and connection cache
+    CURLSH*                                 httpShare() const { return m_httpShare; }
+
+    // reusable curl handles, already attached to the share handle
+    HttpHandlePool&                         httpHandles() { return *m_httpHandles; }
+
+    // concurrent requests of the async api
+    HttpEngine&                             httpEngine() { return *m_httpEngine; }
+
+private:
+    // -- io context thread body
+    void                                    runIoContext();
+    void                                    busyPollIoContext();
+    void                                    pinIoContextThread();
+
+    // -- curl share lock callbacks
+    static void                             lockHttpShare(void* handle, int data, int access, void* userptr);
+    static void                             unlockHttpShare(void* handle, int data, void* userptr);
+
+private:
+    IoOptions                               m_ioOptions;
+
+    net::io_context                         m_ioContext;
+    ssl::context                            m_sslContext;
+
+    net::executor_work_guard
+        <net::io_context::executor_type>    m_workGuard;
+    std::thread                             m_ioContextThread;
+
+    net::thread_pool                        m_restPool;
+
+    CURLSH*                                 m_httpShare;
+    std::mutex                              m_mutexHttpShare[8];  // one per curl_lock_data
+    std::unique_ptr<HttpHandlePool>         m_httpHandles;
+    std::unique_ptr<HttpEngine>             m_httpEngine;
+};
+
+}
+
+#endif
@@ -0,0 +1,237 @@
+#include "clientPool.h"
+#include "clientContext.h"
+#include "utils/logger.h"
+
+namespace schwabcpp {
+
+namespace {
+
+// same interval as the token checker of a standalone client
+const static std::chrono::seconds s_tokenCheckInterval(30);
+
+// resolution of the shared token checker
+const static std::chrono::seconds s_tokenCheckerTick(1);
+
+}
+
+ClientPool::ClientPool(std::shared_ptr<spdlog::logger> logger, const IoOptions& ioOptions)
+{
+    // create a logger unless one is already provided
+    if (logger) {
+        Logger::setLogger(logger);
+    } else {
+        // logger is not specified, create a default one with the provide log level
+        // if log level not specified, defaults to debug
+        Logger::init(spdlog::level::debug);
+    }
+
+    // the one and only context of the pool
+    m_context = std::make_shared<ClientContext>(ioOptions);
+
+    LOG_INFO("Schwab client pool initialized.");
+}
+
+ClientPool::~ClientPool()
+{
+    LOG_INFO("Stopping client pool...");
+
+    // stop the token checker daemon first, it calls into the clients
+    LOG_TRACE("Shutting down pool token checker daemon...");
+    m_tokenCheckerDaemon.stop();  // this blocks
+
+    // release the clients (this stops their streamers)
+    {
+        std::lock_guard lock(m_mutexEntries);
+        m_entries.clear();
+    }
+
+    // release the context (joins the io context thread and cleans up curl)
+    m_context.reset();
+
+    // now, we relase the logger
+    Logger::releaseLogger();
+}
+
+Client& ClientPool::addClient(const std::string& name, const std::string& key, const std::string& secret)
+{
+    std::lock_guard lock(m_mutexEntries);
+
+    for (const Entry& entry : m_entries) {
+        if (entry.name == name) {
+            LOG_WARN("Client {} already registered.", name);
+            return *entry.client;
+        }
+    }
+
+    // each login needs its own token cache
+    Entry entry;
+    entry.name = name;
+    entry.client = std::unique_ptr<Client>(new Client(key, secret, m_context, ".tokens." + name + ".json"));
+
+    // forward the events to the aggregated callback
+    entry.client->setEventCallback([this, name](Event& event) {
+        EventCallbackFn fn;
+        {
+            std::lock_guard lock(m_mutexCallbacks);
+            fn = m_eventCallback;
+        }
+        if (fn) {
+            fn(name, event);
+        }
+    });
+
+    m_entries.push_back(std::move(entry));
+
+    LOG_DEBUG("Client {} added to the pool.", name);
+
+    return *m_entries.back().client;
+}
+
+bool ClientPool::connect()
+{
+    bool result = true;
+
+    // collect the ones to connect, connecting might take a while (user input)
+    std::vector<std::pair<std::string, Client*>> pending;
+    {
+        std::lock_guard lock(m_mutexEntries);
+        for (const Entry& entry : m_entries) {
+            if (!entry.connected) {
+                pending.emplace_back(entry.name, entry.client.get());
+            }
+        }
+    }
+
+    for (auto& [name, client] : pending) {
+        LOG_INFO("Connecting client {}...", name);
+
+        bool connected = client->connect();
+        if (connected) {
+            // hook the streamer data to the aggregated handler
+            client->setStreamerDataHandler([this, name](const std::string& data) {
+                DataHandlerFn fn;
+                {
+                    std::lock_guard lock(m_mutexCallbacks);
+                    fn = m_dataHandler;
+                }
+                if (fn) {
+                    fn(name, data);
+                }
+            });
+        } else {
+            LOG_ERROR("Failed to connect client {}.", name);
+            result = false;
+        }
+
+        std::lock_guard lock(m_mutexEntries);
+        for (Entry& entry : m_entries) {
+            if (entry.name == name) {
+                entry.connected = connected;
+                break;
+            }
+        }
+    }
+
+    // spread the token checks evenly over the check interval
+    {
+        std::lock_guard lock(m_mutexEntries);
+        if (!m_entries.empty()) {
+            const clock::time_point now = clock::now();
+            const clock::duration slot = std::chrono::duration_cast<clock::duration>(s_tokenCheckInterval) / m_entries.size();
+            for (size_t i = 0; i < m_entries.size(); ++i) {
+                m_entries[i].nextTokenCheck = now + slot * static_cast<clock::rep>(i + 1);
+            }
+        }
+    }
+
+    // start the shared token checker daemon (restarts if already running)
+    LOG_DEBUG("Launching pool token checker daemon...");
+    m_tokenCheckerDaemon.start(
+        s_tokenCheckerTick,
+        std::bind(&ClientPool::checkTokens, this)
+    );
+
+    return result;
+}
+
+Client* ClientPool::getClient(const std::string& name) const
+{
+    std::lock_guard lock(m_mutexEntries);
+
+    for (const Entry& entry : m_entries) {
+        if (entry.name == name) {
+            return entry.client.get();
+        }
+    }
+
+    return nullptr;
+}
+
+std::vector<std::string> ClientPool::getClientNames() const
+{
+    std::lock_guard lock(m_mutexEntries);
+
+    std::vector<std::string> result;
+    for (const Entry& entry : m_entries) {
+        result.push_back(entry.name);
+    }
+    return result;
+}
+
+void ClientPool::setEventCallback(EventCallbackFn fn)
+{
+    std::lock_guard lock(m_mutexCallbacks);
+    m_eventCallback = fn;
+}
+
+void ClientPool::setStreamerDataHandler(DataHandlerFn fn)
+{
+    std::lock_guard lock(m_mutexCallbacks);
+    m_dataHandler = fn;
+}
+
+void ClientPool::startStreamers()
+{
+    std::lock_guard lock(m_mutexEntries);
+    for (Entry& entry : m_entries) {
+        if (entry.connected) {
+            entry.client->startStreamer();
+        }
+    }
+}
+
+void ClientPool::stopStreamers()
+{
+    std::lock_guard lock(m_mutexEntries);
+    for (Entry& entry : m_entries) {
+        if (entry.connected) {
+            entry.client->stopStreamer();
+        }
+    }
+}
+
+void ClientPool::checkTokens()
+{
+    // pick the clients whose slot has come
+    std::vector<Client*> due;
+    {
+        std::lock_guard lock(m_mutexEntries);
+        const clock::time_point now = clock::now();
+        for (Entry& entry : m_entries) {
+            if (entry.connected && entry.nextTokenCheck <= now) {
+                // keep the slot, don't drift
+                while (entry.nextTokenCheck <= now) {
+                    entry.nextTokenCheck += s_tokenCheckInterval;
+                }
+                due.push_back(entry.client.get());
+            }
+        }
+    }
+
+    // clients are only released after this daemon stopped
+    for (Client* client : due) {
+        client->checkTokensAndReauth();
+    }
+}
+
+} // namespace schwabcpp
@@ -0,0 +1,80 @@
+#ifndef __CLIENT_POOL_H__
+#define __CLIENT_POOL_H__
+
+#include "schwabcpp/client.h"
+#include <vector>
+
+namespace schwabcpp {
+
+//
+// Hosts several authenticated clients (one per schwab login) on shared resources.
+//
+// * All the clients run on one io context thread and share one http connection cache.
+//   Each client gets its own token cache file, derived from the name it is registered with.
+//
+// * The token checks of all the clients are driven by a single timer and staggered over the
+//   check interval, so the clients don't all hit the token endpoint at once.
+//
+// * Events and streamer data of every client are forwarded to one aggregated callback,
+//   tagged with the name of the client it came from.
+//
+// * Thread count does not depend on the number of clients.
+//
+class ClientPool
+{
+    using EventCallbackFn = std::function<void(const std::string&, Event&)>;
+    using DataHandlerFn = std::function<void(const std::string&, const std::string&)>;
+public:
+                                        ClientPool(std::shared_ptr<spdlog::logger> logger, const IoOptions& ioOptions = {});
+                                        ~ClientPool();
+
+    // Registers a login. The name identifies the client in the aggregated callbacks.
+    // Returns the existing client if the name is already registered.
+    Client&                             addClient(const std::string& name,
+                                                  const std::string& key,
+                                                  const std::string& secret);
+
+    // Connects the clients that are not connected yet (one after another, the oauth
+    // flow might need user input) and starts the shared token checker.
+    // Returns true if all the clients are connected.
+    bool                                connect();
+
+    // returns nullptr if not found
+    Client*                             getClient(const std::string& name) const;
+    std::vector<std::string>            getClientNames() const;
+
+    // --- aggregated callbacks ---
+    void                                setEventCallback(EventCallbackFn fn);
+    void                                setStreamerDataHandler(DataHandlerFn fn);
+
+    // --- streamer api (applies to all connected clients) ---
+    void                                startStreamers();
+    void                                stopStreamers();
+
+private:
+    // -- Token Checker Daemon's Job ---
+    void                                checkTokens();
+
+private:
+    struct Entry {
+        std::string                     name;
+        std::unique_ptr<Client>         client;
+        bool                            connected = false;
+        clock::time_point               nextTokenCheck;
+    };
+
+    std::shared_ptr<ClientContext>      m_context;
+
+    std::vector<Entry>                  m_entries;
+    mutable std::mutex                  m_mutexEntries;
+
+    EventCallbackFn                     m_eventCallback;
+    DataHandlerFn                       m_dataHandler;
+    mutable std::mutex                  m_mutexCallbacks;
+
+    Timer                               m_tokenCheckerDaemon;
+};
+
+} // namespace schwabcpp
+
+#endif // __CLIENT_POOL_H__
@@ -3,5 +3,6 @@
 
 #include "oAuthCompleteEvent.h"
 #include "oAuthUrlRequestEvent.h"
+#include "streamerGapEvent.h"
 
 #endif
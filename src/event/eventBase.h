@@ -10,6 +10,7 @@ enum class EventType
 {
     OAuthUrlRequest,
     OAuthComplete,
+    StreamerGap,
 };
 
 class Event
@@ -0,0 +1,48 @@
+#ifndef __STREAMER_GAP_EVENT_H__
+#define __STREAMER_GAP_EVENT_H__
+
+#include "eventBase.h"
+#include <chrono>
+
+namespace schwabcpp {
+
+//
+// Fired after the streamer recovered from a disconnection.
+//
+// * The gap duration is measured from the moment the receiver loop failed to the moment
+//   live data resumed. Every update within the gap is lost.
+//
+// * The stale symbols got reseeded with a rest quote snapshot before live data resumed.
+//   The recovery duration is the time it took to fetch and deliver the snapshot.
+//
+class StreamerGapEvent : public Event
+{
+public:
+    DEFINE_EVENT_CLASS(StreamerGap);
+
+    using Duration = std::chrono::steady_clock::duration;
+
+                                  StreamerGapEvent(Duration gap, Duration recovery, size_t staleSymbols, size_t recoveredSymbols)
+                                      : m_gap(gap)
+                                      , m_recovery(recovery)
+                                      , m_staleSymbols(staleSymbols)
+                                      , m_recoveredSymbols(recoveredSymbols)
+                                  {}
+
+    virtual                       ~StreamerGapEvent() {}
+
+    inline Duration               getGapDuration() const { return m_gap; }
+    inline Duration               getRecoveryDuration() const { return m_recovery; }
+    inline size_t                 getStaleSymbolCount() const { return m_staleSymbols; }
+    inline size_t                 getRecoveredSymbolCount() const { return m_recoveredSymbols; }
+
+private:
+    Duration                      m_gap;
+    Duration                      m_recovery;
+    size_t                        m_staleSymbols;
+    size_t                        m_recoveredSymbols;
+};
+
+} // namespace schwabcpp
+
+#endif
@@ -0,0 +1,229 @@
+#include "httpEngine.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace schwabcpp {
+
+namespace {
+
+// includes the time spent waiting for a free stream
+const static long s_requestTimeoutSeconds = 30;
+
+// a few connections per host, each multiplexing many streams
+const static long s_maxHostConnections = 4;
+
+// how long the engine thread sleeps in curl when there is nothing to do
+const static int s_pollTimeoutMs = 1000;
+
+// idle easy handles kept around (they keep their caches)
+const static size_t s_maxIdleHandles = 64;
+
+}
+
+HttpEngine::HttpEngine()
+    : m_multi(curl_multi_init())
+    , m_stopping(false)
+    , m_inFlight(0)
+{
+    if (!m_multi) {
+        LOG_ERROR("Unable to create curl multi handle, async requests will fail.");
+        return;
+    }
+
+    curl_multi_setopt(m_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(m_multi, CURLMOPT_MAX_HOST_CONNECTIONS, s_maxHostConnections);
+
+    m_thread = std::thread(&HttpEngine::run, this);
+}
+
+HttpEngine::~HttpEngine()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+
+    if (m_multi) {
+        curl_multi_wakeup(m_multi);
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    for (CURL* curl : m_idleHandles) {
+        curl_easy_cleanup(curl);
+    }
+    if (m_multi) {
+        curl_multi_cleanup(m_multi);
+    }
+}
+
+void HttpEngine::submit(Request request, DoneFn done)
+{
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = std::move(request);
+    transfer->done = std::move(done);
+
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_stopping && m_multi) {
+            m_submitted.push_back(std::move(transfer));
+            ++m_inFlight;
+        }
+    }
+
+    if (transfer) {
+        // not accepted
+        transfer->done(CURLE_ABORTED_BY_CALLBACK, 0, {});
+        return;
+    }
+
+    curl_multi_wakeup(m_multi);
+}
+
+void HttpEngine::run()
+{
+    LOG_TRACE("Http engine thread started.");
+
+    while (true) {
+        std::vector<std::unique_ptr<Transfer>> submitted;
+        bool stopping = false;
+        {
+            std::lock_guard lock(m_mutex);
+            submitted.swap(m_submitted);
+            stopping = m_stopping;
+        }
+
+        if (stopping) {
+            // fail everything we still have
+            for (auto& transfer : submitted) {
+                transfer->done(CURLE_ABORTED_BY_CALLBACK, 0, {});
+                --m_inFlight;
+            }
+            while (!m_active.empty()) {
+                finish(m_active.back().get(), CURLE_ABORTED_BY_CALLBACK);
+            }
+            break;
+        }
+
+        for (auto& transfer : submitted) {
+            start(std::move(transfer));
+        }
+
+        int running = 0;
+        curl_multi_perform(m_multi, &running);
+
+        // completions
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(m_multi, &queued)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            if (transfer) {
+                finish(transfer, message->data.result);
+            }
+        }
+
+        // sleep until there is socket activity, a timeout or a wakeup
+        curl_multi_poll(m_multi, nullptr, 0, s_pollTimeoutMs, nullptr);
+    }
+
+    LOG_TRACE("Http engine thread terminated.");
+}
+
+void HttpEngine::start(std::unique_ptr<Transfer> transfer)
+{
+    CURL* curl = nullptr;
+    if (!m_idleHandles.empty()) {
+        curl = m_idleHandles.back();
+        m_idleHandles.pop_back();
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+    }
+
+    if (!curl) {
+        LOG_ERROR("Unable to create curl handle.");
+        transfer->done(CURLE_FAILED_INIT, 0, {});
+        --m_inFlight;
+        return;
+    }
+
+    transfer->curl = curl;
+    for (const std::string& header : transfer->request.headers) {
+        transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, transfer->request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+    if (!transfer->request.postFields.empty()) {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->request.postFields.c_str());
+    }
+
+    // http/2, and rather wait for a stream on an existing connection than open a new one
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, s_requestTimeoutSeconds);
+
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &HttpEngine::writeCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer.get());
+
+    LOG_TRACE("Async request URL: {}", transfer->request.url);
+
+    curl_multi_add_handle(m_multi, curl);
+    m_active.push_back(std::move(transfer));
+}
+
+void HttpEngine::finish(Transfer* transfer, CURLcode result)
+{
+    long status = 0;
+    curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &status);
+
+    curl_multi_remove_handle(m_multi, transfer->curl);
+    curl_slist_free_all(transfer->headers);
+    transfer->headers = nullptr;
+
+    if (m_idleHandles.size() < s_maxIdleHandles) {
+        m_idleHandles.push_back(transfer->curl);
+    } else {
+        curl_easy_cleanup(transfer->curl);
+    }
+    transfer->curl = nullptr;
+
+    // take it out of the active list before calling back
+    auto it = std::find_if(m_active.begin(), m_active.end(), [transfer](const auto& active) { return active.get() == transfer; });
+    std::unique_ptr<Transfer> owned = std::move(*it);
+    m_active.erase(it);
+
+    if (result != CURLE_OK) {
+        LOG_ERROR("Async request to {} failed: {}", owned->request.url, curl_easy_strerror(result));
+    }
+
+    owned->done(result, status, std::move(owned->body));
+    --m_inFlight;
+}
+
+size_t HttpEngine::writeCallback(char* data, size_t size, size_t nmemb, void* userdata)
+{
+    size_t totalSize = size * nmemb;
+    Transfer* transfer = static_cast<Transfer*>(userdata);
+
+    if (transfer->request.onData) {
+        // the headers are in by now
+        long status = 0;
+        curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &status);
+        if (status < 400) {
+            transfer->request.onData(std::string_view(data, totalSize));
+            return totalSize;
+        }
+    }
+
+    transfer->body.append(data, totalSize);
+    return totalSize;
+}
+
+}
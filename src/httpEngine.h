@@ -0,0 +1,87 @@
+#ifndef __HTTP_ENGINE_H__
+#define __HTTP_ENGINE_H__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+
+namespace schwabcpp {
+
+//
+// Runs many http requests concurrently on one thread with curl multi.
+//
+// * The requests to the same host are multiplexed over a few http/2 connections (a transfer waits
+//   for a free stream instead of opening a new connection), so hundreds of requests can be in
+//   flight without a thread or a tls handshake each.
+//
+// * `submit(...)` is thread-safe and returns right away. The completion runs on the engine
+//   thread, keep it short (hand the body off to somewhere else).
+//
+// * A request can take its response as it arrives instead (`Request::onData`), e.g. to decode
+//   while the rest is still being received. The chunks are handed over on the engine thread too.
+//
+// * Destroying the engine fails the requests still in flight with CURLE_ABORTED_BY_CALLBACK.
+//
+class HttpEngine
+{
+public:
+    struct Request {
+        std::string                         url;
+        std::vector<std::string>            headers;
+        std::string                         postFields;  // GET if empty
+        // if set, a successful response is handed over chunk by chunk instead of collected
+        // (the body given to `done` is then empty), error responses are still collected
+        std::function<void(std::string_view)>
+                                            onData;
+    };
+
+    // (curl result, http status, body)
+    using DoneFn = std::function<void(CURLcode, long, std::string)>;
+
+                                            HttpEngine();
+                                            ~HttpEngine();
+
+    void                                    submit(Request request, DoneFn done);
+
+    size_t                                  inFlight() const { return m_inFlight; }
+
+private:
+    struct Transfer {
+        Request                             request;
+        DoneFn                              done;
+        CURL*                               curl = nullptr;
+        curl_slist*                         headers = nullptr;
+        std::string                         body;
+    };
+
+    void                                    run();
+    void                                    start(std::unique_ptr<Transfer> transfer);
+    void                                    finish(Transfer* transfer, CURLcode result);
+
+    static size_t                           writeCallback(char* data, size_t size, size_t nmemb, void* userdata);
+
+private:
+    CURLM*                                  m_multi;
+    std::thread                             m_thread;
+
+    // -- submitted, not yet added to the multi handle
+    std::vector<std::unique_ptr<Transfer>>  m_submitted;
+    bool                                    m_stopping;
+    std::mutex                              m_mutex;
+
+    // -- engine thread only
+    std::vector<std::unique_ptr<Transfer>>  m_active;
+    std::vector<CURL*>                      m_idleHandles;
+
+    std::atomic<size_t>                     m_inFlight;
+};
+
+}
+
+#endif
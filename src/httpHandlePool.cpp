@@ -0,0 +1,100 @@
+#include "httpHandlePool.h"
+#include "utils/logger.h"
+
+namespace schwabcpp {
+
+HttpHandlePool::HttpHandlePool(CURLSH* share, size_t maxIdle)
+    : m_share(share)
+    , m_maxIdle(maxIdle)
+{
+}
+
+HttpHandlePool::~HttpHandlePool()
+{
+    // every handle is supposed to be back by now
+    std::lock_guard lock(m_mutex);
+    for (CURL* curl : m_idle) {
+        curl_easy_cleanup(curl);
+    }
+    m_idle.clear();
+}
+
+HttpHandlePool::Handle HttpHandlePool::acquire()
+{
+    CURL* curl = nullptr;
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_idle.empty()) {
+            curl = m_idle.back();
+            m_idle.pop_back();
+        }
+    }
+
+    if (curl) {
+        // clears the options but keeps the connections and caches
+        curl_easy_reset(curl);
+    } else {
+        curl = curl_easy_init();
+        if (!curl) {
+            LOG_ERROR("Unable to create curl handle.");
+            return Handle();
+        }
+    }
+
+    // share dns, tls sessions and connections with the other requests of the context
+    if (m_share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+    }
+
+    // keep the connections alive between the requests
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+
+    return Handle(this, curl);
+}
+
+void HttpHandlePool::release(CURL* curl)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_idle.size() < m_maxIdle) {
+            m_idle.push_back(curl);
+            return;
+        }
+    }
+
+    curl_easy_cleanup(curl);
+}
+
+// -- Handle
+HttpHandlePool::Handle::Handle(Handle&& other) noexcept
+    : m_pool(other.m_pool)
+    , m_curl(other.m_curl)
+{
+    other.m_pool = nullptr;
+    other.m_curl = nullptr;
+}
+
+HttpHandlePool::Handle& HttpHandlePool::Handle::operator=(Handle&& other) noexcept
+{
+    if (this != &other) {
+        if (m_curl) {
+            m_pool->release(m_curl);
+        }
+        m_pool = other.m_pool;
+        m_curl = other.m_curl;
+        other.m_pool = nullptr;
+        other.m_curl = nullptr;
+    }
+    return *this;
+}
+
+HttpHandlePool::Handle::~Handle()
+{
+    if (m_curl) {
+        m_pool->release(m_curl);
+    }
+}
+
+}
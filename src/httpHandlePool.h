@@ -0,0 +1,59 @@
+#ifndef __HTTP_HANDLE_POOL_H__
+#define __HTTP_HANDLE_POOL_H__
+
+#include <mutex>
+#include <vector>
+#include <curl/curl.h>
+
+namespace schwabcpp {
+
+//
+// Keeps the curl easy handles around between requests instead of init/cleanup every time.
+//
+// * A handle comes out reset (no options from the previous request) but attached to the
+//   share handle of the context and with tcp keep-alive on, so the connections, tls sessions and
+//   dns entries cached by curl are reused by the next request to the same host.
+//
+// * The handle goes back to the pool when the `Handle` goes out of scope. At most `maxIdle`
+//   handles are kept, the rest are cleaned up. (Thread-Safe)
+//
+class HttpHandlePool
+{
+public:
+    class Handle {
+    public:
+                                            Handle() : m_pool(nullptr), m_curl(nullptr) {}
+                                            Handle(HttpHandlePool* pool, CURL* curl) : m_pool(pool), m_curl(curl) {}
+                                            Handle(Handle&& other) noexcept;
+        Handle&                             operator=(Handle&& other) noexcept;
+                                            Handle(const Handle&) = delete;
+        Handle&                             operator=(const Handle&) = delete;
+                                            ~Handle();
+
+        CURL*                               get() const { return m_curl; }
+        explicit                            operator bool() const { return m_curl != nullptr; }
+
+    private:
+        HttpHandlePool*                     m_pool;
+        CURL*                               m_curl;
+    };
+
+    explicit                                HttpHandlePool(CURLSH* share, size_t maxIdle = 16);
+                                            ~HttpHandlePool();
+
+    // the handle is empty if curl couldn't create one
+    Handle                                  acquire();
+
+private:
+    void                                    release(CURL* curl);
+
+private:
+    CURLSH*                                 m_share;
+    size_t                                  m_maxIdle;
+    std::vector<CURL*>                      m_idle;
+    std::mutex                              m_mutex;
+};
+
+}
+
+#endif
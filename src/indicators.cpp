@@ -0,0 +1,601 @@
+#include "indicators.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCHWABCPP_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace schwabcpp {
+
+namespace {
+
+const static double s_nan = std::numeric_limits<double>::quiet_NaN();
+
+// The windowed sums are differences of prefix sums, restarted every block (and shifted by the
+// first value of the block) so the sums stay small and the differences precise.
+const static size_t s_windowBlockSize = 1024;
+
+// The recursive indicators run the kernel on a block at a time, the block stays in the cache
+// for the sequential pass over it.
+const static size_t s_recursiveBlockSize = 1024;
+
+//
+// The kernels work on [begin, end). The windowed ones take prefix sums (prefix[i] is the sum of
+// the first i values minus `shift`) and need begin >= period - 1.
+// The ones looking at the previous candle need begin >= 1.
+//
+struct Kernels {
+    Indicators::Isa isa;
+
+    void (*windowMean)(const double* prefix, size_t period, double shift, double* out, size_t begin, size_t end);
+    void (*bands)(const double* prefix, const double* prefixSquares, size_t period, double shift, double deviations,
+                  double* middle, double* upper, double* lower, size_t begin, size_t end);
+    void (*trueRange)(const double* high, const double* low, const double* close, double* out, size_t begin, size_t end);
+    void (*moves)(const double* close, double* up, double* down, size_t begin, size_t end);
+    void (*typicalVolume)(const double* high, const double* low, const double* close, const int64_t* volume,
+                          double* out, size_t begin, size_t end);
+};
+
+// -- scalar kernels
+
+void windowMeanScalar(const double* prefix, size_t period, double shift, double* out, size_t begin, size_t end)
+{
+    const double scale = 1.0 / period;
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = (prefix[i + 1] - prefix[i + 1 - period]) * scale + shift;
+    }
+}
+
+void bandsScalar(const double* prefix, const double* prefixSquares, size_t period, double shift, double deviations,
+                 double* middle, double* upper, double* lower, size_t begin, size_t end)
+{
+    const double scale = 1.0 / period;
+    for (size_t i = begin; i < end; ++i) {
+        const double mean = (prefix[i + 1] - prefix[i + 1 - period]) * scale;
+        const double variance = std::max((prefixSquares[i + 1] - prefixSquares[i + 1 - period]) * scale - mean * mean, 0.0);
+        const double width = deviations * std::sqrt(variance);
+        middle[i] = mean + shift;
+        upper[i] = middle[i] + width;
+        lower[i] = middle[i] - width;
+    }
+}
+
+void trueRangeScalar(const double* high, const double* low, const double* close, double* out, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = std::max({ high[i] - low[i], std::abs(high[i] - close[i - 1]), std::abs(low[i] - close[i - 1]) });
+    }
+}
+
+void movesScalar(const double* close, double* up, double* down, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; ++i) {
+        const double move = close[i] - close[i - 1];
+        up[i] = std::max(move, 0.0);
+        down[i] = std::max(-move, 0.0);
+    }
+}
+
+void typicalVolumeScalar(const double* high, const double* low, const double* close, const int64_t* volume,
+                         double* out, size_t begin, size_t end)
+{
+    const double third = 1.0 / 3.0;
+    for (size_t i = begin; i < end; ++i) {
+        out[i] = (high[i] + low[i] + close[i]) * third * static_cast<double>(volume[i]);
+    }
+}
+
+const static Kernels s_scalarKernels = {
+    Indicators::Isa::Scalar,
+    &windowMeanScalar,
+    &bandsScalar,
+    &trueRangeScalar,
+    &movesScalar,
+    &typicalVolumeScalar,
+};
+
+#ifdef SCHWABCPP_X86_KERNELS
+
+// int64 -> double for 0 <= value < 2^52: put the value in the mantissa of 2^52 and subtract 2^52
+const static int64_t s_exponentBits = 0x4330000000000000LL;
+const static double s_twoPow52 = 4503599627370496.0;
+
+// -- sse4 kernels
+
+__attribute__((target("sse4.1")))
+void windowMeanSse4(const double* prefix, size_t period, double shift, double* out, size_t begin, size_t end)
+{
+    const __m128d scale = _mm_set1_pd(1.0 / period);
+    const __m128d offset = _mm_set1_pd(shift);
+
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m128d sum = _mm_sub_pd(_mm_loadu_pd(prefix + i + 1), _mm_loadu_pd(prefix + i + 1 - period));
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(sum, scale), offset));
+    }
+    windowMeanScalar(prefix, period, shift, out, i, end);
+}
+
+__attribute__((target("sse4.1")))
+void bandsSse4(const double* prefix, const double* prefixSquares, size_t period, double shift, double deviations,
+               double* middle, double* upper, double* lower, size_t begin, size_t end)
+{
+    const __m128d scale = _mm_set1_pd(1.0 / period);
+    const __m128d offset = _mm_set1_pd(shift);
+    const __m128d k = _mm_set1_pd(deviations);
+    const __m128d zero = _mm_setzero_pd();
+
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m128d mean = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(prefix + i + 1), _mm_loadu_pd(prefix + i + 1 - period)), scale);
+        __m128d meanSquares = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(prefixSquares + i + 1), _mm_loadu_pd(prefixSquares + i + 1 - period)), scale);
+        __m128d variance = _mm_max_pd(_mm_sub_pd(meanSquares, _mm_mul_pd(mean, mean)), zero);
+        __m128d width = _mm_mul_pd(k, _mm_sqrt_pd(variance));
+        __m128d mid = _mm_add_pd(mean, offset);
+        _mm_storeu_pd(middle + i, mid);
+        _mm_storeu_pd(upper + i, _mm_add_pd(mid, width));
+        _mm_storeu_pd(lower + i, _mm_sub_pd(mid, width));
+    }
+    bandsScalar(prefix, prefixSquares, period, shift, deviations, middle, upper, lower, i, end);
+}
+
+__attribute__((target("sse4.1")))
+void trueRangeSse4(const double* high, const double* low, const double* close, double* out, size_t begin, size_t end)
+{
+    const __m128d sign = _mm_set1_pd(-0.0);
+
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m128d h = _mm_loadu_pd(high + i);
+        __m128d l = _mm_loadu_pd(low + i);
+        __m128d previous = _mm_loadu_pd(close + i - 1);
+        __m128d range = _mm_sub_pd(h, l);
+        __m128d fromHigh = _mm_andnot_pd(sign, _mm_sub_pd(h, previous));
+        __m128d fromLow = _mm_andnot_pd(sign, _mm_sub_pd(l, previous));
+        _mm_storeu_pd(out + i, _mm_max_pd(range, _mm_max_pd(fromHigh, fromLow)));
+    }
+    trueRangeScalar(high, low, close, out, i, end);
+}
+
+__attribute__((target("sse4.1")))
+void movesSse4(const double* close, double* up, double* down, size_t begin, size_t end)
+{
+    const __m128d zero = _mm_setzero_pd();
+
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m128d move = _mm_sub_pd(_mm_loadu_pd(close + i), _mm_loadu_pd(close + i - 1));
+        _mm_storeu_pd(up + i, _mm_max_pd(move, zero));
+        _mm_storeu_pd(down + i, _mm_max_pd(_mm_sub_pd(zero, move), zero));
+    }
+    movesScalar(close, up, down, i, end);
+}
+
+__attribute__((target("sse4.1")))
+void typicalVolumeSse4(const double* high, const double* low, const double* close, const int64_t* volume,
+                       double* out, size_t begin, size_t end)
+{
+    const __m128d third = _mm_set1_pd(1.0 / 3.0);
+    const __m128i exponent = _mm_set1_epi64x(s_exponentBits);
+    const __m128d bias = _mm_set1_pd(s_twoPow52);
+
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2) {
+        __m128d typical = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_loadu_pd(high + i), _mm_loadu_pd(low + i)), _mm_loadu_pd(close + i)), third);
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(volume + i));
+        __m128d v2 = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(v, exponent)), bias);
+        _mm_storeu_pd(out + i, _mm_mul_pd(typical, v2));
+    }
+    typicalVolumeScalar(high, low, close, volume, out, i, end);
+}
+
+const static Kernels s_sse4Kernels = {
+    Indicators::Isa::Sse4,
+    &windowMeanSse4,
+    &bandsSse4,
+    &trueRangeSse4,
+    &movesSse4,
+    &typicalVolumeSse4,
+};
+
+// -- avx2 kernels
+
+__attribute__((target("avx2")))
+void windowMeanAvx2(const double* prefix, size_t period, double shift, double* out, size_t begin, size_t end)
+{
+    const __m256d scale = _mm256_set1_pd(1.0 / period);
+    const __m256d offset = _mm256_set1_pd(shift);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d sum = _mm256_sub_pd(_mm256_loadu_pd(prefix + i + 1), _mm256_loadu_pd(prefix + i + 1 - period));
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(sum, scale), offset));
+    }
+    windowMeanScalar(prefix, period, shift, out, i, end);
+}
+
+__attribute__((target("avx2")))
+void bandsAvx2(const double* prefix, const double* prefixSquares, size_t period, double shift, double deviations,
+               double* middle, double* upper, double* lower, size_t begin, size_t end)
+{
+    const __m256d scale = _mm256_set1_pd(1.0 / period);
+    const __m256d offset = _mm256_set1_pd(shift);
+    const __m256d k = _mm256_set1_pd(deviations);
+    const __m256d zero = _mm256_setzero_pd();
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d mean = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(prefix + i + 1), _mm256_loadu_pd(prefix + i + 1 - period)), scale);
+        __m256d meanSquares = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(prefixSquares + i + 1), _mm256_loadu_pd(prefixSquares + i + 1 - period)), scale);
+        __m256d variance = _mm256_max_pd(_mm256_sub_pd(meanSquares, _mm256_mul_pd(mean, mean)), zero);
+        __m256d width = _mm256_mul_pd(k, _mm256_sqrt_pd(variance));
+        __m256d mid = _mm256_add_pd(mean, offset);
+        _mm256_storeu_pd(middle + i, mid);
+        _mm256_storeu_pd(upper + i, _mm256_add_pd(mid, width));
+        _mm256_storeu_pd(lower + i, _mm256_sub_pd(mid, width));
+    }
+    bandsScalar(prefix, prefixSquares, period, shift, deviations, middle, upper, lower, i, end);
+}
+
+__attribute__((target("avx2")))
+void trueRangeAvx2(const double* high, const double* low, const double* close, double* out, size_t begin, size_t end)
+{
+    const __m256d sign = _mm256_set1_pd(-0.0);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d h = _mm256_loadu_pd(high + i);
+        __m256d l = _mm256_loadu_pd(low + i);
+        __m256d previous = _mm256_loadu_pd(close + i - 1);
+        __m256d range = _mm256_sub_pd(h, l);
+        __m256d fromHigh = _mm256_andnot_pd(sign, _mm256_sub_pd(h, previous));
+        __m256d fromLow = _mm256_andnot_pd(sign, _mm256_sub_pd(l, previous));
+        _mm256_storeu_pd(out + i, _mm256_max_pd(range, _mm256_max_pd(fromHigh, fromLow)));
+    }
+    trueRangeScalar(high, low, close, out, i, end);
+}
+
+__attribute__((target("avx2")))
+void movesAvx2(const double* close, double* up, double* down, size_t begin, size_t end)
+{
+    const __m256d zero = _mm256_setzero_pd();
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d move = _mm256_sub_pd(_mm256_loadu_pd(close + i), _mm256_loadu_pd(close + i - 1));
+        _mm256_storeu_pd(up + i, _mm256_max_pd(move, zero));
+        _mm256_storeu_pd(down + i, _mm256_max_pd(_mm256_sub_pd(zero, move), zero));
+    }
+    movesScalar(close, up, down, i, end);
+}
+
+__attribute__((target("avx2")))
+void typicalVolumeAvx2(const double* high, const double* low, const double* close, const int64_t* volume,
+                       double* out, size_t begin, size_t end)
+{
+    const __m256d third = _mm256_set1_pd(1.0 / 3.0);
+    const __m256i exponent = _mm256_set1_epi64x(s_exponentBits);
+    const __m256d bias = _mm256_set1_pd(s_twoPow52);
+
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m256d typical = _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(high + i), _mm256_loadu_pd(low + i)), _mm256_loadu_pd(close + i)), third);
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(volume + i));
+        __m256d v4 = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(v, exponent)), bias);
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(typical, v4));
+    }
+    typicalVolumeScalar(high, low, close, volume, out, i, end);
+}
+
+const static Kernels s_avx2Kernels = {
+    Indicators::Isa::Avx2,
+    &windowMeanAvx2,
+    &bandsAvx2,
+    &trueRangeAvx2,
+    &movesAvx2,
+    &typicalVolumeAvx2,
+};
+
+#endif // SCHWABCPP_X86_KERNELS
+
+// -- dispatch
+
+const Kernels& kernelsFor(Indicators::Isa isa)
+{
+    switch (isa) {
+#ifdef SCHWABCPP_X86_KERNELS
+        case Indicators::Isa::Avx2: return s_avx2Kernels;
+        case Indicators::Isa::Sse4: return s_sse4Kernels;
+#endif
+        default: return s_scalarKernels;
+    }
+}
+
+Indicators::Isa detectIsa()
+{
+#ifdef SCHWABCPP_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Indicators::Isa::Avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Indicators::Isa::Sse4;
+    }
+#endif
+    return Indicators::Isa::Scalar;
+}
+
+std::atomic<const Kernels*> s_kernels{ nullptr };
+
+const Kernels& kernels()
+{
+    const Kernels* current = s_kernels.load(std::memory_order_acquire);
+    if (!current) {
+        current = &kernelsFor(detectIsa());
+        s_kernels.store(current, std::memory_order_release);
+    }
+    return *current;
+}
+
+// -- scratch space, reused by the calls of a thread
+
+std::vector<double>& scratch(int index, size_t size)
+{
+    thread_local std::vector<double> buffers[2];
+    buffers[index].resize(size);
+    return buffers[index];
+}
+
+// Calls `fn(start, count, shift)` for each block of windows: the windows ending in
+// [start + period - 1, start + count), over the values [start, start + count).
+template <typename Fn>
+void forEachWindowBlock(std::span<const double> values, size_t period, Fn&& fn)
+{
+    for (size_t end = period - 1; end < values.size(); end += s_windowBlockSize) {
+        const size_t start = end - (period - 1);
+        const size_t count = std::min(end + s_windowBlockSize, values.size()) - start;
+        fn(start, count, values[start]);
+    }
+}
+
+void fillWarmup(std::span<double> out, size_t count)
+{
+    std::fill(out.begin(), out.begin() + std::min(count, out.size()), s_nan);
+}
+
+}
+
+namespace Indicators {
+
+const char* toString(Isa isa)
+{
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse4: return "sse4";
+        case Isa::Avx2: return "avx2";
+    }
+
+    return "BAD ISA";
+}
+
+Isa supportedIsa()
+{
+    const static Isa isa = detectIsa();
+    return isa;
+}
+
+Isa activeIsa()
+{
+    return kernels().isa;
+}
+
+Isa setIsa(Isa isa)
+{
+    isa = std::min(isa, supportedIsa());
+    s_kernels.store(&kernelsFor(isa), std::memory_order_release);
+    return isa;
+}
+
+void sma(std::span<const double> values, size_t period, std::span<double> out)
+{
+    const size_t n = std::min(values.size(), out.size());
+    if (period == 0 || n < period) {
+        fillWarmup(out, n);
+        return;
+    }
+
+    const Kernels& kernel = kernels();
+    std::vector<double>& prefix = scratch(0, period + s_windowBlockSize);
+
+    fillWarmup(out, period - 1);
+    forEachWindowBlock(values.first(n), period, [&](size_t start, size_t count, double shift) {
+        prefix[0] = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            prefix[i + 1] = prefix[i] + (values[start + i] - shift);
+        }
+        kernel.windowMean(prefix.data(), period, shift, out.data() + start, period - 1, count);
+    });
+}
+
+void ema(std::span<const double> values, size_t period, std::span<double> out)
+{
+    const size_t n = std::min(values.size(), out.size());
+    if (period == 0 || n < period) {
+        fillWarmup(out, n);
+        return;
+    }
+
+    // seeded with the sma of the first period
+    double average = 0.0;
+    for (size_t i = 0; i < period; ++i) {
+        average += values[i];
+    }
+    average /= period;
+
+    fillWarmup(out, period - 1);
+    out[period - 1] = average;
+
+    const double alpha = 2.0 / (period + 1);
+    for (size_t i = period; i < n; ++i) {
+        average += alpha * (values[i] - average);
+        out[i] = average;
+    }
+}
+
+void vwap(const CandleColumnsView& candles, std::span<double> out)
+{
+    const size_t n = std::min(candles.size(), out.size());
+    if (n == 0) {
+        return;
+    }
+
+    const Kernels& kernel = kernels();
+    std::vector<double>& priceVolume = scratch(0, s_recursiveBlockSize);
+
+    double totalPriceVolume = 0.0;
+    double totalVolume = 0.0;
+    for (size_t start = 0; start < n; start += s_recursiveBlockSize) {
+        const size_t count = std::min(s_recursiveBlockSize, n - start);
+        kernel.typicalVolume(candles.high.data() + start, candles.low.data() + start, candles.close.data() + start,
+                             candles.volume.data() + start, priceVolume.data(), 0, count);
+
+        for (size_t i = 0; i < count; ++i) {
+            totalPriceVolume += priceVolume[i];
+            totalVolume += static_cast<double>(candles.volume[start + i]);
+            out[start + i] = totalVolume > 0.0 ? totalPriceVolume / totalVolume : s_nan;
+        }
+    }
+}
+
+void atr(const CandleColumnsView& candles, size_t period, std::span<double> out)
+{
+    const size_t n = std::min(candles.size(), out.size());
+    if (period == 0 || n < period) {
+        fillWarmup(out, n);
+        return;
+    }
+
+    const Kernels& kernel = kernels();
+    std::vector<double>& trueRange = scratch(0, s_recursiveBlockSize);
+
+    fillWarmup(out, period - 1);
+
+    // the first period averages the true ranges, Wilder's smoothing after that (multiplied by the
+    // weights, a division would be the latency of every step)
+    const double keep = (period - 1.0) / period;
+    const double weight = 1.0 / period;
+    double average = 0.0;
+    for (size_t start = 0; start < n; start += s_recursiveBlockSize) {
+        const size_t count = std::min(s_recursiveBlockSize, n - start);
+        // the block starts at the candle `start`, the kernel looks at the close before it
+        if (start == 0) {
+            trueRange[0] = candles.high[0] - candles.low[0];
+        }
+        kernel.trueRange(candles.high.data() + start, candles.low.data() + start, candles.close.data() + start,
+                         trueRange.data(), start == 0 ? 1 : 0, count);
+
+        for (size_t k = 0; k < count; ++k) {
+            const size_t i = start + k;
+            if (i < period) {
+                average += trueRange[k];
+                if (i == period - 1) {
+                    average /= period;
+                    out[i] = average;
+                }
+            } else {
+                average = average * keep + trueRange[k] * weight;
+                out[i] = average;
+            }
+        }
+    }
+}
+
+void rsi(std::span<const double> closes, size_t period, std::span<double> out)
+{
+    const size_t n = std::min(closes.size(), out.size());
+    if (period == 0 || n <= period) {
+        fillWarmup(out, n);
+        return;
+    }
+
+    const Kernels& kernel = kernels();
+    std::vector<double>& up = scratch(0, s_recursiveBlockSize);
+    std::vector<double>& down = scratch(1, s_recursiveBlockSize);
+
+    auto toRsi = [](double gain, double loss) {
+        return loss == 0.0 ? 100.0 : 100.0 - 100.0 / (1.0 + gain / loss);
+    };
+
+    fillWarmup(out, period);
+
+    // the first period averages the moves, Wilder's smoothing after that (see `atr`)
+    const double keep = (period - 1.0) / period;
+    const double weight = 1.0 / period;
+    double gain = 0.0;
+    double loss = 0.0;
+    for (size_t start = 1; start < n; start += s_recursiveBlockSize) {
+        const size_t count = std::min(s_recursiveBlockSize, n - start);
+        // the kernel looks at the close before the block
+        kernel.moves(closes.data() + start, up.data(), down.data(), 0, count);
+
+        for (size_t k = 0; k < count; ++k) {
+            const size_t i = start + k;
+            if (i <= period) {
+                gain += up[k];
+                loss += down[k];
+                if (i == period) {
+                    gain /= period;
+                    loss /= period;
+                    out[i] = toRsi(gain, loss);
+                }
+            } else {
+                gain = gain * keep + up[k] * weight;
+                loss = loss * keep + down[k] * weight;
+                out[i] = toRsi(gain, loss);
+            }
+        }
+    }
+}
+
+void bollinger(std::span<const double> values,
+               size_t period,
+               double deviations,
+               std::span<double> middle,
+               std::span<double> upper,
+               std::span<double> lower)
+{
+    const size_t n = std::min({ values.size(), middle.size(), upper.size(), lower.size() });
+    if (period == 0 || n < period) {
+        fillWarmup(middle, n);
+        fillWarmup(upper, n);
+        fillWarmup(lower, n);
+        return;
+    }
+
+    const Kernels& kernel = kernels();
+    std::vector<double>& prefix = scratch(0, period + s_windowBlockSize);
+    std::vector<double>& prefixSquares = scratch(1, period + s_windowBlockSize);
+
+    fillWarmup(middle, period - 1);
+    fillWarmup(upper, period - 1);
+    fillWarmup(lower, period - 1);
+    forEachWindowBlock(values.first(n), period, [&](size_t start, size_t count, double shift) {
+        prefix[0] = 0.0;
+        prefixSquares[0] = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            const double value = values[start + i] - shift;
+            prefix[i + 1] = prefix[i] + value;
+            prefixSquares[i + 1] = prefixSquares[i] + value * value;
+        }
+        kernel.bands(prefix.data(), prefixSquares.data(), period, shift, deviations,
+                     middle.data() + start, upper.data() + start, lower.data() + start, period - 1, count);
+    });
+}
+
+}
+
+}
@@ -0,0 +1,69 @@
+#ifndef __INDICATORS_H__
+#define __INDICATORS_H__
+
+#include <span>
+#include <vector>
+#include "schwabcpp/schema/candleColumns.h"
+
+namespace schwabcpp {
+
+//
+// Technical indicators over candle columns (see `CandleColumns`, `CandleStore::Series::view()`).
+//
+// * The element-wise work (windowed sums, true range, price moves, typical price * volume, the
+//   band math) runs on AVX2 or SSE4 kernels when the cpu has them, picked once at runtime. The
+//   recursive smoothing (EMA, Wilder) is inherently sequential and stays scalar.
+//
+// * The output has the size of the input, the warmup values (not enough data yet) are NaN.
+//   The `out` variants write into the caller's buffer and don't allocate (per thread scratch
+//   space is reused), for running thousands of symbols every bar.
+//
+// * Volumes are expected to be non-negative and below 2^52.
+//
+namespace Indicators {
+
+enum class Isa : char {
+    Scalar,
+    Sse4,
+    Avx2,
+};
+
+const char*                 toString(Isa isa);
+
+// the best the cpu supports
+Isa                         supportedIsa();
+Isa                         activeIsa();
+// for comparing the kernels, clamped to what the cpu supports, returns the one set
+Isa                         setIsa(Isa isa);
+
+// -- moving averages
+void                        sma(std::span<const double> values, size_t period, std::span<double> out);
+void                        ema(std::span<const double> values, size_t period, std::span<double> out);
+
+// cumulative over the candles, typical price (high + low + close) / 3
+void                        vwap(const CandleColumnsView& candles, std::span<double> out);
+
+// -- volatility / momentum (Wilder's smoothing)
+void                        atr(const CandleColumnsView& candles, size_t period, std::span<double> out);
+void                        rsi(std::span<const double> closes, size_t period, std::span<double> out);
+
+// middle band is the sma, the others `deviations` population standard deviations away
+void                        bollinger(std::span<const double> values,
+                                      size_t period,
+                                      double deviations,
+                                      std::span<double> middle,
+                                      std::span<double> upper,
+                                      std::span<double> lower);
+
+// -- allocating variants
+inline std::vector<double>  sma(std::span<const double> values, size_t period) { std::vector<double> out(values.size()); sma(values, period, out); return out; }
+inline std::vector<double>  ema(std::span<const double> values, size_t period) { std::vector<double> out(values.size()); ema(values, period, out); return out; }
+inline std::vector<double>  vwap(const CandleColumnsView& candles) { std::vector<double> out(candles.size()); vwap(candles, out); return out; }
+inline std::vector<double>  atr(const CandleColumnsView& candles, size_t period) { std::vector<double> out(candles.size()); atr(candles, period, out); return out; }
+inline std::vector<double>  rsi(std::span<const double> closes, size_t period) { std::vector<double> out(closes.size()); rsi(closes, period, out); return out; }
+
+}
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __IO_OPTIONS_H__
+#define __IO_OPTIONS_H__
+
+#include <chrono>
+
+namespace schwabcpp {
+
+//
+// Tuning of the io context thread and the websocket sockets. The defaults are the regular
+// blocking mode, which is what you want unless you can spare a core.
+//
+struct IoOptions {
+
+    // -- io context thread
+
+    // Polls the io context in a spin loop instead of blocking in `run()`.
+    // Trades a core for lower and more consistent wakeup latency.
+    bool                        busyPoll = false;
+
+    // How long the busy polling keeps spinning without any work before it blocks until the next
+    // event. Zero means never block (the core stays at 100%).
+    std::chrono::microseconds   spinBeforeBlock{ 0 };
+
+    // Pins the io context thread to this cpu, -1 to leave it to the scheduler. (linux only)
+    int                         ioThreadCpu = -1;
+
+    // -- websocket sockets
+
+    bool                        tcpNoDelay = false;
+
+    // in bytes, 0 keeps the system default
+    int                         socketReceiveBufferSize = 0;
+    int                         socketSendBufferSize = 0;
+};
+
+}
+
+#endif
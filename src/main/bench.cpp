@@ -0,0 +1,618 @@
+#include "candleDecoder.h"
+#include "indicators.h"
+#include "optionPricing.h"
+#include "streamerDecoder.h"
+#include "streamerDispatcher.h"
+#include "utils/bufferPool.h"
+#include "utils/logger.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+//
+// Checks and benchmarks of the hot paths, nothing here needs a connection.
+//
+// usage: bench [streaming] [indicators] [candles] [pricing]  (all of them by default)
+//
+
+// -- allocation counting (every thread, the library's allocations included)
+
+namespace {
+
+std::atomic<size_t> s_allocations = 0;
+
+}
+
+void* operator new(size_t size)
+{
+    ++s_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+using namespace schwabcpp;
+
+using steady = std::chrono::steady_clock;
+
+double elapsedMs(steady::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(steady::now() - start).count();
+}
+
+// -- streaming: receive buffer pool, decoder and dispatcher
+
+const static size_t s_symbolCount = 64;
+const static size_t s_entriesPerFrame = 8;
+const static size_t s_framesPerRound = 16;
+
+// level one equity frames like the streamer sends them, some with an escaped (copied) string value
+std::vector<std::string> makeFrames(size_t count)
+{
+    std::vector<std::string> frames;
+    size_t symbol = 0;
+    for (size_t i = 0; i < count; ++i) {
+        std::string frame = R"({"data":[{"service":"LEVELONE_EQUITIES","timestamp":1700000000000,"command":"SUBS","content":[)";
+        for (size_t k = 0; k < s_entriesPerFrame; ++k, ++symbol) {
+            std::string price = std::to_string(100 + symbol % 50) + "." + std::to_string(symbol % 100);
+            frame += k ? "," : "";
+            frame += R"({"key":"SYM)" + std::to_string(symbol % s_symbolCount) + R"(","delayed":false)";
+            frame += R"(,"1":)" + price + R"(,"2":)" + price + R"(,"3":)" + price + R"(,"8":)" + std::to_string(symbol * 100);
+            frame += symbol % 3 ? R"(,"15":"Plain Name Inc")" : R"(,"15":"Escaped \"Name\" Inc")";
+            frame += "}";
+        }
+        frame += "]}]}";
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+// Feeds the frames the way the receiver loop does, with the typed handler on the dispatcher
+// workers. Once warmed up, receiving, decoding and dispatching a frame must not allocate.
+bool checkStreamingAllocations()
+{
+    SymbolTable symbols;
+    StreamerDecoder decoder(symbols);
+    StreamerDispatcher dispatcher(2);
+    BufferPool pool;
+
+    std::atomic<size_t> handled = 0;
+    dispatcher.setLevelOneEquityHandler([&handled](const LevelOneEquityUpdate&) { ++handled; });
+    decoder.setLevelOneEquityHandler([&dispatcher](const LevelOneEquityUpdate& update) { dispatcher.post(update); });
+
+    const std::vector<std::string> frames = makeFrames(s_symbolCount);
+    size_t posted = 0;
+    size_t next = 0;
+    auto feed = [&](size_t rounds) {
+        for (size_t round = 0; round < rounds; ++round) {
+            for (size_t i = 0; i < s_framesPerRound; ++i, ++next) {
+                SharedBuffer buffer = pool.acquire();
+                buffer->assign(frames[next % frames.size()]);
+                dispatcher.beginFrame(*buffer, buffer);
+                posted += decoder.decode(*buffer);
+                dispatcher.endFrame();
+            }
+            while (handled < posted) {
+                std::this_thread::yield();
+            }
+        }
+    };
+
+    // the symbols get interned, the pool, rings and strings grow to what they need
+    feed(500);
+
+    const size_t rounds = 2000;
+    size_t before = s_allocations;
+    auto start = steady::now();
+    feed(rounds);
+    double ms = elapsedMs(start);
+    size_t allocations = s_allocations - before;
+
+    size_t frameCount = rounds * s_framesPerRound;
+    std::cout << "streaming: " << frameCount << " frames, " << frameCount * s_entriesPerFrame << " updates in "
+              << ms << " ms, " << allocations << " allocation(s) (pool of " << pool.size() << " buffers)" << std::endl;
+
+    return allocations == 0;
+}
+
+// -- indicators: the kernels of every isa against naive implementations
+
+const static size_t s_barCount = 1'000'000;
+const static size_t s_period = 20;
+const static int s_runs = 5;
+
+// the fastest of a few runs
+template <typename Fn>
+double bestMs(Fn&& fn)
+{
+    double best = 0.0;
+    for (int run = 0; run < s_runs; ++run) {
+        auto start = steady::now();
+        fn();
+        double ms = elapsedMs(start);
+        best = run ? std::min(best, ms) : ms;
+    }
+    return best;
+}
+
+// a random walk of one minute bars
+CandleColumns randomWalk(size_t count)
+{
+    std::mt19937_64 random(42);
+    std::normal_distribution<double> move(0.0, 0.05);
+    std::uniform_real_distribution<double> range(0.0, 0.1);
+    std::uniform_int_distribution<int64_t> volume(0, 100000);
+
+    CandleColumns candles;
+    candles.reserve(count);
+    double close = 100.0;
+    for (size_t i = 0; i < count; ++i) {
+        double open = close;
+        close = std::max(open + move(random), 1.0);
+        Candle candle;
+        candle.datetime = 1700000000000 + static_cast<int64_t>(i) * 60000;
+        candle.open = open;
+        candle.close = close;
+        candle.high = std::max(open, close) + range(random);
+        candle.low = std::min(open, close) - range(random);
+        candle.volume = volume(random);
+        candles.push_back(candle);
+    }
+    candles.empty = false;
+    return candles;
+}
+
+namespace Naive {
+
+void sma(std::span<const double> values, size_t period, std::span<double> out)
+{
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i + 1 < period) {
+            out[i] = NAN;
+            continue;
+        }
+        double sum = 0.0;
+        for (size_t k = i + 1 - period; k <= i; ++k) {
+            sum += values[k];
+        }
+        out[i] = sum / period;
+    }
+}
+
+void vwap(const CandleColumnsView& candles, std::span<double> out)
+{
+    double priceVolume = 0.0;
+    double volume = 0.0;
+    for (size_t i = 0; i < candles.size(); ++i) {
+        priceVolume += (candles.high[i] + candles.low[i] + candles.close[i]) / 3.0 * candles.volume[i];
+        volume += candles.volume[i];
+        out[i] = volume > 0.0 ? priceVolume / volume : NAN;
+    }
+}
+
+void atr(const CandleColumnsView& candles, size_t period, std::span<double> out)
+{
+    double average = 0.0;
+    for (size_t i = 0; i < candles.size(); ++i) {
+        double trueRange = candles.high[i] - candles.low[i];
+        if (i > 0) {
+            trueRange = std::max({ trueRange,
+                                   std::abs(candles.high[i] - candles.close[i - 1]),
+                                   std::abs(candles.low[i] - candles.close[i - 1]) });
+        }
+        if (i < period) {
+            average += trueRange / period;
+        } else {
+            average = (average * (period - 1) + trueRange) / period;
+        }
+        out[i] = i + 1 < period ? NAN : average;
+    }
+}
+
+void rsi(std::span<const double> closes, size_t period, std::span<double> out)
+{
+    double gain = 0.0;
+    double loss = 0.0;
+    out[0] = NAN;
+    for (size_t i = 1; i < closes.size(); ++i) {
+        double move = closes[i] - closes[i - 1];
+        double up = move > 0.0 ? move : 0.0;
+        double down = move < 0.0 ? -move : 0.0;
+        if (i <= period) {
+            gain += up / period;
+            loss += down / period;
+        } else {
+            gain = (gain * (period - 1) + up) / period;
+            loss = (loss * (period - 1) + down) / period;
+        }
+        out[i] = i < period ? NAN : (loss == 0.0 ? 100.0 : 100.0 - 100.0 / (1.0 + gain / loss));
+    }
+}
+
+void bollinger(std::span<const double> values, size_t period, double deviations,
+               std::span<double> middle, std::span<double> upper, std::span<double> lower)
+{
+    sma(values, period, middle);
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i + 1 < period) {
+            upper[i] = lower[i] = NAN;
+            continue;
+        }
+        double variance = 0.0;
+        for (size_t k = i + 1 - period; k <= i; ++k) {
+            variance += (values[k] - middle[i]) * (values[k] - middle[i]);
+        }
+        double width = deviations * std::sqrt(variance / period);
+        upper[i] = middle[i] + width;
+        lower[i] = middle[i] - width;
+    }
+}
+
+}
+
+// same warmup, equal values up to the rounding of the different summation orders
+bool sameOutput(std::span<const double> result, std::span<const double> expected)
+{
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (std::isnan(result[i]) != std::isnan(expected[i])) {
+            return false;
+        }
+        if (!std::isnan(expected[i]) && std::abs(result[i] - expected[i]) > 1e-8 * std::max(1.0, std::abs(expected[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkIndicators()
+{
+    const CandleColumns candles = randomWalk(s_barCount);
+    const CandleColumnsView view = candles.view();
+    const std::span<const double> closes = view.close;
+
+    std::vector<double> expected(s_barCount), result(s_barCount);
+    std::vector<double> upper(s_barCount), lower(s_barCount), expectedUpper(s_barCount), expectedLower(s_barCount);
+
+    struct Indicator {
+        const char*                 name;
+        std::function<void()>       naive;      // into the expected ones
+        std::function<void()>       kernel;     // into the results
+    };
+    const std::vector<Indicator> indicators = {
+        { "sma",
+          [&] { Naive::sma(closes, s_period, expected); },
+          [&] { Indicators::sma(closes, s_period, result); } },
+        { "vwap",
+          [&] { Naive::vwap(view, expected); },
+          [&] { Indicators::vwap(view, result); } },
+        { "atr",
+          [&] { Naive::atr(view, s_period, expected); },
+          [&] { Indicators::atr(view, s_period, result); } },
+        { "rsi",
+          [&] { Naive::rsi(closes, s_period, expected); },
+          [&] { Indicators::rsi(closes, s_period, result); } },
+        { "bollinger",
+          [&] { Naive::bollinger(closes, s_period, 2.0, expected, expectedUpper, expectedLower); },
+          [&] { Indicators::bollinger(closes, s_period, 2.0, result, upper, lower); } },
+    };
+
+    const Indicators::Isa supported = Indicators::supportedIsa();
+    std::cout << "indicators: " << s_barCount << " bars, period " << s_period << ", best of " << s_runs
+              << " runs in ms (cpu supports " << Indicators::toString(supported) << ")" << std::endl;
+
+    bool passed = true;
+    for (const Indicator& indicator : indicators) {
+        std::cout << "  " << std::left << std::setw(10) << indicator.name
+                  << " naive " << std::right << std::setw(8) << bestMs(indicator.naive);
+
+        for (Indicators::Isa isa : { Indicators::Isa::Scalar, Indicators::Isa::Sse4, Indicators::Isa::Avx2 }) {
+            if (isa > supported) {
+                continue;
+            }
+            Indicators::setIsa(isa);
+            double ms = bestMs(indicator.kernel);
+
+            bool same = sameOutput(result, expected) &&
+                        (std::string_view(indicator.name) != "bollinger" ||
+                         (sameOutput(upper, expectedUpper) && sameOutput(lower, expectedLower)));
+            passed = passed && same;
+
+            std::cout << "  " << Indicators::toString(isa) << " " << std::setw(8) << ms << (same ? "" : " MISMATCH");
+        }
+        std::cout << std::endl;
+    }
+    Indicators::setIsa(supported);
+
+    return passed;
+}
+
+// -- price history: the direct decoder against the json document
+
+const static size_t s_candleCount = 500'000;
+const static size_t s_chunkSize = 16 * 1024;
+
+bool sameCandle(const Candle& a, const Candle& b)
+{
+    return a.datetime == b.datetime && a.open == b.open && a.high == b.high &&
+           a.low == b.low && a.close == b.close && a.volume == b.volume;
+}
+
+bool checkCandleDecoder()
+{
+    CandleList source = randomWalk(s_candleCount).toCandleList();
+    source.symbol = "BENCH";
+    const std::string response = json(source).dump();
+
+    CandleList document;
+    CandleList list;
+    CandleColumns columns;
+    CandleList chunked;
+
+    double documentMs = bestMs([&] { document = json::parse(response).get<CandleList>(); });
+    double listMs = bestMs([&] { list = {}; CandleDecoder::decode(response, list); });
+    double columnsMs = bestMs([&] { columns = {}; CandleDecoder::decode(response, columns); });
+    // as it arrives from the http engine
+    bool fed = true;
+    double chunkedMs = bestMs([&] {
+        chunked = {};
+        CandleDecoder decoder(chunked);
+        for (size_t offset = 0; offset < response.size(); offset += s_chunkSize) {
+            decoder.feed(std::string_view(response).substr(offset, s_chunkSize));
+        }
+        fed = decoder.finish();
+    });
+
+    bool same = fed &&
+                document.candles.size() == s_candleCount &&
+                list.candles.size() == s_candleCount &&
+                columns.size() == s_candleCount &&
+                chunked.candles.size() == s_candleCount &&
+                list.symbol == document.symbol && columns.symbol == document.symbol;
+    for (size_t i = 0; same && i < s_candleCount; ++i) {
+        same = sameCandle(list.candles[i], document.candles[i]) &&
+               sameCandle(columns.at(i), document.candles[i]) &&
+               sameCandle(chunked.candles[i], document.candles[i]);
+    }
+
+    std::cout << "candles: " << s_candleCount << " candles (" << response.size() / (1024 * 1024) << " MB), best of "
+              << s_runs << " runs in ms" << std::endl
+              << "  json document " << std::setw(8) << documentMs << std::endl
+              << "  list          " << std::setw(8) << listMs << std::endl
+              << "  columns       " << std::setw(8) << columnsMs << std::endl
+              << "  list, chunked " << std::setw(8) << chunkedMs << (same ? "" : " MISMATCH") << std::endl;
+
+    return same;
+}
+
+// -- option pricing: the kernels of every isa against a naive black-scholes, on a 10k contract chain
+
+const static size_t s_expirationCount = 20;
+const static size_t s_strikeCount = 250;  // per expiration, a call and a put each
+const static double s_spot = 100.0;
+const static double s_rate = 0.04;
+const static size_t s_tickCount = 100;
+
+// the volatility smile of the chain
+double smile(double strike, double years)
+{
+    double moneyness = std::log(strike / s_spot);
+    return 0.2 + 0.3 * moneyness * moneyness + 0.02 / std::sqrt(years);
+}
+
+namespace Naive {
+
+double normalCdf(double x)
+{
+    return 0.5 * std::erfc(-x / std::sqrt(2.0));
+}
+
+void greeks(double spot, double rate, double strike, double years, OptionContract::Type type, double sigma,
+            double& price, double& delta, double& gamma, double& theta, double& vega, double& rho)
+{
+    const double sign = type == OptionContract::Type::Call ? 1.0 : -1.0;
+    const double sigmaSqrtYears = sigma * std::sqrt(years);
+    const double d1 = (std::log(spot / strike) + (rate + 0.5 * sigma * sigma) * years) / sigmaSqrtYears;
+    const double d2 = d1 - sigmaSqrtYears;
+    const double density = std::exp(-0.5 * d1 * d1) / std::sqrt(2.0 * M_PI);
+    const double exercisedValue = strike * std::exp(-rate * years) * normalCdf(sign * d2);
+
+    price = sign * (spot * normalCdf(sign * d1) - exercisedValue);
+    delta = sign * normalCdf(sign * d1);
+    gamma = density / (spot * sigmaSqrtYears);
+    theta = (-spot * density * sigma / (2.0 * std::sqrt(years)) - sign * rate * exercisedValue) / 365.0;
+    vega = spot * density * std::sqrt(years) * 0.01;
+    rho = sign * years * exercisedValue * 0.01;
+}
+
+}
+
+struct GreekColumns {
+    std::vector<double>         price, delta, gamma, theta, vega, rho;
+
+    explicit                    GreekColumns(size_t size) : price(size), delta(size), gamma(size), theta(size), vega(size), rho(size) {}
+    OptionPricing::Greeks       greeks() { return { price, delta, gamma, theta, vega, rho }; }
+};
+
+bool checkOptionPricing()
+{
+    // the chain, priced at its smile
+    OptionChain chain;
+    chain.symbol = "BENCH";
+    chain.underlyingPrice = s_spot;
+    chain.interestRate = s_rate * 100.0;
+    const clock::time_point now = clock::now();
+    const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+    for (size_t e = 0; e < s_expirationCount; ++e) {
+        const int days = 7 + static_cast<int>(e) * 35;
+        for (size_t k = 0; k < s_strikeCount; ++k) {
+            for (OptionContract::Type type : { OptionContract::Type::Call, OptionContract::Type::Put }) {
+                OptionContract contract;
+                contract.type = type;
+                contract.strike = 50.0 + k * 0.4;
+                contract.expiration = nowMs + days * 86'400'000LL;
+                contract.daysToExpiration = days;
+                contract.multiplier = 100.0;
+
+                const double years = days / 365.0;
+                double delta, gamma, theta, vega, rho;
+                Naive::greeks(s_spot, s_rate, contract.strike, years, type, smile(contract.strike, years),
+                              contract.mark, delta, gamma, theta, vega, rho);
+                contract.bid = contract.mark;
+                contract.ask = contract.mark;
+                chain.push_back(contract);
+            }
+        }
+    }
+    chain.sort();
+    const size_t n = chain.size();
+
+    std::vector<double> years(n), sigma(n);
+    for (size_t i = 0; i < n; ++i) {
+        years[i] = chain.daysToExpiration[i] / 365.0;
+        sigma[i] = smile(chain.strike[i], years[i]);
+    }
+
+    GreekColumns expected(n);
+    double naiveMs = bestMs([&] {
+        for (size_t i = 0; i < n; ++i) {
+            Naive::greeks(s_spot, s_rate, chain.strike[i], years[i], chain.type[i], sigma[i],
+                          expected.price[i], expected.delta[i], expected.gamma[i],
+                          expected.theta[i], expected.vega[i], expected.rho[i]);
+        }
+    });
+
+    // deep in the money and close to expiring the time value is lost to rounding, no volatility
+    // tells these prices apart from the intrinsic value: the solver gives NaN
+    std::vector<bool> onBounds(n);
+    size_t onBoundsCount = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const double sign = chain.type[i] == OptionContract::Type::Call ? 1.0 : -1.0;
+        const double intrinsic = std::max(0.0, sign * (s_spot - chain.strike[i] * std::exp(-s_rate * years[i])));
+        onBounds[i] = chain.mark[i] - intrinsic < 1e-9 * std::max(1.0, chain.mark[i]);
+        onBoundsCount += onBounds[i];
+    }
+
+    const Indicators::Isa supported = Indicators::supportedIsa();
+    std::cout << "pricing: " << n << " contracts, best of " << s_runs << " runs in ms" << std::endl
+              << "  greeks naive " << std::setw(8) << naiveMs
+              << "  (" << onBoundsCount << " contracts priced at their intrinsic value)" << std::endl;
+
+    // a volatility fits when it gives back the price of the contract
+    auto fits = [&](std::span<const double> volatility) {
+        for (size_t i = 0; i < n; ++i) {
+            if (onBounds[i] && std::isnan(volatility[i])) {
+                continue;
+            }
+            double price, delta, gamma, theta, vega, rho;
+            Naive::greeks(s_spot, s_rate, chain.strike[i], years[i], chain.type[i], volatility[i],
+                          price, delta, gamma, theta, vega, rho);
+            if (!(std::abs(price - chain.mark[i]) <= 1e-6 * std::max(1.0, chain.mark[i]))) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    bool passed = true;
+    for (Indicators::Isa isa : { Indicators::Isa::Scalar, Indicators::Isa::Sse4, Indicators::Isa::Avx2 }) {
+        if (isa > supported) {
+            continue;
+        }
+        Indicators::setIsa(isa);
+
+        GreekColumns result(n);
+        double greeksMs = bestMs([&] {
+            OptionPricing::greeks(s_spot, s_rate, chain.strike, years, chain.type, sigma, result.greeks());
+        });
+        bool sameGreeks = sameOutput(result.price, expected.price) && sameOutput(result.delta, expected.delta) &&
+                          sameOutput(result.gamma, expected.gamma) && sameOutput(result.theta, expected.theta) &&
+                          sameOutput(result.vega, expected.vega) && sameOutput(result.rho, expected.rho);
+
+        // from scratch, and from the previous solution
+        std::vector<double> volatility(n);
+        double coldMs = bestMs([&] {
+            std::fill(volatility.begin(), volatility.end(), NAN);
+            OptionPricing::impliedVolatility(s_spot, s_rate, chain.strike, years, chain.type, chain.mark, volatility);
+        });
+        bool coldFits = fits(volatility);
+        double warmMs = bestMs([&] {
+            OptionPricing::impliedVolatility(s_spot, s_rate, chain.strike, years, chain.type, chain.mark, volatility);
+        });
+        bool warmFits = fits(volatility);
+
+        // the underlying ticking around, a volatility solve and the greeks per tick
+        OptionPricing::ChainPricer pricer(chain);
+        pricer.setTime(now);
+        pricer.update(s_spot);
+        double tickMs = bestMs([&] {
+            for (size_t tick = 0; tick < s_tickCount; ++tick) {
+                pricer.update(s_spot + 0.01 * static_cast<double>(tick % 10));
+            }
+        }) / s_tickCount;
+
+        bool same = sameGreeks && coldFits && warmFits;
+        passed = passed && same;
+
+        std::cout << "  " << std::left << std::setw(6) << Indicators::toString(isa) << std::right
+                  << " greeks " << std::setw(6) << greeksMs
+                  << "  iv cold " << std::setw(6) << coldMs
+                  << "  iv warm " << std::setw(6) << warmMs
+                  << "  chain tick " << std::setw(6) << tickMs
+                  << (sameGreeks ? "" : " GREEKS MISMATCH") << (coldFits && warmFits ? "" : " IV MISMATCH") << std::endl;
+    }
+    Indicators::setIsa(supported);
+
+    return passed;
+}
+
+struct Check {
+    const char*                 name;
+    std::function<bool()>       run;
+};
+
+}
+
+int main(int argc, char** argv)
+{
+    Logger::init(spdlog::level::warn);
+    std::cout << std::fixed << std::setprecision(2);
+
+    const std::vector<Check> checks = {
+        { "streaming", checkStreamingAllocations },
+        { "indicators", checkIndicators },
+        { "candles", checkCandleDecoder },
+        { "pricing", checkOptionPricing },
+    };
+
+    bool passed = true;
+    for (const Check& check : checks) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            selected = selected || !std::strcmp(argv[i], check.name);
+        }
+        if (selected && !check.run()) {
+            std::cout << check.name << ": FAILED" << std::endl;
+            passed = false;
+        }
+    }
+
+    return passed ? 0 : 1;
+}
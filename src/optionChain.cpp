@@ -0,0 +1,185 @@
+#include "optionChain.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+
+namespace schwabcpp {
+
+namespace {
+
+// reorders `column` to `order` (new index -> old index)
+template <typename T>
+void permute(std::vector<T>& column, const std::vector<size_t>& order)
+{
+    std::vector<T> sorted;
+    sorted.reserve(column.size());
+    for (size_t index : order) {
+        sorted.push_back(column[index]);
+    }
+    column = std::move(sorted);
+}
+
+}
+
+std::string_view OptionChain::contractSymbol(size_t index) const
+{
+    const uint32_t begin = index ? symbolEnds[index - 1] : 0;
+    return std::string_view(symbols).substr(begin, symbolEnds[index] - begin);
+}
+
+void OptionChain::reserve(size_t count)
+{
+    expiration.reserve(count);
+    strike.reserve(count);
+    type.reserve(count);
+    daysToExpiration.reserve(count);
+    multiplier.reserve(count);
+    bid.reserve(count);
+    ask.reserve(count);
+    last.reserve(count);
+    mark.reserve(count);
+    bidSize.reserve(count);
+    askSize.reserve(count);
+    totalVolume.reserve(count);
+    openInterest.reserve(count);
+    volatility.reserve(count);
+    delta.reserve(count);
+    gamma.reserve(count);
+    theta.reserve(count);
+    vega.reserve(count);
+    rho.reserve(count);
+    symbolEnds.reserve(count);
+    // OCC symbols are 21 chars
+    symbols.reserve(count * 21);
+}
+
+void OptionChain::push_back(const OptionContract& contract)
+{
+    expiration.push_back(contract.expiration);
+    strike.push_back(contract.strike);
+    type.push_back(contract.type);
+    daysToExpiration.push_back(contract.daysToExpiration);
+    multiplier.push_back(contract.multiplier);
+    bid.push_back(contract.bid);
+    ask.push_back(contract.ask);
+    last.push_back(contract.last);
+    mark.push_back(contract.mark);
+    bidSize.push_back(contract.bidSize);
+    askSize.push_back(contract.askSize);
+    totalVolume.push_back(contract.totalVolume);
+    openInterest.push_back(contract.openInterest);
+    volatility.push_back(contract.volatility);
+    delta.push_back(contract.delta);
+    gamma.push_back(contract.gamma);
+    theta.push_back(contract.theta);
+    vega.push_back(contract.vega);
+    rho.push_back(contract.rho);
+
+    symbols += contract.symbol;
+    symbolEnds.push_back(static_cast<uint32_t>(symbols.size()));
+}
+
+OptionContract OptionChain::at(size_t index) const
+{
+    if (index >= size()) {
+        throw std::out_of_range("OptionChain::at");
+    }
+
+    OptionContract contract;
+    contract.symbol = contractSymbol(index);
+    contract.type = type[index];
+    contract.strike = strike[index];
+    contract.expiration = expiration[index];
+    contract.daysToExpiration = daysToExpiration[index];
+    contract.multiplier = multiplier[index];
+    contract.bid = bid[index];
+    contract.ask = ask[index];
+    contract.last = last[index];
+    contract.mark = mark[index];
+    contract.bidSize = bidSize[index];
+    contract.askSize = askSize[index];
+    contract.totalVolume = totalVolume[index];
+    contract.openInterest = openInterest[index];
+    contract.volatility = volatility[index];
+    contract.delta = delta[index];
+    contract.gamma = gamma[index];
+    contract.theta = theta[index];
+    contract.vega = vega[index];
+    contract.rho = rho[index];
+    return contract;
+}
+
+void OptionChain::sort()
+{
+    std::vector<size_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+
+    auto key = [this](size_t index) { return std::make_tuple(expiration[index], strike[index], type[index]); };
+    if (std::is_sorted(order.begin(), order.end(), [&key](size_t a, size_t b) { return key(a) < key(b); })) {
+        return;
+    }
+    std::stable_sort(order.begin(), order.end(), [&key](size_t a, size_t b) { return key(a) < key(b); });
+
+    std::string sortedSymbols;
+    std::vector<uint32_t> sortedSymbolEnds;
+    sortedSymbols.reserve(symbols.size());
+    sortedSymbolEnds.reserve(order.size());
+    for (size_t index : order) {
+        sortedSymbols += contractSymbol(index);
+        sortedSymbolEnds.push_back(static_cast<uint32_t>(sortedSymbols.size()));
+    }
+    symbols = std::move(sortedSymbols);
+    symbolEnds = std::move(sortedSymbolEnds);
+
+    permute(expiration, order);
+    permute(strike, order);
+    permute(type, order);
+    permute(daysToExpiration, order);
+    permute(multiplier, order);
+    permute(bid, order);
+    permute(ask, order);
+    permute(last, order);
+    permute(mark, order);
+    permute(bidSize, order);
+    permute(askSize, order);
+    permute(totalVolume, order);
+    permute(openInterest, order);
+    permute(volatility, order);
+    permute(delta, order);
+    permute(gamma, order);
+    permute(theta, order);
+    permute(vega, order);
+    permute(rho, order);
+}
+
+std::vector<int64_t> OptionChain::expirations() const
+{
+    std::vector<int64_t> result;
+    std::unique_copy(expiration.begin(), expiration.end(), std::back_inserter(result));
+    return result;
+}
+
+std::pair<size_t, size_t> OptionChain::expirationRange(int64_t date) const
+{
+    auto [first, last] = std::equal_range(expiration.begin(), expiration.end(), date);
+    return { first - expiration.begin(), last - expiration.begin() };
+}
+
+size_t OptionChain::find(int64_t date, double price, OptionContract::Type contractType) const
+{
+    auto [first, last] = expirationRange(date);
+
+    // the strikes of the expiration are sorted, a call and a put each
+    auto it = std::lower_bound(strike.begin() + first, strike.begin() + last, price);
+    for (; it != strike.begin() + last && *it == price; ++it) {
+        const size_t index = it - strike.begin();
+        if (type[index] == contractType) {
+            return index;
+        }
+    }
+
+    return npos;
+}
+
+}
@@ -0,0 +1,116 @@
+#ifndef __OPTION_CHAIN_H__
+#define __OPTION_CHAIN_H__
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace schwabcpp {
+
+// One contract of an `OptionChain` (a row of its columns).
+struct OptionContract {
+
+    enum class Type : char {
+        Call,
+        Put,
+    };
+
+    std::string                 symbol;
+    Type                        type = Type::Call;
+    double                      strike = 0.0;
+    int64_t                     expiration = 0;     // epoch milliseconds
+    int32_t                     daysToExpiration = 0;
+    double                      multiplier = 0.0;
+
+    double                      bid = 0.0;
+    double                      ask = 0.0;
+    double                      last = 0.0;
+    double                      mark = 0.0;
+    int64_t                     bidSize = 0;
+    int64_t                     askSize = 0;
+    int64_t                     totalVolume = 0;
+    int64_t                     openInterest = 0;
+
+    // NaN when the api has none
+    double                      volatility = std::numeric_limits<double>::quiet_NaN();
+    double                      delta = std::numeric_limits<double>::quiet_NaN();
+    double                      gamma = std::numeric_limits<double>::quiet_NaN();
+    double                      theta = std::numeric_limits<double>::quiet_NaN();
+    double                      vega = std::numeric_limits<double>::quiet_NaN();
+    double                      rho = std::numeric_limits<double>::quiet_NaN();
+};
+
+//
+// The contracts of an option chain, one array per field (the calls and the puts together).
+//
+// * Sorted by expiration, strike and type (the call first), `find(...)` and `expirationRange(...)`
+//   are binary searches.
+//
+// * A contract takes around 170 bytes, the contract symbols are packed in one string.
+//
+struct OptionChain {
+
+    inline static const size_t  npos = std::numeric_limits<size_t>::max();
+
+    // -- the underlying
+    std::string                 symbol;
+    double                      underlyingPrice = 0.0;
+    double                      underlyingVolatility = 0.0;
+    double                      interestRate = 0.0;
+    bool                        delayed = false;
+
+    // -- the contracts
+    std::vector<int64_t>        expiration;
+    std::vector<double>         strike;
+    std::vector<OptionContract::Type>
+                                type;
+    std::vector<int32_t>        daysToExpiration;
+    std::vector<double>         multiplier;
+
+    std::vector<double>         bid;
+    std::vector<double>         ask;
+    std::vector<double>         last;
+    std::vector<double>         mark;
+    std::vector<int64_t>        bidSize;
+    std::vector<int64_t>        askSize;
+    std::vector<int64_t>        totalVolume;
+    std::vector<int64_t>        openInterest;
+
+    std::vector<double>         volatility;
+    std::vector<double>         delta;
+    std::vector<double>         gamma;
+    std::vector<double>         theta;
+    std::vector<double>         vega;
+    std::vector<double>         rho;
+
+    // the symbol of contract i ends at symbolEnds[i] (and starts where the previous one ends)
+    std::string                 symbols;
+    std::vector<uint32_t>       symbolEnds;
+
+    size_t                      size() const { return strike.size(); }
+    bool                        empty() const { return strike.empty(); }
+
+    std::string_view            contractSymbol(size_t index) const;
+
+    void                        reserve(size_t count);
+    // appended as is, `sort()` once done
+    void                        push_back(const OptionContract& contract);
+    OptionContract              at(size_t index) const;
+
+    void                        sort();
+
+    // -- lookups (sorted chain)
+    // the distinct expirations, in order
+    std::vector<int64_t>        expirations() const;
+    // [first, last) of the contracts of the expiration
+    std::pair<size_t, size_t>   expirationRange(int64_t expiration) const;
+    // npos if not in the chain
+    size_t                      find(int64_t expiration, double strike, OptionContract::Type type) const;
+};
+
+}
+
+#endif
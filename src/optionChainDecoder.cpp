@@ -0,0 +1,230 @@
+#include "optionChainDecoder.h"
+#include "utils/jsonScanner.h"
+#include "utils/numberParser.h"
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace schwabcpp {
+
+namespace {
+
+using Token = JsonScanner::Token;
+
+// a contract is around 1.5k of json, reserve for the lot upfront
+const static size_t s_bytesPerContract = 1500;
+
+// "2024-01-19T21:00:00.000+00:00" to epoch milliseconds, false if not in that form
+bool parseDateTime(std::string_view text, int64_t& out)
+{
+    auto number = [text](size_t offset, size_t length, int& value) {
+        if (offset + length > text.size()) {
+            return false;
+        }
+        const char* begin = text.data() + offset;
+        auto [ptr, ec] = std::from_chars(begin, begin + length, value);
+        return ec == std::errc() && ptr == begin + length;
+    };
+
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (!number(0, 4, year) || !number(5, 2, month) || !number(8, 2, day) ||
+        !number(11, 2, hour) || !number(14, 2, minute) || !number(17, 2, second))
+    {
+        return false;
+    }
+
+    using namespace std::chrono;
+    const year_month_day date{ std::chrono::year(year), std::chrono::month(month), std::chrono::day(day) };
+    if (!date.ok()) {
+        return false;
+    }
+    milliseconds time = sys_days(date).time_since_epoch() + hours(hour) + minutes(minute) + seconds(second);
+
+    // the offset, if any ("+00:00" or "Z"), after the optional fraction
+    size_t zone = text.find_first_of("+-Z", 19);
+    if (zone != std::string_view::npos && text[zone] != 'Z') {
+        int offsetHours = 0, offsetMinutes = 0;
+        if (number(zone + 1, 2, offsetHours) && number(zone + 4, 2, offsetMinutes)) {
+            minutes offset = hours(offsetHours) + minutes(offsetMinutes);
+            time += text[zone] == '+' ? -offset : offset;
+        }
+    }
+
+    out = time.count();
+    return true;
+}
+
+// a number, or NaN for what isn't one ("NaN" strings, null)
+double toDouble(JsonScanner& scanner, Token token)
+{
+    double value = std::numeric_limits<double>::quiet_NaN();
+    if (token == Token::Number && !NumberParser::parseDouble(scanner.text(), value)) {
+        value = std::numeric_limits<double>::quiet_NaN();
+    }
+    return value;
+}
+
+int64_t toLong(JsonScanner& scanner, Token token)
+{
+    int64_t value = 0;
+    if (token != Token::Number || !NumberParser::parseLong(scanner.text(), value)) {
+        value = 0;
+    }
+    return value;
+}
+
+// the scanner is positioned right after the '{' of the contract
+bool decodeContract(JsonScanner& scanner, OptionContract& contract)
+{
+    contract = OptionContract{ .symbol = std::move(contract.symbol) };
+    contract.symbol.clear();
+
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+        if (value == Token::BeginObject || value == Token::BeginArray) {
+            // the deliverables, nothing of ours
+            if (!scanner.skipValue(value)) {
+                return false;
+            }
+            continue;
+        }
+
+        // the most frequent first
+        if (key == "bid") {
+            contract.bid = toDouble(scanner, value);
+        } else if (key == "ask") {
+            contract.ask = toDouble(scanner, value);
+        } else if (key == "last") {
+            contract.last = toDouble(scanner, value);
+        } else if (key == "mark") {
+            contract.mark = toDouble(scanner, value);
+        } else if (key == "bidSize") {
+            contract.bidSize = toLong(scanner, value);
+        } else if (key == "askSize") {
+            contract.askSize = toLong(scanner, value);
+        } else if (key == "totalVolume") {
+            contract.totalVolume = toLong(scanner, value);
+        } else if (key == "openInterest") {
+            contract.openInterest = toLong(scanner, value);
+        } else if (key == "volatility") {
+            contract.volatility = toDouble(scanner, value);
+        } else if (key == "delta") {
+            contract.delta = toDouble(scanner, value);
+        } else if (key == "gamma") {
+            contract.gamma = toDouble(scanner, value);
+        } else if (key == "theta") {
+            contract.theta = toDouble(scanner, value);
+        } else if (key == "vega") {
+            contract.vega = toDouble(scanner, value);
+        } else if (key == "rho") {
+            contract.rho = toDouble(scanner, value);
+        } else if (key == "strikePrice") {
+            contract.strike = toDouble(scanner, value);
+        } else if (key == "daysToExpiration") {
+            contract.daysToExpiration = static_cast<int32_t>(toLong(scanner, value));
+        } else if (key == "multiplier") {
+            contract.multiplier = toDouble(scanner, value);
+        } else if (key == "putCall" && value == Token::String) {
+            contract.type = scanner.text() == "PUT" ? OptionContract::Type::Put : OptionContract::Type::Call;
+        } else if (key == "symbol" && value == Token::String) {
+            // OCC symbols, no escapes
+            contract.symbol.assign(scanner.text());
+        } else if (key == "expirationDate" && value == Token::String) {
+            if (!parseDateTime(scanner.text(), contract.expiration)) {
+                return false;
+            }
+        } else if (!scanner.skipValue(value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// { "<date>:<days>": { "<strike>": [ contract, ... ], ... }, ... }
+// the keys are not used, the contracts carry their expiration and strike
+bool decodeExpirationMap(JsonScanner& scanner, OptionChain& out)
+{
+    OptionContract contract;
+
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String || scanner.next() != Token::BeginObject) {
+            return false;
+        }
+
+        for (token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+            if (token != Token::String || scanner.next() != Token::BeginArray) {
+                return false;
+            }
+
+            for (token = scanner.next(); token != Token::EndArray; token = scanner.next()) {
+                if (token != Token::BeginObject || !decodeContract(scanner, contract)) {
+                    return false;
+                }
+                out.push_back(contract);
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+namespace OptionChainDecoder {
+
+bool decode(std::string_view response, OptionChain& out)
+{
+    out = OptionChain{};
+    out.reserve(response.size() / s_bytesPerContract);
+
+    JsonScanner scanner(response);
+    if (scanner.next() != Token::BeginObject) {
+        return false;
+    }
+
+    bool hasSymbol = false;
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        if ((key == "callExpDateMap" || key == "putExpDateMap") && value == Token::BeginObject) {
+            if (!decodeExpirationMap(scanner, out)) {
+                return false;
+            }
+        } else if (key == "symbol" && value == Token::String) {
+            out.symbol.assign(scanner.text());
+            hasSymbol = true;
+        } else if (key == "status" && value == Token::String) {
+            if (scanner.text() != "SUCCESS") {
+                return false;
+            }
+        } else if (key == "underlyingPrice") {
+            out.underlyingPrice = toDouble(scanner, value);
+        } else if (key == "volatility") {
+            out.underlyingVolatility = toDouble(scanner, value);
+        } else if (key == "interestRate") {
+            out.interestRate = toDouble(scanner, value);
+        } else if (key == "isDelayed") {
+            out.delayed = value == Token::True;
+        } else if (!scanner.skipValue(value)) {
+            return false;
+        }
+    }
+
+    out.sort();
+
+    return hasSymbol;
+}
+
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef __OPTION_CHAIN_DECODER_H__
+#define __OPTION_CHAIN_DECODER_H__
+
+#include <string_view>
+#include "optionChain.h"
+
+namespace schwabcpp {
+
+//
+// Decodes the rest option chain responses (GET /chains) straight into the chain columns, in a
+// single scan of the text (the contracts are nested in maps by expiration and strike, no json
+// document is built for them).
+//
+namespace OptionChainDecoder {
+
+// Returns false if the response is not an option chain, `out` is then unspecified.
+// The chain is sorted.
+bool                            decode(std::string_view response, OptionChain& out);
+
+}
+
+}
+
+#endif
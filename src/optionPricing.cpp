@@ -0,0 +1,556 @@
+#include "optionPricing.h"
+#include "indicators.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace schwabcpp {
+
+namespace {
+
+const static double s_nan = std::numeric_limits<double>::quiet_NaN();
+const static double s_millisecondsPerYear = 365.0 * 24 * 3600 * 1000;
+
+// -- implied volatility solve
+const static double s_minVolatility = 1e-4;
+const static double s_maxVolatility = 5.0;
+const static double s_defaultVolatility = 0.3;
+const static int s_maxIterations = 64;
+// on the price
+const static double s_tolerance = 1e-10;
+
+#define SCHWABCPP_INLINE inline __attribute__((always_inline))
+
+// the helpers taking 32 byte vectors are always inlined into the avx2 kernels, no call abi involved
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+//
+// The kernels are written once over GCC vector types of 1, 2 or 4 doubles and instantiated in
+// functions built for the matching isa (everything inlines into them, the vector code is generated
+// for that isa). 1 lane is the scalar kernel, and handles the tails.
+//
+template <size_t Lanes>
+struct Lane;
+
+template <>
+struct Lane<1> {
+    typedef double V __attribute__((vector_size(8)));
+    typedef int64_t I __attribute__((vector_size(8)));
+};
+
+template <>
+struct Lane<2> {
+    typedef double V __attribute__((vector_size(16)));
+    typedef int64_t I __attribute__((vector_size(16)));
+};
+
+template <>
+struct Lane<4> {
+    typedef double V __attribute__((vector_size(32)));
+    typedef int64_t I __attribute__((vector_size(32)));
+};
+
+template <typename V>
+SCHWABCPP_INLINE V broadcast(double value)
+{
+    return V{} + value;
+}
+
+template <typename V>
+SCHWABCPP_INLINE V load(const double* data)
+{
+    V v;
+    std::memcpy(&v, data, sizeof(V));
+    return v;
+}
+
+template <typename V>
+SCHWABCPP_INLINE void store(double* data, V v)
+{
+    std::memcpy(data, &v, sizeof(V));
+}
+
+template <typename I>
+SCHWABCPP_INLINE bool all(I mask)
+{
+    for (size_t i = 0; i < sizeof(I) / sizeof(int64_t); ++i) {
+        if (!mask[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// e^x, cephes' rational approximation (within 2 ulp), 0 below -708
+template <size_t L>
+SCHWABCPP_INLINE typename Lane<L>::V exp(typename Lane<L>::V x)
+{
+    using V = typename Lane<L>::V;
+    using I = typename Lane<L>::I;
+
+    // rounds to an integer in the low bits of the mantissa
+    const V magic = broadcast<V>(6755399441055744.0);
+
+    V clamped = x < -708.0 ? broadcast<V>(-708.0) : (x > 709.0 ? broadcast<V>(709.0) : x);
+    V t = clamped * 1.4426950408889634 + magic;
+    V n = t - magic;
+    V r = clamped - n * 0.693145751953125 - n * 1.42860682030941723212e-6;
+
+    V rr = r * r;
+    V p = r * ((1.26177193074810590878e-4 * rr + 3.02994407707441961300e-2) * rr + 9.99999999999999999910e-1);
+    V q = ((3.00198505138664455042e-6 * rr + 2.52448340349684104192e-3) * rr + 2.27265548208155028766e-1) * rr + 2.00000000000000000009;
+    V e = 1.0 + 2.0 * p / (q - p);
+
+    // * 2^n
+    V result = (V)((I)e + (((I)t - (I)magic) << 52));
+    result = x < -708.0 ? V{} : result;
+
+    // NaN stays NaN
+    return x == x ? result : x;
+}
+
+// the standard normal cdf, West's double precision version of Hart's algorithm (within 1e-14)
+template <size_t L>
+SCHWABCPP_INLINE typename Lane<L>::V normalCdf(typename Lane<L>::V x)
+{
+    using V = typename Lane<L>::V;
+
+    V a = x < 0.0 ? -x : x;
+    V e = exp<L>(-0.5 * a * a);
+
+    V numerator = 3.52624965998911e-02 * a + 0.700383064443688;
+    numerator = numerator * a + 6.37396220353165;
+    numerator = numerator * a + 33.912866078383;
+    numerator = numerator * a + 112.079291497871;
+    numerator = numerator * a + 221.213596169931;
+    numerator = numerator * a + 220.206867912376;
+    V denominator = 8.83883476483184e-02 * a + 1.75566716318264;
+    denominator = denominator * a + 16.064177579207;
+    denominator = denominator * a + 86.7807322029461;
+    denominator = denominator * a + 296.564248779674;
+    denominator = denominator * a + 637.333633378831;
+    denominator = denominator * a + 793.826512519948;
+    denominator = denominator * a + 440.413735824752;
+    V near = e * numerator / denominator;
+
+    // continued fraction far in the tail
+    V fraction = a + 0.65;
+    fraction = a + 4.0 / fraction;
+    fraction = a + 3.0 / fraction;
+    fraction = a + 2.0 / fraction;
+    fraction = a + 1.0 / fraction;
+    V far = e / fraction / 2.506628274631;
+
+    V tail = a < 7.07106781186547 ? near : far;
+    tail = a > 37.0 ? V{} : tail;
+
+    return x > 0.0 ? 1.0 - tail : tail;
+}
+
+// what doesn't depend on the underlying, per contract
+struct Terms {
+    const double*                   strike;
+    const double*                   logStrike;
+    const double*                   years;
+    const double*                   sqrtYears;
+    const double*                   discount;
+    const double*                   sign;
+};
+
+struct Market {
+    double                          spot;
+    double                          logSpot;
+    double                          rate;
+};
+
+// the price, and the terms the greeks share
+template <size_t L>
+struct Valuation {
+    using V = typename Lane<L>::V;
+
+    V                               price;
+    V                               density;        // n(d1)
+    V                               exercised;      // N(sign * d2)
+    V                               sigmaSqrtYears;
+};
+
+template <size_t L>
+SCHWABCPP_INLINE Valuation<L> value(const Terms& terms, const Market& market, typename Lane<L>::V sigma, size_t i)
+{
+    using V = typename Lane<L>::V;
+
+    const V strike = load<V>(terms.strike + i);
+    const V years = load<V>(terms.years + i);
+    const V discount = load<V>(terms.discount + i);
+    const V sign = load<V>(terms.sign + i);
+
+    Valuation<L> result;
+    result.sigmaSqrtYears = sigma * load<V>(terms.sqrtYears + i);
+
+    V d1 = (market.logSpot - load<V>(terms.logStrike + i) + (market.rate + 0.5 * sigma * sigma) * years) / result.sigmaSqrtYears;
+    V d2 = d1 - result.sigmaSqrtYears;
+
+    V inTheMoney = normalCdf<L>(sign * d1);
+    result.exercised = normalCdf<L>(sign * d2);
+    result.density = exp<L>(-0.5 * d1 * d1) * 0.3989422804014327;
+    result.price = sign * (market.spot * inTheMoney - strike * discount * result.exercised);
+
+    return result;
+}
+
+template <size_t L>
+SCHWABCPP_INLINE void greeksBlock(const Terms& terms, const Market& market, const double* volatility,
+                                  const OptionPricing::Greeks& out, size_t i)
+{
+    using V = typename Lane<L>::V;
+
+    const V sigma = load<V>(volatility + i);
+    const Valuation<L> valuation = value<L>(terms, market, sigma, i);
+
+    const V strike = load<V>(terms.strike + i);
+    const V years = load<V>(terms.years + i);
+    const V sqrtYears = load<V>(terms.sqrtYears + i);
+    const V discount = load<V>(terms.discount + i);
+    const V sign = load<V>(terms.sign + i);
+    const V exercisedValue = strike * discount * valuation.exercised;
+
+    // N(sign * d1) == price / spot + ..., simpler from the price itself
+    V delta = (valuation.price + sign * exercisedValue) / market.spot;
+    V gamma = valuation.density / (market.spot * valuation.sigmaSqrtYears);
+    V vega = market.spot * valuation.density * sqrtYears;
+    V theta = -market.spot * valuation.density * sigma / (2.0 * sqrtYears) - sign * market.rate * exercisedValue;
+    V rho = sign * years * exercisedValue;
+
+    store(out.price.data() + i, valuation.price);
+    store(out.delta.data() + i, delta);
+    store(out.gamma.data() + i, gamma);
+    store(out.theta.data() + i, theta * (1.0 / 365.0));
+    store(out.vega.data() + i, vega * 0.01);
+    store(out.rho.data() + i, rho * 0.01);
+}
+
+template <size_t L>
+SCHWABCPP_INLINE void impliedVolatilityBlock(const Terms& terms, const Market& market, const double* prices,
+                                             double* volatility, size_t i)
+{
+    using V = typename Lane<L>::V;
+
+    const V target = load<V>(prices + i);
+    const V strike = load<V>(terms.strike + i);
+    const V discount = load<V>(terms.discount + i);
+    const V sign = load<V>(terms.sign + i);
+    const V sqrtYears = load<V>(terms.sqrtYears + i);
+
+    // no volatility prices a contract outside of (intrinsic, spot or discounted strike)
+    V intrinsic = sign * (market.spot - strike * discount);
+    intrinsic = intrinsic > 0.0 ? intrinsic : V{};
+    const V ceiling = sign > 0.0 ? broadcast<V>(market.spot) : strike * discount;
+    const auto valid = (target > intrinsic) & (target < ceiling) & (sqrtYears > 0.0);
+
+    V low = broadcast<V>(s_minVolatility);
+    V high = broadcast<V>(s_maxVolatility);
+    V sigma = load<V>(volatility + i);
+    sigma = (sigma > low) & (sigma < high) ? sigma : broadcast<V>(s_defaultVolatility);
+
+    const V tolerance = s_tolerance * (1.0 + target);
+    for (int iteration = 0; iteration < s_maxIterations; ++iteration) {
+        const Valuation<L> valuation = value<L>(terms, market, sigma, i);
+        V error = valuation.price - target;
+        auto converged = (error < tolerance) & (error > -tolerance);
+        if (all(converged | ~valid)) {
+            break;
+        }
+
+        // the root stays in [low, high]
+        high = error > 0.0 ? sigma : high;
+        low = error > 0.0 ? low : sigma;
+
+        V vega = market.spot * valuation.density * sqrtYears;
+        V next = sigma - error / vega;
+        next = (next > low) & (next < high) ? next : 0.5 * (low + high);
+        sigma = converged ? sigma : next;
+    }
+
+    store(volatility + i, valid ? sigma : broadcast<V>(s_nan));
+}
+
+// the blocks of L lanes, the tail one by one
+template <size_t L>
+SCHWABCPP_INLINE void greeksRange(const Terms& terms, const Market& market, const double* volatility,
+                                  const OptionPricing::Greeks& out, size_t begin, size_t end)
+{
+    size_t i = begin;
+    for (; i + L <= end; i += L) {
+        greeksBlock<L>(terms, market, volatility, out, i);
+    }
+    for (; i < end; ++i) {
+        greeksBlock<1>(terms, market, volatility, out, i);
+    }
+}
+
+template <size_t L>
+SCHWABCPP_INLINE void impliedVolatilityRange(const Terms& terms, const Market& market, const double* prices,
+                                             double* volatility, size_t begin, size_t end)
+{
+    size_t i = begin;
+    for (; i + L <= end; i += L) {
+        impliedVolatilityBlock<L>(terms, market, prices, volatility, i);
+    }
+    for (; i < end; ++i) {
+        impliedVolatilityBlock<1>(terms, market, prices, volatility, i);
+    }
+}
+
+struct Kernels {
+    void (*greeks)(const Terms& terms, const Market& market, const double* volatility,
+                   const OptionPricing::Greeks& out, size_t begin, size_t end);
+    void (*impliedVolatility)(const Terms& terms, const Market& market, const double* prices,
+                              double* volatility, size_t begin, size_t end);
+};
+
+// -- scalar kernels
+
+void greeksScalar(const Terms& terms, const Market& market, const double* volatility,
+                  const OptionPricing::Greeks& out, size_t begin, size_t end)
+{
+    greeksRange<1>(terms, market, volatility, out, begin, end);
+}
+
+void impliedVolatilityScalar(const Terms& terms, const Market& market, const double* prices,
+                             double* volatility, size_t begin, size_t end)
+{
+    impliedVolatilityRange<1>(terms, market, prices, volatility, begin, end);
+}
+
+const static Kernels s_scalarKernels = {
+    &greeksScalar,
+    &impliedVolatilityScalar,
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCHWABCPP_X86_KERNELS
+
+// -- sse4 kernels
+
+__attribute__((target("sse4.1")))
+void greeksSse4(const Terms& terms, const Market& market, const double* volatility,
+                const OptionPricing::Greeks& out, size_t begin, size_t end)
+{
+    greeksRange<2>(terms, market, volatility, out, begin, end);
+}
+
+__attribute__((target("sse4.1")))
+void impliedVolatilitySse4(const Terms& terms, const Market& market, const double* prices,
+                           double* volatility, size_t begin, size_t end)
+{
+    impliedVolatilityRange<2>(terms, market, prices, volatility, begin, end);
+}
+
+const static Kernels s_sse4Kernels = {
+    &greeksSse4,
+    &impliedVolatilitySse4,
+};
+
+// -- avx2 kernels
+
+__attribute__((target("avx2,fma")))
+void greeksAvx2(const Terms& terms, const Market& market, const double* volatility,
+                const OptionPricing::Greeks& out, size_t begin, size_t end)
+{
+    greeksRange<4>(terms, market, volatility, out, begin, end);
+}
+
+__attribute__((target("avx2,fma")))
+void impliedVolatilityAvx2(const Terms& terms, const Market& market, const double* prices,
+                           double* volatility, size_t begin, size_t end)
+{
+    impliedVolatilityRange<4>(terms, market, prices, volatility, begin, end);
+}
+
+const static Kernels s_avx2Kernels = {
+    &greeksAvx2,
+    &impliedVolatilityAvx2,
+};
+
+// the avx2 kernels also use fma, which some cpus (and vms) don't have along with avx2
+bool supportsFma()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("fma");
+}
+
+#endif // SCHWABCPP_X86_KERNELS
+
+// -- dispatch (the isa of the indicators)
+
+const Kernels& kernels()
+{
+    switch (Indicators::activeIsa()) {
+#ifdef SCHWABCPP_X86_KERNELS
+        case Indicators::Isa::Avx2: {
+            const static bool s_fma = supportsFma();
+            return s_fma ? s_avx2Kernels : s_sse4Kernels;
+        }
+        case Indicators::Isa::Sse4: return s_sse4Kernels;
+#endif
+        default: return s_scalarKernels;
+    }
+}
+
+// -- the terms of the contracts
+
+struct TermColumns {
+    std::vector<double>             logStrike;
+    std::vector<double>             years;
+    std::vector<double>             sqrtYears;
+    std::vector<double>             discount;
+    std::vector<double>             sign;
+
+    void assign(std::span<const double> strike,
+                std::span<const double> yearsToExpiration,
+                std::span<const OptionContract::Type> type,
+                double rate)
+    {
+        const size_t count = strike.size();
+        logStrike.resize(count);
+        years.resize(count);
+        sqrtYears.resize(count);
+        discount.resize(count);
+        sign.resize(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            // expired, everything derived is NaN
+            const double t = yearsToExpiration[i] > 0.0 ? yearsToExpiration[i] : s_nan;
+            logStrike[i] = std::log(strike[i]);
+            years[i] = t;
+            sqrtYears[i] = std::sqrt(t);
+            discount[i] = std::exp(-rate * t);
+            sign[i] = type[i] == OptionContract::Type::Put ? -1.0 : 1.0;
+        }
+    }
+
+    Terms terms(const double* strike) const
+    {
+        return { strike, logStrike.data(), years.data(), sqrtYears.data(), discount.data(), sign.data() };
+    }
+};
+
+// reused by the calls of a thread
+TermColumns& scratchTerms()
+{
+    thread_local TermColumns terms;
+    return terms;
+}
+
+Market market(double spot, double rate)
+{
+    return { spot, std::log(spot), rate };
+}
+
+}
+
+namespace OptionPricing {
+
+void greeks(double spot,
+            double rate,
+            std::span<const double> strike,
+            std::span<const double> years,
+            std::span<const OptionContract::Type> type,
+            std::span<const double> volatility,
+            const Greeks& out)
+{
+    TermColumns& terms = scratchTerms();
+    terms.assign(strike, years, type, rate);
+
+    kernels().greeks(terms.terms(strike.data()), market(spot, rate), volatility.data(), out, 0, strike.size());
+}
+
+void impliedVolatility(double spot,
+                       double rate,
+                       std::span<const double> strike,
+                       std::span<const double> years,
+                       std::span<const OptionContract::Type> type,
+                       std::span<const double> prices,
+                       std::span<double> volatility)
+{
+    TermColumns& terms = scratchTerms();
+    terms.assign(strike, years, type, rate);
+
+    kernels().impliedVolatility(terms.terms(strike.data()), market(spot, rate), prices.data(), volatility.data(), 0, strike.size());
+}
+
+// -- ChainPricer
+ChainPricer::ChainPricer(const OptionChain& chain, std::optional<double> rate)
+    : m_chain(chain)
+    , m_rate(rate.value_or(chain.interestRate / 100.0))
+    , m_spot(s_nan)
+{
+    const size_t count = chain.size();
+    m_marketPrice.resize(count);
+    m_volatility.assign(count, s_nan);
+    m_price.assign(count, s_nan);
+    m_delta.assign(count, s_nan);
+    m_gamma.assign(count, s_nan);
+    m_theta.assign(count, s_nan);
+    m_vega.assign(count, s_nan);
+    m_rho.assign(count, s_nan);
+
+    setTime();
+}
+
+void ChainPricer::setTime(clock::time_point now)
+{
+    const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+
+    std::vector<double> years(m_chain.size());
+    for (size_t i = 0; i < years.size(); ++i) {
+        years[i] = (m_chain.expiration[i] - nowMs) / s_millisecondsPerYear;
+    }
+
+    TermColumns terms;
+    terms.assign(m_chain.strike, years, m_chain.type, m_rate);
+    m_logStrike = std::move(terms.logStrike);
+    m_years = std::move(terms.years);
+    m_sqrtYears = std::move(terms.sqrtYears);
+    m_discount = std::move(terms.discount);
+    m_sign = std::move(terms.sign);
+}
+
+void ChainPricer::update(double spot)
+{
+    m_spot = spot;
+
+    for (size_t i = 0; i < m_marketPrice.size(); ++i) {
+        const double bid = m_chain.bid[i];
+        const double ask = m_chain.ask[i];
+        m_marketPrice[i] = bid > 0.0 && ask >= bid ? 0.5 * (bid + ask) : m_chain.mark[i];
+    }
+
+    const Terms terms{ m_chain.strike.data(), m_logStrike.data(), m_years.data(), m_sqrtYears.data(), m_discount.data(), m_sign.data() };
+    const Market underlying = market(spot, m_rate);
+    const Kernels& active = kernels();
+
+    // the previous volatilities are the first guesses
+    active.impliedVolatility(terms, underlying, m_marketPrice.data(), m_volatility.data(), 0, m_volatility.size());
+    active.greeks(terms, underlying, m_volatility.data(), { m_price, m_delta, m_gamma, m_theta, m_vega, m_rho }, 0, m_volatility.size());
+}
+
+bool ChainPricer::update(const LevelOneEquityUpdate& underlying)
+{
+    if (underlying.has(StreamerField::LevelOneEquity::MarkPrice)) {
+        update(underlying[StreamerField::LevelOneEquity::MarkPrice].asPrice());
+        return true;
+    }
+    if (underlying.has(StreamerField::LevelOneEquity::LastPrice)) {
+        update(underlying[StreamerField::LevelOneEquity::LastPrice].asPrice());
+        return true;
+    }
+
+    return false;
+}
+
+}
+
+}
@@ -0,0 +1,121 @@
+#ifndef __OPTION_PRICING_H__
+#define __OPTION_PRICING_H__
+
+#include <optional>
+#include <span>
+#include <vector>
+#include "schwabcpp/optionChain.h"
+#include "schwabcpp/streamerData.h"
+#include "schwabcpp/utils/clock.h"
+
+namespace schwabcpp {
+
+//
+// Black-Scholes over option chain columns (european exercise, no dividends).
+//
+// * Price, greeks and implied volatility are computed for a batch of contracts at once, on AVX2 or
+//   SSE4 kernels when the cpu has them (the ones `Indicators::setIsa(...)` picks).
+//
+// * The implied volatility is a Newton solve kept within a shrinking bracket (a step leaving the
+//   bracket falls back to bisection), so it always converges. The volatility passed in is the first
+//   guess, the previous solution converges in a couple of iterations.
+//
+// * The greeks are in the units of the api: theta per day, vega and rho per point (1%) of
+//   volatility and rate. Volatilities are fractions (0.25), `rate` is continuously compounded.
+//
+// * A contract that can't be priced (expired, or a price outside of the no-arbitrage bounds for
+//   the volatility) gives NaN.
+//
+namespace OptionPricing {
+
+// the columns to write, all of the size of the contracts
+struct Greeks {
+    std::span<double>           price;
+    std::span<double>           delta;
+    std::span<double>           gamma;
+    std::span<double>           theta;
+    std::span<double>           vega;
+    std::span<double>           rho;
+};
+
+// `years` to expiration
+void                            greeks(double spot,
+                                       double rate,
+                                       std::span<const double> strike,
+                                       std::span<const double> years,
+                                       std::span<const OptionContract::Type> type,
+                                       std::span<const double> volatility,
+                                       const Greeks& out);
+
+// `volatility` holds the first guesses (NaN for none) and gets the solutions
+void                            impliedVolatility(double spot,
+                                                  double rate,
+                                                  std::span<const double> strike,
+                                                  std::span<const double> years,
+                                                  std::span<const OptionContract::Type> type,
+                                                  std::span<const double> prices,
+                                                  std::span<double> volatility);
+
+//
+// Reprices a chain as the underlying moves.
+//
+// * What doesn't depend on the underlying (log strike, time, discount) is computed once per
+//   `setTime(...)`, an update only runs the kernels.
+//
+// * `update(...)` solves the volatilities from the contract prices of the chain (mid of bid and
+//   ask, the mark without a market), warm started from the previous ones, then the greeks.
+//
+// * The chain has to outlive the pricer, and keep its contracts (the prices may change).
+//
+class ChainPricer
+{
+public:
+    // the rate of the chain (`interestRate` is in percent) if not given
+    explicit                    ChainPricer(const OptionChain& chain, std::optional<double> rate = std::nullopt);
+
+    // the time to expiration of the contracts, now by default
+    void                        setTime(clock::time_point now = clock::now());
+
+    void                        update(double spot);
+    // the mark of the underlying (the last price without one), false if it has neither
+    bool                        update(const LevelOneEquityUpdate& underlying);
+
+    double                      spot() const { return m_spot; }
+
+    // -- per contract, in the order of the chain
+    std::span<const double>     volatility() const { return m_volatility; }
+    std::span<const double>     price() const { return m_price; }
+    std::span<const double>     delta() const { return m_delta; }
+    std::span<const double>     gamma() const { return m_gamma; }
+    std::span<const double>     theta() const { return m_theta; }
+    std::span<const double>     vega() const { return m_vega; }
+    std::span<const double>     rho() const { return m_rho; }
+
+private:
+    const OptionChain&          m_chain;
+    double                      m_rate;
+    double                      m_spot;
+
+    // -- per contract, don't depend on the underlying
+    std::vector<double>         m_logStrike;
+    std::vector<double>         m_years;
+    std::vector<double>         m_sqrtYears;
+    std::vector<double>         m_discount;
+    std::vector<double>         m_sign;     // 1 call, -1 put
+
+    // -- per update
+    std::vector<double>         m_marketPrice;
+    std::vector<double>         m_volatility;
+    std::vector<double>         m_price;
+    std::vector<double>         m_delta;
+    std::vector<double>         m_gamma;
+    std::vector<double>         m_theta;
+    std::vector<double>         m_vega;
+    std::vector<double>         m_rho;
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+#include "positionDecoder.h"
+#include "utils/jsonScanner.h"
+#include "utils/numberParser.h"
+#include <string>
+#include <unordered_map>
+
+namespace schwabcpp {
+
+namespace {
+
+using Token = JsonScanner::Token;
+
+// the numbers of a position entry
+const static std::unordered_map<std::string_view, double Position::*> s_positionFields = {
+    { "longQuantity",                   &Position::longQuantity },
+    { "shortQuantity",                  &Position::shortQuantity },
+    { "settledLongQuantity",            &Position::settledLongQuantity },
+    { "settledShortQuantity",           &Position::settledShortQuantity },
+    { "averagePrice",                   &Position::averagePrice },
+    { "averageLongPrice",               &Position::averageLongPrice },
+    { "averageShortPrice",              &Position::averageShortPrice },
+    { "marketValue",                    &Position::marketValue },
+    { "maintenanceRequirement",         &Position::maintenanceRequirement },
+    { "currentDayProfitLoss",           &Position::currentDayProfitLoss },
+    { "currentDayCost",                 &Position::currentDayCost },
+    { "longOpenProfitLoss",             &Position::longOpenProfitLoss },
+    { "shortOpenProfitLoss",            &Position::shortOpenProfitLoss },
+};
+
+// a string value, unescaped into `scratch` if it has to
+std::string_view text(const JsonScanner& scanner, std::string& scratch)
+{
+    if (!scanner.hasEscape()) {
+        return scanner.text();
+    }
+    scratch.resize(scanner.text().size());
+    scratch.resize(JsonScanner::unescape(scanner.text(), scratch.data()));
+    return scratch;
+}
+
+// the scanner is positioned right after the '{' of the instrument
+bool decodeInstrument(JsonScanner& scanner, SymbolTable& symbols, Position& position)
+{
+    std::string scratch;
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        if (key == "symbol" && value == Token::String) {
+            position.symbolId = symbols.intern(text(scanner, scratch));
+            position.symbol = symbols.name(position.symbolId);
+        } else if (key == "assetType" && value == Token::String) {
+            position.assetType = Position::toAssetType(scanner.text());
+        } else if (!scanner.skipValue(value)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// the scanner is positioned right after the '{' of the position
+bool decodePosition(JsonScanner& scanner, SymbolTable& symbols, Position& position)
+{
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        if (key == "instrument" && value == Token::BeginObject) {
+            if (!decodeInstrument(scanner, symbols, position)) {
+                return false;
+            }
+            continue;
+        }
+
+        auto field = s_positionFields.find(key);
+        if (field == s_positionFields.end() ||
+            value != Token::Number ||
+            !NumberParser::parseDouble(scanner.text(), position.*(field->second)))
+        {
+            if (!scanner.skipValue(value)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// the scanner is positioned right after the '{' of the securities account
+bool decodeAccount(JsonScanner& scanner, SymbolTable& symbols, std::vector<Position>& out)
+{
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        if (key != "positions" || value != Token::BeginArray) {
+            if (!scanner.skipValue(value)) {
+                return false;
+            }
+            continue;
+        }
+
+        for (value = scanner.next(); value != Token::EndArray; value = scanner.next()) {
+            if (value != Token::BeginObject) {
+                return false;
+            }
+            Position position;
+            if (!decodePosition(scanner, symbols, position)) {
+                return false;
+            }
+            // no instrument, nothing to key it on
+            if (position.symbolId != SymbolTable::InvalidId) {
+                out.push_back(position);
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+
+namespace PositionDecoder {
+
+bool decode(std::string_view response, SymbolTable& symbols, std::vector<Position>& out)
+{
+    // {"securitiesAccount":{..., "positions":[...]}, "aggregatedBalance":{...}}
+    JsonScanner scanner(response);
+    if (scanner.next() != Token::BeginObject) {
+        return false;
+    }
+
+    bool found = false;
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        if (key == "securitiesAccount" && value == Token::BeginObject) {
+            if (!decodeAccount(scanner, symbols, out)) {
+                return false;
+            }
+            found = true;
+        } else if (!scanner.skipValue(value)) {
+            return false;
+        }
+    }
+
+    return found && scanner.next() == Token::End;
+}
+
+}
+
+}
@@ -0,0 +1,26 @@
+#ifndef __POSITION_DECODER_H__
+#define __POSITION_DECODER_H__
+
+#include <string_view>
+#include <vector>
+#include "positionTable.h"
+
+namespace schwabcpp {
+
+//
+// Decodes the positions of an account response (GET /accounts/{hash}?fields=positions) straight
+// into flat positions, in a single pass without building a json tree. The balances are skipped.
+//
+namespace PositionDecoder {
+
+// Appends the positions of the account, the symbols are interned.
+// Returns false if the response is malformed (or not a single account).
+bool                            decode(std::string_view response,
+                                       SymbolTable& symbols,
+                                       std::vector<Position>& out);
+
+}
+
+}
+
+#endif
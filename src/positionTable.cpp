@@ -0,0 +1,137 @@
+#include "positionTable.h"
+#include <algorithm>
+
+namespace schwabcpp {
+
+Position::AssetType Position::toAssetType(std::string_view type)
+{
+    if (type == "EQUITY")                   return AssetType::Equity;
+    if (type == "OPTION")                   return AssetType::Option;
+    if (type == "MUTUAL_FUND")              return AssetType::MutualFund;
+    if (type == "CASH_EQUIVALENT")          return AssetType::CashEquivalent;
+    if (type == "FIXED_INCOME")             return AssetType::FixedIncome;
+    if (type == "FUTURE")                   return AssetType::Future;
+    if (type == "FOREX")                    return AssetType::Forex;
+    if (type == "INDEX")                    return AssetType::Index;
+    if (type == "COLLECTIVE_INVESTMENT")    return AssetType::CollectiveInvestment;
+
+    return AssetType::Unknown;
+}
+
+std::vector<PositionTable::Change> PositionTable::update(std::span<const Position> positions, bool revaluations)
+{
+    ++m_generation;
+
+    std::vector<Change> changes;
+
+    std::vector<SymbolId> previous;
+    previous.swap(m_open);
+    m_open.reserve(positions.size());
+
+    for (const Position& position : positions) {
+        const SymbolId id = position.symbolId;
+        if (id == SymbolTable::InvalidId) {
+            continue;
+        }
+        if (id >= m_rows.size()) {
+            m_rows.resize(id + 1);
+        }
+
+        Row& row = m_rows[id];
+        if (row.generation == m_generation) {
+            // listed twice, the first one stands
+            continue;
+        }
+
+        if (!row.open) {
+            changes.push_back({ id, Change::Type::Opened });
+        } else if (!sameHolding(row.position, position)) {
+            changes.push_back({ id, Change::Type::Changed });
+        } else if (revaluations && !sameValue(row.position, position)) {
+            changes.push_back({ id, Change::Type::Revalued });
+        }
+
+        row.position = position;
+        row.generation = m_generation;
+        row.open = true;
+        row.seen = true;
+        m_open.push_back(id);
+    }
+
+    // what is not in the snapshot anymore is closed
+    for (SymbolId id : previous) {
+        Row& row = m_rows[id];
+        if (row.generation != m_generation) {
+            row.open = false;
+            changes.push_back({ id, Change::Type::Closed });
+        }
+    }
+
+    return changes;
+}
+
+std::optional<PositionTable::Change> PositionTable::apply(const Position& position)
+{
+    const SymbolId id = position.symbolId;
+    if (id == SymbolTable::InvalidId) {
+        return std::nullopt;
+    }
+    if (id >= m_rows.size()) {
+        m_rows.resize(id + 1);
+    }
+
+    Row& row = m_rows[id];
+    if (position.longQuantity <= 0.0 && position.shortQuantity <= 0.0) {
+        if (!row.open) {
+            return std::nullopt;
+        }
+        row.position = position;
+        row.open = false;
+        m_open.erase(std::find(m_open.begin(), m_open.end(), id));
+        return Change{ id, Change::Type::Closed };
+    }
+
+    std::optional<Change> change;
+    if (!row.open) {
+        change = Change{ id, Change::Type::Opened };
+        m_open.push_back(id);
+    } else if (!sameHolding(row.position, position)) {
+        change = Change{ id, Change::Type::Changed };
+    }
+
+    // the generation stays the one of the last snapshot, if the next one doesn't have it it's closed
+    row.position = position;
+    row.open = true;
+    row.seen = true;
+
+    return change;
+}
+
+void PositionTable::clear()
+{
+    m_rows.clear();
+    m_open.clear();
+}
+
+bool PositionTable::sameHolding(const Position& left, const Position& right)
+{
+    return left.longQuantity == right.longQuantity &&
+           left.shortQuantity == right.shortQuantity &&
+           left.settledLongQuantity == right.settledLongQuantity &&
+           left.settledShortQuantity == right.settledShortQuantity &&
+           left.averagePrice == right.averagePrice &&
+           left.averageLongPrice == right.averageLongPrice &&
+           left.averageShortPrice == right.averageShortPrice &&
+           left.currentDayCost == right.currentDayCost;
+}
+
+bool PositionTable::sameValue(const Position& left, const Position& right)
+{
+    return left.marketValue == right.marketValue &&
+           left.maintenanceRequirement == right.maintenanceRequirement &&
+           left.currentDayProfitLoss == right.currentDayProfitLoss &&
+           left.longOpenProfitLoss == right.longOpenProfitLoss &&
+           left.shortOpenProfitLoss == right.shortOpenProfitLoss;
+}
+
+}
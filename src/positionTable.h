@@ -0,0 +1,126 @@
+#ifndef __POSITION_TABLE_H__
+#define __POSITION_TABLE_H__
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "schwabcpp/symbolTable.h"
+
+namespace schwabcpp {
+
+// A position of an account. The quantities are unsigned, a position can be long and short at once.
+struct Position {
+
+    enum class AssetType : char {
+        Equity,
+        Option,
+        MutualFund,
+        CashEquivalent,
+        FixedIncome,
+        Future,
+        Forex,
+        Index,
+        CollectiveInvestment,
+        Unknown,
+    };
+
+    static AssetType            toAssetType(std::string_view type);
+
+    SymbolId                    symbolId = SymbolTable::InvalidId;
+    std::string_view            symbol;         // owned by the symbol table, always valid
+    AssetType                   assetType = AssetType::Unknown;
+
+    double                      longQuantity = 0.0;
+    double                      shortQuantity = 0.0;
+    double                      settledLongQuantity = 0.0;
+    double                      settledShortQuantity = 0.0;
+    double                      averagePrice = 0.0;
+    double                      averageLongPrice = 0.0;
+    double                      averageShortPrice = 0.0;
+
+    double                      marketValue = 0.0;
+    double                      maintenanceRequirement = 0.0;
+    double                      currentDayProfitLoss = 0.0;
+    double                      currentDayCost = 0.0;
+    double                      longOpenProfitLoss = 0.0;
+    double                      shortOpenProfitLoss = 0.0;
+
+    double                      quantity() const { return longQuantity - shortQuantity; }
+};
+
+//
+// The open positions of an account, one row per symbol id (see `SymbolTable`).
+//
+// * Flat: the rows live in one vector indexed by symbol id, finding the position of a symbol
+//   (e.g. of a streamed update, the ids are shared) is an index, not a lookup.
+//
+// * `update(...)` replaces the positions with a newer snapshot of the account and returns what
+//   changed, so a poll costs the caller O(changes) instead of walking the whole account again.
+//   A changed position is one with different quantities or cost. The market value and the
+//   profit/loss move with every price, those are only reported when asked for (`Revalued`).
+//
+// * `apply(...)` moves a single position between two snapshots (e.g. a streamed fill, see
+//   `AccountState`), the next snapshot still has the last word.
+//
+// * A closed position keeps its last values (`last(...)`) until the symbol opens again.
+//
+// * Not thread-safe.
+//
+class PositionTable
+{
+public:
+    struct Change {
+        enum class Type : char {
+            Opened,
+            Closed,
+            Changed,    // quantities or cost
+            Revalued,   // market value or profit/loss only
+        };
+
+        SymbolId                symbolId;
+        Type                    type;
+    };
+
+    size_t                      size() const { return m_open.size(); }
+    bool                        empty() const { return m_open.empty(); }
+
+    // the symbols of the open positions, in the order of the last snapshot (then the applied ones)
+    const std::vector<SymbolId>&
+                                symbols() const { return m_open; }
+
+    bool                        contains(SymbolId id) const { return id < m_rows.size() && m_rows[id].open; }
+    // nullptr if no position is open
+    const Position*             find(SymbolId id) const { return contains(id) ? &m_rows[id].position : nullptr; }
+    // the open position, or the last one of a closed position (nullptr if never seen)
+    const Position*             last(SymbolId id) const { return id < m_rows.size() && m_rows[id].seen ? &m_rows[id].position : nullptr; }
+
+    // `positions` is the whole account (one position per symbol), the missing ones are closed
+    std::vector<Change>         update(std::span<const Position> positions, bool revaluations = false);
+
+    // replaces the position of its symbol, without quantities it is closed (nothing if it wasn't open)
+    std::optional<Change>       apply(const Position& position);
+
+    void                        clear();
+
+private:
+    struct Row {
+        Position                position;
+        uint64_t                generation = 0;     // of the last snapshot it was in
+        bool                    open = false;
+        bool                    seen = false;
+    };
+
+    static bool                 sameHolding(const Position& left, const Position& right);
+    static bool                 sameValue(const Position& left, const Position& right);
+
+private:
+    std::vector<Row>            m_rows;
+    std::vector<SymbolId>       m_open;
+    uint64_t                    m_generation = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,255 @@
+#include "quoteDecoder.h"
+#include "utils/jsonScanner.h"
+#include "utils/numberParser.h"
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+
+namespace schwabcpp {
+
+namespace {
+
+using Token = JsonScanner::Token;
+using Field = StreamerField::LevelOneEquity;
+
+// where each level one equity field lives in the rest quote response
+struct FieldMapping {
+    const char*                     section;
+    const char*                     key;
+    Field                           field;
+};
+
+const static std::vector<FieldMapping> s_levelOneEquityMapping = {
+    { "quote",       "bidPrice",                   Field::BidPrice },
+    { "quote",       "askPrice",                   Field::AskPrice },
+    { "quote",       "lastPrice",                  Field::LastPrice },
+    { "quote",       "bidSize",                    Field::BidSize },
+    { "quote",       "askSize",                    Field::AskSize },
+    { "quote",       "totalVolume",                Field::TotalVolume },
+    { "quote",       "lastSize",                   Field::LastSize },
+    { "quote",       "highPrice",                  Field::HighPrice },
+    { "quote",       "lowPrice",                   Field::LowPrice },
+    { "quote",       "closePrice",                 Field::ClosePrice },
+    { "quote",       "openPrice",                  Field::OpenPrice },
+    { "quote",       "netChange",                  Field::NetChange },
+    { "quote",       "52WeekHigh",                 Field::_52WeekHigh },
+    { "quote",       "52WeekLow",                  Field::_52WeekLow },
+    { "quote",       "securityStatus",             Field::SecurityStatus },
+    { "quote",       "mark",                       Field::MarkPrice },
+    { "quote",       "quoteTime",                  Field::QuoteTimeInLong },
+    { "quote",       "tradeTime",                  Field::TradeTimeInLong },
+    { "quote",       "bidTime",                    Field::BidTime },
+    { "quote",       "askTime",                    Field::AskTime },
+    { "quote",       "askMICId",                   Field::AskMICID },
+    { "quote",       "bidMICId",                   Field::BidMICID },
+    { "quote",       "lastMICId",                  Field::LastMICID },
+    { "quote",       "netPercentChange",           Field::NetPercentChange },
+    { "quote",       "markChange",                 Field::MarkPriceNetChange },
+    { "quote",       "markPercentChange",          Field::MarkPricePresentChange },
+    { "quote",       "postMarketChange",           Field::PostMarketNetChange },
+    { "quote",       "postMarketPercentChange",    Field::PostMarketPresentChange },
+    { "reference",   "exchange",                   Field::ExchangeID },
+    { "reference",   "description",                Field::Description },
+    { "reference",   "exchangeName",               Field::ExchangeName },
+    { "reference",   "htbQuantity",                Field::HardToBorrowQuantity },
+    { "reference",   "htbRate",                    Field::HardToBorrowRate },
+    { "reference",   "isHardToBorrow",             Field::HardToBorrow },
+    { "reference",   "isShortable",                Field::Shortable },
+    { "fundamental", "peRatio",                    Field::PERatio },
+    { "fundamental", "divAmount",                  Field::AnnualDividendAmount },
+    { "fundamental", "divYield",                   Field::DividendYield },
+    { "fundamental", "divPayDate",                 Field::DividendDate },
+    { "regular",     "regularMarketLastPrice",     Field::RegularMarketLastPrice },
+    { "regular",     "regularMarketLastSize",      Field::RegularMarketLastSize },
+    { "regular",     "regularMarketNetChange",     Field::RegularMarketNetChange },
+    { "regular",     "regularMarketPercentChange", Field::RegularMarketPercentChange },
+    { "regular",     "regularMarketTradeTime",     Field::RegularMarketTradeTimeInLong },
+};
+
+// section -> key -> field, for looking the keys up while scanning
+using SectionFields = std::unordered_map<std::string_view, std::unordered_map<std::string_view, Field>>;
+
+const SectionFields& sectionFields()
+{
+    const static SectionFields s_sectionFields = [] {
+        SectionFields result;
+        for (const FieldMapping& mapping : s_levelOneEquityMapping) {
+            result[mapping.section][mapping.key] = mapping.field;
+        }
+        return result;
+    }();
+    return s_sectionFields;
+}
+
+// converts the value token into the field, false if it doesn't fit the kind of the field
+bool decodeValue(JsonScanner& scanner, Token token, Field field, FieldValue& value, std::deque<std::string>& unescaped)
+{
+    value.kind = StreamerField::kindOf(field);
+    switch (value.kind) {
+        case StreamerField::Kind::Double:
+            return token == Token::Number && NumberParser::parseDouble(scanner.text(), value.d);
+        case StreamerField::Kind::Long:
+            // the flags are booleans here, numbers in the stream
+            if (token == Token::True || token == Token::False) {
+                value.l = token == Token::True;
+                return true;
+            }
+            return token == Token::Number && NumberParser::parseLong(scanner.text(), value.l);
+        case StreamerField::Kind::Bool:
+            value.b = token == Token::True;
+            return token == Token::True || token == Token::False;
+        case StreamerField::Kind::String: {
+            if (token != Token::String && token != Token::Number) {
+                return false;
+            }
+            std::string_view text = scanner.text();
+            if (token == Token::String && scanner.hasEscape()) {
+                std::string& scratch = unescaped.emplace_back(text.size(), '\0');
+                scratch.resize(JsonScanner::unescape(text, scratch.data()));
+                text = scratch;
+            }
+            value.s = text.data();
+            value.size = static_cast<uint32_t>(text.size());
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// the scanner is positioned right after the '{' of the symbol's entry
+// `unescaped` keeps the strings with escapes until the quote owns its copy
+bool decodeEntry(JsonScanner& scanner,
+                 LevelOneEquityUpdate& update,
+                 const StreamerField::LevelOneEquityMask& mask,
+                 std::deque<std::string>& unescaped,
+                 bool& isQuote)
+{
+    const SectionFields& fields = sectionFields();
+
+    isQuote = false;
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        auto section = fields.find(scanner.text());
+        Token sectionToken = scanner.next();
+        if (section == fields.end() || sectionToken != Token::BeginObject) {
+            if (!scanner.skipValue(sectionToken)) {
+                return false;
+            }
+            continue;
+        }
+        isQuote = true;
+
+        for (token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+            if (token != Token::String) {
+                return false;
+            }
+            auto field = section->second.find(scanner.text());
+            Token valueToken = scanner.next();
+
+            const size_t index = field != section->second.end() ? static_cast<size_t>(field->second) : 0;
+            if (field == section->second.end() ||
+                !mask.test(index) ||
+                !decodeValue(scanner, valueToken, field->second, update.values[index], unescaped))
+            {
+                if (!scanner.skipValue(valueToken)) {
+                    return false;
+                }
+                continue;
+            }
+            update.fields.set(index);
+        }
+    }
+
+    return true;
+}
+
+}
+
+namespace QuoteDecoder {
+
+std::string sections(const StreamerField::LevelOneEquityMask& mask)
+{
+    std::string result;
+    for (const FieldMapping& mapping : s_levelOneEquityMapping) {
+        if (!mask.test(static_cast<size_t>(mapping.field)) || result.find(mapping.section) != std::string::npos) {
+            continue;
+        }
+        if (!result.empty()) {
+            result += ",";
+        }
+        result += mapping.section;
+    }
+    return result;
+}
+
+bool decode(std::string_view response,
+            SymbolTable& symbols,
+            const StreamerField::LevelOneEquityMask& mask,
+            std::vector<LevelOneEquityQuote>& out)
+{
+    // stamped when received, like the streamer stamps its frames
+    const int64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now().time_since_epoch()).count();
+
+    JsonScanner scanner(response);
+    if (scanner.next() != Token::BeginObject) {
+        return false;
+    }
+
+    LevelOneEquityUpdate update;
+    std::deque<std::string> unescaped;
+    std::string unescapedSymbol;
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view symbol = scanner.text();
+        if (scanner.hasEscape()) {
+            // e.g. "\/ES", interned as "/ES" like the subscribed one
+            unescapedSymbol.resize(symbol.size());
+            unescapedSymbol.resize(JsonScanner::unescape(symbol, unescapedSymbol.data()));
+            symbol = unescapedSymbol;
+        }
+
+        Token entryToken = scanner.next();
+        if (entryToken != Token::BeginObject || symbol == "errors") {
+            if (!scanner.skipValue(entryToken)) {
+                return false;
+            }
+            continue;
+        }
+
+        update.timestamp = timestamp;
+        update.delayed = false;
+        update.fields.reset();
+        unescaped.clear();
+
+        bool isQuote = false;
+        if (!decodeEntry(scanner, update, mask, unescaped, isQuote)) {
+            return false;
+        }
+        if (!isQuote) {
+            continue;
+        }
+
+        update.symbolId = symbols.intern(symbol);
+        update.symbol = symbols.name(update.symbolId);
+        if (mask.test(static_cast<size_t>(Field::Symbol))) {
+            FieldValue& value = update.values[static_cast<size_t>(Field::Symbol)];
+            value.s = update.symbol.data();
+            value.size = static_cast<uint32_t>(update.symbol.size());
+            value.kind = StreamerField::Kind::String;
+            update.fields.set(static_cast<size_t>(Field::Symbol));
+        }
+
+        out.emplace_back(update);
+    }
+
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,37 @@
+#ifndef __QUOTE_DECODER_H__
+#define __QUOTE_DECODER_H__
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "streamerData.h"
+
+namespace schwabcpp {
+
+//
+// Decodes the rest quotes responses (GET /quotes) into the same level one quotes the streamer
+// delivers, so a snapshot and a streamed update can be handled (and cached) alike.
+//
+// * Single pass over the text, the values are converted straight into the fixed layout fields.
+//   Only the fields in the mask are converted.
+//
+// * The response groups the fields in sections (quote, reference, fundamental, regular), a field
+//   is found under the section the streamer field maps to.
+//
+namespace QuoteDecoder {
+
+// the sections of the response that hold the fields in the mask (the `fields` query)
+std::string                     sections(const StreamerField::LevelOneEquityMask& mask);
+
+// Appends a quote per symbol of the response (invalid symbols come back as errors, skipped),
+// the symbols are interned. Returns false if the response is malformed.
+bool                            decode(std::string_view response,
+                                       SymbolTable& symbols,
+                                       const StreamerField::LevelOneEquityMask& mask,
+                                       std::vector<LevelOneEquityQuote>& out);
+
+}
+
+}
+
+#endif
@@ -0,0 +1,234 @@
+#include "rateLimiter.h"
+#include "utils/logger.h"
+#include <algorithm>
+
+namespace schwabcpp {
+
+namespace {
+
+// how often `serve()` is due without waiters
+const static std::chrono::milliseconds s_idleServeInterval(100);
+
+}
+
+RateLimiter::RateLimiter(net::io_context& ioContext, double requestsPerMinute, double burst)
+    : m_ratePerSecond(requestsPerMinute / 60.0)
+    , m_burst(std::max(burst, 1.0))
+    , m_tokens(m_burst)
+    , m_lastRefill(steady::now())
+    , m_timer(ioContext)
+    , m_timerArmed(false)
+{
+}
+
+void RateLimiter::setRate(double requestsPerMinute, double burst)
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard lock(m_mutex);
+        const steady::time_point now = steady::now();
+        refill(now);
+
+        m_ratePerSecond = requestsPerMinute / 60.0;
+        m_burst = std::max(burst, 1.0);
+        m_tokens = std::min(m_tokens, m_burst);
+
+        // might be more generous than before
+        ready = dispatch(now);
+        if (hasWaiters()) {
+            armTimer(now);
+        }
+    }
+
+    m_cv.notify_all();
+    for (auto& fn : ready) {
+        fn();
+    }
+}
+
+void RateLimiter::acquire(Priority priority)
+{
+    std::unique_lock lock(m_mutex);
+
+    bool granted = false;
+    m_waiters[static_cast<size_t>(priority)].push_back({ steady::now(), &granted, {} });
+    ++m_stats[static_cast<size_t>(priority)].queued;
+
+    // The waiting threads serve the queue themselves rather than waiting for the timer,
+    // we might be on the io context thread.
+    std::vector<std::function<void()>> ready = dispatch(steady::now());
+    while (true) {
+        if (!ready.empty()) {
+            lock.unlock();
+            m_cv.notify_all();
+            for (auto& fn : ready) {
+                fn();
+            }
+            ready.clear();
+            lock.lock();
+        }
+
+        if (granted) {
+            break;
+        }
+
+        m_cv.wait_until(lock, nextTokenTime(steady::now()));
+        ready = dispatch(steady::now());
+    }
+
+    // the async waiters behind us
+    if (hasWaiters()) {
+        armTimer(steady::now());
+    }
+}
+
+void RateLimiter::acquireAsync(Priority priority, std::function<void()> fn)
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard lock(m_mutex);
+        const steady::time_point now = steady::now();
+
+        m_waiters[static_cast<size_t>(priority)].push_back({ now, nullptr, std::move(fn) });
+        ++m_stats[static_cast<size_t>(priority)].queued;
+
+        ready = dispatch(now);
+        if (hasWaiters()) {
+            armTimer(now);
+        }
+    }
+
+    m_cv.notify_all();
+    for (auto& fn : ready) {
+        fn();
+    }
+}
+
+RateLimiter::steady::time_point RateLimiter::serve()
+{
+    std::vector<std::function<void()>> ready;
+    steady::time_point next;
+    {
+        std::lock_guard lock(m_mutex);
+        const steady::time_point now = steady::now();
+
+        ready = dispatch(now);
+        // nobody waiting, but someone else might queue
+        next = hasWaiters() ? nextTokenTime(now) : now + s_idleServeInterval;
+    }
+
+    m_cv.notify_all();
+    for (auto& fn : ready) {
+        fn();
+    }
+
+    return next;
+}
+
+RateLimiter::Stats RateLimiter::stats(Priority priority) const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats[static_cast<size_t>(priority)];
+}
+
+void RateLimiter::refill(steady::time_point now)
+{
+    if (m_ratePerSecond <= 0.0) {
+        // unlimited
+        m_tokens = m_burst;
+    } else {
+        const double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+        m_tokens = std::min(m_burst, m_tokens + elapsed * m_ratePerSecond);
+    }
+    m_lastRefill = now;
+}
+
+bool RateLimiter::hasWaiters() const
+{
+    return std::any_of(m_waiters.begin(), m_waiters.end(), [](const auto& waiters) { return !waiters.empty(); });
+}
+
+std::vector<std::function<void()>> RateLimiter::dispatch(steady::time_point now)
+{
+    refill(now);
+
+    std::vector<std::function<void()>> ready;
+    for (size_t priority = 0; priority < m_waiters.size(); ++priority) {
+        std::deque<Waiter>& waiters = m_waiters[priority];
+        Stats& stats = m_stats[priority];
+
+        while (!waiters.empty() && m_tokens >= 1.0) {
+            Waiter& waiter = waiters.front();
+            m_tokens -= 1.0;
+
+            const steady::duration wait = now - waiter.enqueued;
+            ++stats.granted;
+            if (wait > steady::duration::zero()) {
+                ++stats.waited;
+            }
+            stats.totalWait += wait;
+            stats.maxWait = std::max(stats.maxWait, wait);
+            --stats.queued;
+
+            if (waiter.granted) {
+                *waiter.granted = true;
+            } else {
+                ready.push_back(std::move(waiter.fn));
+            }
+            waiters.pop_front();
+        }
+    }
+
+    return ready;
+}
+
+RateLimiter::steady::time_point RateLimiter::nextTokenTime(steady::time_point now) const
+{
+    if (m_tokens >= 1.0 || m_ratePerSecond <= 0.0) {
+        return now;
+    }
+
+    return now + std::chrono::duration_cast<steady::duration>(std::chrono::duration<double>((1.0 - m_tokens) / m_ratePerSecond));
+}
+
+void RateLimiter::armTimer(steady::time_point now)
+{
+    if (m_timerArmed) {
+        return;
+    }
+    m_timerArmed = true;
+
+    m_timer.expires_at(nextTokenTime(now));
+    m_timer.async_wait([weak = weak_from_this()](const boost::system::error_code&) {
+        // the client (and us with it) might be gone
+        if (std::shared_ptr<RateLimiter> self = weak.lock()) {
+            self->onTimer();
+        }
+    });
+}
+
+void RateLimiter::onTimer()
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard lock(m_mutex);
+        m_timerArmed = false;
+
+        const steady::time_point now = steady::now();
+        ready = dispatch(now);
+        if (hasWaiters()) {
+            armTimer(now);
+        }
+    }
+
+    if (!ready.empty()) {
+        LOG_TRACE("Rate limiter released {} queued request(s).", ready.size());
+    }
+
+    m_cv.notify_all();
+    for (auto& fn : ready) {
+        fn();
+    }
+}
+
+}
@@ -0,0 +1,111 @@
+#ifndef __RATE_LIMITER_H__
+#define __RATE_LIMITER_H__
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// NOTE: boost is very heavy, maintain minimal include headers
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+namespace schwabcpp {
+
+namespace net = boost::asio;
+
+//
+// Token bucket shared by all the rest requests of a client (the api limit is per app).
+//
+// * Over budget, the requests are queued instead of sent (and rejected by the server). The queue
+//   is served by priority, so order and account calls get ahead of a bulk history download.
+//
+// * `acquire(...)` blocks the calling thread until its turn, `acquireAsync(...)` calls back on
+//   the io context instead (for the http engine, never blocks the caller). A thread that blocks
+//   the io context until async requests complete has to `serve()` the queue itself.
+//
+// * The wait times are recorded per priority, see `stats(...)`.
+//
+class RateLimiter : public std::enable_shared_from_this<RateLimiter>
+{
+    using steady = std::chrono::steady_clock;
+public:
+    enum class Priority : char {
+        High,       // orders, accounts
+        Normal,     // market data
+        Bulk,       // bulk downloads
+
+        Count,
+    };
+
+    struct Stats {
+        uint64_t                            granted = 0;
+        uint64_t                            waited = 0;     // had to queue
+        steady::duration                    totalWait{ 0 };
+        steady::duration                    maxWait{ 0 };
+        size_t                              queued = 0;     // waiting right now
+
+        steady::duration                    averageWait() const { return granted ? totalWait / static_cast<steady::rep>(granted) : steady::duration::zero(); }
+    };
+
+    // the api allows 120 requests per minute
+                                            RateLimiter(net::io_context& ioContext,
+                                                        double requestsPerMinute = 120.0,
+                                                        double burst = 10.0);
+
+    void                                    setRate(double requestsPerMinute, double burst);
+
+    void                                    acquire(Priority priority);
+    void                                    acquireAsync(Priority priority, std::function<void()> fn);
+
+    // Releases the waiters whose turn came, for a thread that blocks the io context while waiting
+    // for its requests (the timer can't fire then). Returns when to call it again.
+    steady::time_point                      serve();
+
+    Stats                                   stats(Priority priority) const;
+
+private:
+    struct Waiter {
+        steady::time_point                  enqueued;
+        bool*                               granted = nullptr;  // sync waiter
+        std::function<void()>               fn;                 // async waiter
+    };
+
+    // -- all with the lock held
+    void                                    refill(steady::time_point now);
+    bool                                    hasWaiters() const;
+    // hands the tokens to the waiters in priority order, returns the async ones to call
+    std::vector<std::function<void()>>      dispatch(steady::time_point now);
+    steady::time_point                      nextTokenTime(steady::time_point now) const;
+    void                                    armTimer(steady::time_point now);
+
+    void                                    onTimer();
+
+private:
+    double                                  m_ratePerSecond;
+    double                                  m_burst;
+    double                                  m_tokens;
+    steady::time_point                      m_lastRefill;
+
+    std::array<std::deque<Waiter>,
+        static_cast<size_t>(Priority::Count)>
+                                            m_waiters;
+    std::array<Stats,
+        static_cast<size_t>(Priority::Count)>
+                                            m_stats;
+
+    net::steady_timer                       m_timer;
+    bool                                    m_timerArmed;
+
+    mutable std::mutex                      m_mutex;
+    std::condition_variable                 m_cv;
+};
+
+}
+
+#endif
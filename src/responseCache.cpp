@@ -0,0 +1,173 @@
+#include "responseCache.h"
+#include <future>
+
+namespace schwabcpp {
+
+namespace {
+
+// expired entries are swept once the cache grows past this
+const static size_t s_sweepThreshold = 256;
+
+}
+
+ResponseCache::Value ResponseCache::get(const std::string& key, std::chrono::milliseconds ttl, FetchFn fetch)
+{
+    // in case we join an in flight fetch
+    std::promise<Value> promise;
+    std::future<Value> future = promise.get_future();
+    DoneFn waiter = [&promise](std::exception_ptr error, Value value) {
+        if (error) {
+            promise.set_exception(error);
+        } else {
+            promise.set_value(std::move(value));
+        }
+    };
+
+    bool joined = false;
+    std::shared_ptr<Flight> flight;
+    {
+        std::lock_guard lock(m_mutex);
+
+        Value value;
+        switch (lookup(key, value, std::move(waiter), flight)) {
+            case Lookup::Hit: return value;
+            case Lookup::Joined: joined = true; break;
+            case Lookup::Fetch: break;
+        }
+    }
+
+    if (joined) {
+        // someone else is on it
+        return future.get();
+    }
+
+    Value value;
+    try {
+        value = fetch();
+    } catch (...) {
+        complete(key, ttl, flight, std::current_exception(), nullptr);
+        throw;
+    }
+    complete(key, ttl, flight, nullptr, value);
+
+    return value;
+}
+
+void ResponseCache::getAsync(const std::string& key, std::chrono::milliseconds ttl, AsyncFetchFn fetch, DoneFn done)
+{
+    Value value;
+    Lookup result;
+    std::shared_ptr<Flight> flight;
+    {
+        std::lock_guard lock(m_mutex);
+        result = lookup(key, value, done, flight);
+    }
+
+    switch (result) {
+        case Lookup::Hit: done(nullptr, std::move(value)); return;
+        case Lookup::Joined: return;
+        case Lookup::Fetch: break;
+    }
+
+    fetch([this, key, ttl, flight, done = std::move(done)](std::exception_ptr error, Value value) {
+        complete(key, ttl, flight, error, value);
+        done(error, std::move(value));
+    });
+}
+
+void ResponseCache::clear()
+{
+    std::lock_guard lock(m_mutex);
+
+    ++m_generation;
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.flight) {
+            it->second.value = nullptr;
+            ++it;
+        } else {
+            it = m_entries.erase(it);
+        }
+    }
+}
+
+ResponseCache::Stats ResponseCache::stats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+ResponseCache::Lookup ResponseCache::lookup(const std::string& key, Value& value, DoneFn waiter,
+                                            std::shared_ptr<Flight>& flight)
+{
+    const steady::time_point now = steady::now();
+
+    Entry& entry = m_entries[key];
+    if (entry.value && entry.expiry > now) {
+        ++m_stats.hits;
+        value = entry.value;
+        return Lookup::Hit;
+    }
+
+    // a fetch started before a `clear()` is stale, fetch again (it still completes its own waiters)
+    if (entry.flight && entry.flight->generation == m_generation) {
+        ++m_stats.coalesced;
+        entry.flight->waiters.push_back(std::move(waiter));
+        return Lookup::Joined;
+    }
+
+    ++m_stats.misses;
+    entry.flight = std::make_shared<Flight>();
+    entry.flight->generation = m_generation;
+    flight = entry.flight;
+
+    if (m_entries.size() > s_sweepThreshold) {
+        sweep(now);
+    }
+
+    return Lookup::Fetch;
+}
+
+void ResponseCache::sweep(steady::time_point now)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (!it->second.flight && it->second.expiry <= now) {
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ResponseCache::complete(const std::string& key,
+                             std::chrono::milliseconds ttl,
+                             const std::shared_ptr<Flight>& flight,
+                             std::exception_ptr error,
+                             Value value)
+{
+    std::vector<DoneFn> waiters;
+    {
+        std::lock_guard lock(m_mutex);
+
+        waiters.swap(flight->waiters);
+
+        // a newer fetch (after a `clear()`) owns the entry now
+        auto it = m_entries.find(key);
+        if (it != m_entries.end() && it->second.flight == flight) {
+            Entry& entry = it->second;
+            entry.flight = nullptr;
+
+            if (!error && value && flight->generation == m_generation) {
+                entry.value = value;
+                entry.expiry = steady::now() + ttl;
+            } else if (!entry.value || entry.expiry <= steady::now()) {
+                m_entries.erase(it);
+            }
+        }
+    }
+
+    for (DoneFn& waiter : waiters) {
+        waiter(error, value);
+    }
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef __RESPONSE_CACHE_H__
+#define __RESPONSE_CACHE_H__
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace schwabcpp {
+
+//
+// Parsed rest responses, keyed by request (url and queries), each kept for the ttl of its endpoint.
+//
+// * Concurrent identical requests are coalesced: the first one fetches, the others wait for its
+//   result instead of going to the network (singleflight). Sync and async callers share the same
+//   in flight fetch, they all get the one parsed value.
+//
+// * Failed fetches (exception or null value) are not cached, the callers waiting on it get the
+//   failure too.
+//
+// * The values are type erased, the key (endpoint) decides the type. (Thread-Safe)
+//
+class ResponseCache
+{
+    using steady = std::chrono::steady_clock;
+public:
+    using Value = std::shared_ptr<const void>;
+    using DoneFn = std::function<void(std::exception_ptr, Value)>;
+    using FetchFn = std::function<Value()>;
+    using AsyncFetchFn = std::function<void(DoneFn)>;
+
+    struct Stats {
+        uint64_t                            hits = 0;
+        uint64_t                            misses = 0;
+        uint64_t                            coalesced = 0;  // joined an in flight fetch
+    };
+
+    // blocks, runs `fetch` on the calling thread if it has to
+    Value                                   get(const std::string& key, std::chrono::milliseconds ttl, FetchFn fetch);
+    // `done` runs on the thread completing the fetch (or right away on a hit)
+    void                                    getAsync(const std::string& key, std::chrono::milliseconds ttl, AsyncFetchFn fetch, DoneFn done);
+
+    // Drops the cached values. The fetches in flight are not cached when they complete, and the
+    // requests after this don't join them, they fetch again.
+    void                                    clear();
+
+    Stats                                   stats() const;
+
+private:
+    // a fetch in flight and the callers that joined it
+    struct Flight {
+        uint64_t                            generation = 0;  // of the cache when it started
+        std::vector<DoneFn>                 waiters;
+    };
+
+    struct Entry {
+        Value                               value;
+        steady::time_point                  expiry;
+        std::shared_ptr<Flight>             flight;  // the latest fetch, while in flight
+    };
+
+    enum class Lookup : char {
+        Hit,
+        Joined,
+        Fetch,
+    };
+
+    // with the lock held, `flight` is the fetch to start on Lookup::Fetch
+    Lookup                                  lookup(const std::string& key, Value& value, DoneFn waiter,
+                                                   std::shared_ptr<Flight>& flight);
+    void                                    sweep(steady::time_point now);
+
+    void                                    complete(const std::string& key,
+                                                     std::chrono::milliseconds ttl,
+                                                     const std::shared_ptr<Flight>& flight,
+                                                     std::exception_ptr error,
+                                                     Value value);
+
+private:
+    std::unordered_map<std::string, Entry>  m_entries;
+    uint64_t                                m_generation = 0;
+    Stats                                   m_stats;
+    mutable std::mutex                      m_mutex;
+};
+
+}
+
+#endif
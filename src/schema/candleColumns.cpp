@@ -0,0 +1,119 @@
+#include "candleColumns.h"
+
+namespace schwabcpp {
+
+CandleColumnsView CandleColumnsView::subview(size_t offset, size_t count) const
+{
+    return {
+        datetime.subspan(offset, count),
+        open.subspan(offset, count),
+        high.subspan(offset, count),
+        low.subspan(offset, count),
+        close.subspan(offset, count),
+        volume.subspan(offset, count),
+    };
+}
+
+void CandleColumns::reserve(size_t count)
+{
+    datetime.reserve(count);
+    open.reserve(count);
+    high.reserve(count);
+    low.reserve(count);
+    close.reserve(count);
+    volume.reserve(count);
+}
+
+void CandleColumns::push_back(const Candle& candle)
+{
+    datetime.push_back(candle.datetime);
+    open.push_back(candle.open);
+    high.push_back(candle.high);
+    low.push_back(candle.low);
+    close.push_back(candle.close);
+    volume.push_back(candle.volume);
+}
+
+Candle CandleColumns::at(size_t index) const
+{
+    return {
+        .close = close.at(index),
+        .datetime = datetime.at(index),
+        .high = high.at(index),
+        .low = low.at(index),
+        .open = open.at(index),
+        .volume = volume.at(index),
+    };
+}
+
+CandleColumnsView CandleColumns::view() const
+{
+    return { datetime, open, high, low, close, volume };
+}
+
+CandleColumns CandleColumns::fromCandleList(const CandleList& list)
+{
+    CandleColumns result;
+    result.reserve(list.candles.size());
+    for (const Candle& candle : list.candles) {
+        result.push_back(candle);
+    }
+    result.empty = list.empty;
+    result.previousClose = list.previousClose;
+    result.previousCloseDate = list.previousCloseDate;
+    result.symbol = list.symbol;
+
+    return result;
+}
+
+CandleList CandleColumns::toCandleList() const
+{
+    CandleList result;
+    result.candles.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        result.candles.push_back(at(i));
+    }
+    result.empty = empty;
+    result.previousClose = previousClose;
+    result.previousCloseDate = previousCloseDate;
+    result.symbol = symbol;
+
+    return result;
+}
+
+void CandleColumns::to_json(json &j, const CandleColumns &self)
+{
+    // same as the candle list
+    j = self.toCandleList();
+}
+
+void CandleColumns::from_json(const json &j, CandleColumns &data)
+{
+    j.at("symbol").get_to(data.symbol);
+    j.at("empty").get_to(data.empty);
+
+    // straight into the columns, no candle list in between
+    const json& candles = j.at("candles");
+    data.reserve(candles.size());
+    for (const json& candle : candles) {
+        data.close.push_back(candle.at("close").get<double>());
+        data.datetime.push_back(candle.at("datetime").get<int64_t>());
+        data.high.push_back(candle.at("high").get<double>());
+        data.low.push_back(candle.at("low").get<double>());
+        data.open.push_back(candle.at("open").get<double>());
+        data.volume.push_back(candle.at("volume").get<int64_t>());
+    }
+
+    if (j.contains("previousClose")) {
+        data.previousClose = j.at("previousClose");
+    } else {
+        data.previousClose = std::nullopt;
+    }
+    if (j.contains("previousCloseDate")) {
+        data.previousCloseDate = j.at("previousCloseDate");
+    } else {
+        data.previousCloseDate = std::nullopt;
+    }
+}
+
+}
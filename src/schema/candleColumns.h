@@ -0,0 +1,64 @@
+#ifndef __CANDLE_COLUMNS_H__
+#define __CANDLE_COLUMNS_H__
+
+#include "registrationHelper.h"
+#include "schwabcpp/schema/candleList.h"
+#include <span>
+#include <vector>
+
+namespace schwabcpp {
+
+using json = nlohmann::json;
+
+// Non-owning view of candle columns (from `CandleColumns` or a mapped `CandleStore::Series`).
+struct CandleColumnsView {
+
+    std::span<const int64_t>    datetime;
+    std::span<const double>     open;
+    std::span<const double>     high;
+    std::span<const double>     low;
+    std::span<const double>     close;
+    std::span<const int64_t>    volume;
+
+    size_t                      size() const { return datetime.size(); }
+
+    CandleColumnsView           subview(size_t offset, size_t count) const;
+};
+
+// The candles of a `CandleList`, one array per field (for vectorized analytics).
+struct CandleColumns {
+
+    std::vector<int64_t>        datetime;
+    std::vector<double>         open;
+    std::vector<double>         high;
+    std::vector<double>         low;
+    std::vector<double>         close;
+    std::vector<int64_t>        volume;
+
+    bool                        empty = true;
+    std::optional<double>       previousClose;
+    std::optional<clock::rep>   previousCloseDate;
+    std::string                 symbol;
+
+    size_t                      size() const { return datetime.size(); }
+    void                        reserve(size_t count);
+    void                        push_back(const Candle& candle);
+    Candle                      at(size_t index) const;
+
+    CandleColumnsView           view() const;
+
+    // -- conversions
+    static CandleColumns        fromCandleList(const CandleList& list);
+    CandleList                  toCandleList() const;
+
+static void to_json(json& j, const CandleColumns& self);
+static void from_json(const json& j, CandleColumns& data);
+};
+
+}
+
+// register with the nlohmann::json library
+// this should be outside of our schwabcpp namespace
+REGISTER_TO_JSON(schwabcpp::CandleColumns)
+
+#endif
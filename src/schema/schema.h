@@ -4,6 +4,7 @@
 #include "schwabcpp/schema/accessTokenResponse.h"
 #include "schwabcpp/schema/accountSummary.h"
 #include "schwabcpp/schema/candle.h"
+#include "schwabcpp/schema/candleColumns.h"
 #include "schwabcpp/schema/candleList.h"
 #include "schwabcpp/schema/refreshTokenResponse.h"
 #include "schwabcpp/schema/userPreference.h"
@@ -1,5 +1,7 @@
 #include "streamer.h"
 #include "client.h"
+#include "clientContext.h"
+#include "schwabcpp/event/streamerGapEvent.h"
 #include "nlohmann/json.hpp"
 #include "utils/logger.h"
 
@@ -7,6 +9,79 @@ namespace schwabcpp {
 
 using json = nlohmann::json;
 
+namespace {
+
+// ACCT_ACTIVITY has a single key, every linked account is streamed
+const static std::string s_accountActivityKey = "Account Activity";
+const static std::string s_accountActivityFields = "0,1,2,3";
+
+// "LEVELONE_EQUITIES ADD #12", what the logs say of a request (never the parameters, the login
+// has the token). The keys are dumped sorted, the command before the parameters, the request id
+// and the service after them.
+std::string describeRequest(std::string_view request)
+{
+    auto value = [request](std::string_view key, bool last) -> std::string_view {
+        size_t pos = last ? request.rfind(key) : request.find(key);
+        if (pos == std::string_view::npos) {
+            return "?";
+        }
+        pos += key.size();
+        size_t end = request.find_first_of("\",}", pos);
+        return request.substr(pos, end == std::string_view::npos ? std::string_view::npos : end - pos);
+    };
+
+    std::string result(value("\"service\":\"", true));
+    result += ' ';
+    result += value("\"command\":\"", false);
+    result += " #";
+    result += value("\"requestid\":", true);
+
+    return result;
+}
+
+// Converts rest quotes to the format of the streamed level one equity data. This way the raw data
+// handler doesn't need to care where the data came from (the typed handlers get the quotes as they are).
+std::string levelOneEquityQuotesToData(const std::vector<LevelOneEquityQuote>& quotes)
+{
+    std::vector<json> content;
+    content.reserve(quotes.size());
+    for (const LevelOneEquityQuote& quote : quotes) {
+        json entry;
+        entry["key"] = quote.symbol;
+        entry["delayed"] = quote.delayed;
+        for (size_t i = 0; i < quote.values.size(); ++i) {
+            if (!quote.fields.test(i) || i == static_cast<size_t>(StreamerField::LevelOneEquity::Symbol)) {
+                continue;
+            }
+
+            const FieldValue& value = quote.values[i];
+            json& field = entry[std::to_string(i)];
+            switch (value.kind) {
+                case StreamerField::Kind::Double: field = value.asDouble(); break;
+                case StreamerField::Kind::Long: field = value.asLong(); break;
+                case StreamerField::Kind::Bool: field = value.asBool(); break;
+                case StreamerField::Kind::String: field = std::string(value.asString()); break;
+                case StreamerField::Kind::Fixed: field = value.asPrice(); break;
+                case StreamerField::Kind::None: break;
+            }
+        }
+        content.push_back(std::move(entry));
+    }
+
+    json data;
+    data["service"] = Streamer::requestServiceType2String(Streamer::RequestServiceType::LEVELONE_EQUITIES);
+    data["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now().time_since_epoch()).count();
+    data["command"] = "SUBS";
+    data["content"] = content;
+
+    json result;
+    result["data"] = std::vector<json>{ data };
+
+    return std::move(result.dump(-1));
+}
+
+}
+
 auto defaultStreamerDataHandler = [](const std::string& data) {
     try {
         LOG_INFO("Data: \n{}", data.empty() ? "" : json::parse(data).dump(4));
@@ -18,11 +93,14 @@ auto defaultStreamerDataHandler = [](const std::string& data) {
 Streamer::Streamer(Client* client)
     : m_client(client)
     , m_requestId(0)
-    , m_dataHandler(defaultStreamerDataHandler)
+    , m_decoder(m_symbols)
+    , m_quoteWaiterCount(0)
     , m_state(CVState::Inactive)
 {
     LOG_DEBUG("Initializing streamer...");
 
+    m_decoder.setLevelOneEquityHandler(std::bind(&Streamer::onLevelOneEquityUpdate, this, std::placeholders::_1));
+
     // get the streamer info
     try {
         m_streamerInfo = m_client->getStreamerInfo();
@@ -35,11 +113,6 @@ Streamer::Streamer(Client* client)
 Streamer::~Streamer()
 {
     stop();
-
-    // join here
-    if (m_requestDaemon.joinable()) {
-        m_requestDaemon.join();
-    }
 }
 
 void Streamer::updateStreamerInfo(const UserPreference::StreamerInfo& info)
@@ -53,21 +126,24 @@ void Streamer::start()
 {
     LOG_DEBUG("Starting streamer...");
 
-    // create the websocket
-    m_websocket = std::make_unique<Websocket>(m_streamerInfo.streamerSocketUrl);
+    // set the running flag before anything gets a chance to run on the io context
+    {
+        std::lock_guard lock(m_mutex_state);
+        m_state.setFlag(CVState::Running, true);
+    }
+
+    // create the websocket on the shared io context
+    m_websocket = std::make_unique<Websocket>(
+        m_streamerInfo.streamerSocketUrl,
+        m_client->m_context->ioContext(),
+        m_client->m_context->sslContext(),
+        m_client->m_context->ioOptions()
+    );
     // connect and login
     m_websocket->asyncConnect(
         std::bind(&Streamer::onWebsocketConnected, this),
-        std::bind(&Streamer::onWebsocketReconnected, this)
-    );
-
-    // set the run sender daemon flag
-    // don't need mutex here, sender not launched yet
-    m_state.setFlag(CVState::RunRequestDaemon, true);
-
-    // launch the request daemon
-    m_requestDaemon = std::thread(
-        [this] { sendRequests(); }
+        std::bind(&Streamer::onWebsocketReconnected, this),
+        std::bind(&Streamer::onWebsocketDisconnected, this)
     );
 }
 
@@ -95,6 +171,338 @@ void Streamer::onWebsocketReconnected()
     }
 }
 
+void Streamer::onWebsocketDisconnected()
+{
+    // everything we subscribed goes stale until the snapshot after reconnection
+    std::lock_guard lock(m_mutex_subscription);
+    if (m_staleSymbols.empty() && !m_staleAccounts) {
+        m_gapStart = std::chrono::steady_clock::now();
+    }
+    m_staleSymbols.insert(m_levelOneEquitySymbols.begin(), m_levelOneEquitySymbols.end());
+    m_staleAccounts = m_staleAccounts || m_accountActivity;
+
+    LOG_WARN("Streamer disconnected, {} symbol(s) marked stale{}.",
+             m_staleSymbols.size(), m_staleAccounts ? ", account activity lost" : "");
+}
+
+void Streamer::startReceiving()
+{
+    std::vector<std::string> staleSymbols;
+    bool staleAccounts = false;
+    {
+        std::lock_guard lock(m_mutex_subscription);
+        staleSymbols.assign(m_staleSymbols.begin(), m_staleSymbols.end());
+        staleAccounts = m_staleAccounts;
+    }
+
+    if (staleSymbols.empty() && !staleAccounts) {
+        m_websocket->startReceiverLoop(std::bind(&Streamer::onFrame, this, std::placeholders::_1));
+        return;
+    }
+
+    // The rest calls are blocking, keep them off the io context thread.
+    // The live data that arrives meanwhile waits in the socket until the receiver loop starts.
+    // The thread is swapped under the state lock, `stop()` takes it the same way (and no new one
+    // starts after that). The joins happen outside of the lock, the recovery takes it too.
+    std::thread previous;
+    {
+        std::lock_guard lock(m_mutex_state);
+        if (!m_state.testFlag(CVState::Running)) {
+            return;
+        }
+        previous = std::move(m_recoveryThread);
+        m_recoveryThread = std::thread(
+            [this, symbols = std::move(staleSymbols), staleAccounts] { recoverStaleSymbols(symbols, staleAccounts); }
+        );
+    }
+    if (previous.joinable()) {
+        previous.join();
+    }
+}
+
+void Streamer::recoverStaleSymbols(std::vector<std::string> symbols, bool staleAccounts)
+{
+    LOG_DEBUG("Recovering {} stale symbol(s)...", symbols.size());
+
+    auto recoveryStart = std::chrono::steady_clock::now();
+
+    std::set<StreamerField::LevelOneEquity> fields;
+    {
+        std::lock_guard lock(m_mutex_subscription);
+        fields = m_levelOneEquityFields;
+    }
+
+    // one snapshot, the client fetches the batches concurrently
+    std::vector<LevelOneEquityQuote> quotes;
+    if (!symbols.empty()) {
+        quotes = m_client->quotes(
+            symbols,
+            std::vector<StreamerField::LevelOneEquity>(fields.begin(), fields.end())
+        );
+    }
+    size_t recovered = quotes.size();
+
+    {
+        std::lock_guard lock(m_mutex_state);
+        if (!m_state.testFlag(CVState::Running)) {
+            LOG_DEBUG("Streamer stopped, gap recovery aborted.");
+            return;
+        }
+    }
+
+    // the quotes go to the typed handlers as they are, the raw data handler gets them as a frame
+    if (!quotes.empty()) {
+        std::string data;
+        if (m_dataHandler) {
+            data = levelOneEquityQuotesToData(quotes);
+        }
+
+        for (LevelOneEquityQuote& quote : quotes) {
+            if (m_decoder.conform(quote)) {
+                onLevelOneEquityUpdate(quote);
+            }
+        }
+
+        if (m_dataHandler) {
+            m_dataHandler(data);
+        } else if (!decodes()) {
+            defaultStreamerDataHandler(levelOneEquityQuotesToData(quotes));
+        }
+    }
+
+    auto recoveryEnd = std::chrono::steady_clock::now();
+
+    // the symbols are fresh again
+    std::chrono::steady_clock::time_point gapStart;
+    {
+        std::lock_guard lock(m_mutex_subscription);
+        for (const std::string& symbol : symbols) {
+            m_staleSymbols.erase(symbol);
+        }
+        gapStart = m_gapStart;
+    }
+
+    // live data resumes
+    {
+        std::lock_guard lock(m_mutex_state);
+        if (!m_state.testFlag(CVState::Running)) {
+            return;
+        }
+    }
+    m_websocket->startReceiverLoop(std::bind(&Streamer::onFrame, this, std::placeholders::_1));
+
+    // The fills of the gap are lost, the positions are replaced with a snapshot. Live data comes
+    // first here, the fills streamed meanwhile are either in the snapshot or applied after it.
+    if (staleAccounts) {
+        m_client->reconcileAccountState();
+
+        std::lock_guard lock(m_mutex_subscription);
+        m_staleAccounts = false;
+    }
+
+    // report
+    StreamerGapEvent event(recoveryEnd - gapStart, recoveryEnd - recoveryStart, symbols.size(), recovered);
+
+    if (m_client->m_eventCallback) {
+        m_client->m_eventCallback(event);
+    }
+
+    if (!event.getHandled()) {
+        LOG_INFO("Streamer recovered from a {} ms gap. Reseeded {}/{} symbol(s) in {} ms.",
+                 std::chrono::duration_cast<std::chrono::milliseconds>(event.getGapDuration()).count(),
+                 event.getRecoveredSymbolCount(),
+                 event.getStaleSymbolCount(),
+                 std::chrono::duration_cast<std::chrono::milliseconds>(event.getRecoveryDuration()).count());
+    }
+}
+
+void Streamer::onData(const std::string& data, std::shared_ptr<const std::string> owner)
+{
+    bool decoded = decodes();
+    if (decoded) {
+        if (m_dispatcher) {
+            m_dispatcher->beginFrame(data, std::move(owner));
+            m_decoder.decode(data);
+            m_dispatcher->endFrame();
+        } else {
+            m_decoder.decode(data);
+        }
+    }
+
+    if (m_dataHandler) {
+        m_dataHandler(data);
+    } else if (!decoded) {
+        defaultStreamerDataHandler(data);
+    }
+}
+
+bool Streamer::decodes() const
+{
+    return m_levelOneEquityHandler ||
+           m_levelOneOptionHandler ||
+           m_levelOneFuturesHandler ||
+           m_levelOneForexHandler ||
+           m_accountActivityHandler ||
+           m_quoteWaiterCount > 0;
+}
+
+void Streamer::setLevelOneEquityHandler(StreamerDecoder::LevelOneEquityHandler handler)
+{
+    m_levelOneEquityHandler = handler;
+    if (m_dispatcher) {
+        m_dispatcher->setLevelOneEquityHandler(handler);
+    }
+}
+
+void Streamer::setLevelOneOptionHandler(StreamerDecoder::LevelOneOptionHandler handler)
+{
+    m_levelOneOptionHandler = handler;
+    m_decoder.setLevelOneOptionHandler(decoderHandler(m_levelOneOptionHandler));
+    if (m_dispatcher) {
+        m_dispatcher->setLevelOneOptionHandler(handler);
+    }
+}
+
+void Streamer::setLevelOneFuturesHandler(StreamerDecoder::LevelOneFuturesHandler handler)
+{
+    m_levelOneFuturesHandler = handler;
+    m_decoder.setLevelOneFuturesHandler(decoderHandler(m_levelOneFuturesHandler));
+    if (m_dispatcher) {
+        m_dispatcher->setLevelOneFuturesHandler(handler);
+    }
+}
+
+void Streamer::setLevelOneForexHandler(StreamerDecoder::LevelOneForexHandler handler)
+{
+    m_levelOneForexHandler = handler;
+    m_decoder.setLevelOneForexHandler(decoderHandler(m_levelOneForexHandler));
+    if (m_dispatcher) {
+        m_dispatcher->setLevelOneForexHandler(handler);
+    }
+}
+
+void Streamer::setAccountActivityHandler(StreamerDecoder::AccountActivityHandler handler)
+{
+    // not dispatched, the events of an order stay in order on the io context thread
+    m_accountActivityHandler = handler;
+    m_decoder.setAccountActivityHandler(handler);
+}
+
+template <typename Update>
+std::function<void(const Update&)> Streamer::decoderHandler(const std::function<void(const Update&)>& handler)
+{
+    if (!handler) {
+        return nullptr;
+    }
+
+    // the handler is a member, it outlives the decoder
+    return [this, &handler](const Update& update) {
+        if (m_dispatcher) {
+            m_dispatcher->post(update);
+        } else {
+            handler(update);
+        }
+    };
+}
+
+void Streamer::setDispatcherWorkers(size_t workers)
+{
+    // the io context thread uses the dispatcher while streaming, it can't be swapped under it
+    {
+        std::lock_guard lock(m_mutex_state);
+        if (m_state.testFlag(CVState::Running)) {
+            LOG_ERROR("Streamer running, the dispatcher workers can only be set before starting it.");
+            return;
+        }
+    }
+
+    // the queued updates of the old dispatcher are dropped
+    m_dispatcher.reset();
+    if (workers) {
+        m_dispatcher = std::make_unique<StreamerDispatcher>(workers);
+        m_dispatcher->setLevelOneEquityHandler(m_levelOneEquityHandler);
+        m_dispatcher->setLevelOneOptionHandler(m_levelOneOptionHandler);
+        m_dispatcher->setLevelOneFuturesHandler(m_levelOneFuturesHandler);
+        m_dispatcher->setLevelOneForexHandler(m_levelOneForexHandler);
+    }
+}
+
+std::vector<StreamerDispatcher::WorkerStats> Streamer::getDispatcherStats() const
+{
+    return m_dispatcher ? m_dispatcher->stats() : std::vector<StreamerDispatcher::WorkerStats>{};
+}
+
+void Streamer::onLevelOneEquityUpdate(const LevelOneEquityUpdate& update)
+{
+    // one shot waiters first
+    if (m_quoteWaiterCount > 0) {
+        std::vector<QuoteWaiterFn> waiters;
+        {
+            std::lock_guard lock(m_mutex_quoteWaiters);
+            auto it = m_quoteWaiters.find(update.symbolId);
+            if (it != m_quoteWaiters.end()) {
+                waiters.swap(it->second);
+                m_quoteWaiters.erase(it);
+                m_quoteWaiterCount -= waiters.size();
+            }
+        }
+        if (!waiters.empty()) {
+            LevelOneEquityQuote quote(update);
+            for (QuoteWaiterFn& waiter : waiters) {
+                waiter(nullptr, quote);
+            }
+        }
+    }
+
+    if (m_levelOneEquityHandler) {
+        if (m_dispatcher) {
+            m_dispatcher->post(update);
+        } else {
+            m_levelOneEquityHandler(update);
+        }
+    }
+}
+
+void Streamer::addQuoteWaiter(const std::string& symbol, QuoteWaiterFn fn)
+{
+    SymbolId id = m_symbols.intern(symbol);
+
+    std::lock_guard lock(m_mutex_quoteWaiters);
+    m_quoteWaiters[id].push_back(std::move(fn));
+    ++m_quoteWaiterCount;
+}
+
+void Streamer::failQuoteWaiters()
+{
+    std::unordered_map<SymbolId, std::vector<QuoteWaiterFn>> waiters;
+    {
+        std::lock_guard lock(m_mutex_quoteWaiters);
+        waiters.swap(m_quoteWaiters);
+        m_quoteWaiterCount = 0;
+    }
+
+    if (waiters.empty()) {
+        return;
+    }
+
+    std::exception_ptr error = std::make_exception_ptr(std::runtime_error("Streamer stopped."));
+    for (auto& [id, fns] : waiters) {
+        for (QuoteWaiterFn& fn : fns) {
+            fn(error, LevelOneEquityQuote{});
+        }
+    }
+}
+
+void Streamer::setSymbolFilter(const std::vector<std::string>& symbols)
+{
+    std::vector<SymbolId> ids;
+    ids.reserve(symbols.size());
+    for (const std::string& symbol : symbols) {
+        ids.push_back(m_symbols.intern(symbol));
+    }
+    m_decoder.setSymbolFilter(ids);
+}
+
 void Streamer::startLoginAndReceiveProcedure()
 {
     // 1. login
@@ -103,7 +511,14 @@ void Streamer::startLoginAndReceiveProcedure()
     // queue the login request
     m_websocket->asyncSend(
         constructLoginRequest(),
-        [] { LOG_DEBUG("Streamer logging in..."); }
+        [](beast::error_code ec) {
+            if (ec) {
+                // the response handler below fails too and retries
+                LOG_ERROR("Streamer login request lost. Error: {}", ec.message());
+            } else {
+                LOG_DEBUG("Streamer logging in...");
+            }
+        }
     );
 
     // queue the login response handler
@@ -138,15 +553,18 @@ void Streamer::startLoginAndReceiveProcedure()
                                 } else {
                                     LOG_DEBUG("Successfully logged in.");
 
-                                    // notify the status
+                                    // update the status
                                     {
                                         std::lock_guard<std::mutex> lock(m_mutex_state);
                                         m_state.setState(CVState::Active);
-                                        m_cv.notify_all();
                                     }
 
+                                    // send whatever got queued before we logged in
+                                    flushRequests();
+
                                     // now that we're logged in, start the receiver loop
-                                    m_websocket->startReceiverLoop(m_dataHandler);
+                                    // (after reseeding the stale symbols if we just reconnected)
+                                    startReceiving();
                                 }
                             }
                         }
@@ -157,11 +575,11 @@ void Streamer::startLoginAndReceiveProcedure()
             }
 
             std::unique_lock lock(m_mutex_state);
-            if (!m_state.testState(CVState::Active)) {
+            if (!m_state.testState(CVState::Active) && m_state.testFlag(CVState::Running)) {
                 lock.unlock();
                 // restart procedure if something failed
-                std::this_thread::sleep_for(std::chrono::seconds(5));
-                startLoginAndReceiveProcedure();
+                // (don't sleep here, we are on the io context thread)
+                m_websocket->asyncWait(std::chrono::seconds(5), [this] { startLoginAndReceiveProcedure(); });
             }
         }
     );
@@ -170,65 +588,97 @@ void Streamer::startLoginAndReceiveProcedure()
 void Streamer::subscribeLevelOneEquities(const std::vector<std::string>& tickers,
                                          const std::vector<StreamerField::LevelOneEquity>& fields)
 {
-    // NOTE: The streamer requires the symbol field to exist.
-    //       It also requires the fields to be sorted in ascending order.
-    //       Another thing to note is that the streamer does not support overwriting the existing subscribed fields.
-    //       If you try to add a new subscription with different fields of the same service type, they would not go through.
-    //       You will only get data of the old subscribed fields.
-    //       To add or change new fields to the streamer, you have to do a complete new subscription for all the tickers.
-    //       (What a trash API...)
-    std::vector<StreamerField::LevelOneEquity>& tmp = const_cast<std::vector<StreamerField::LevelOneEquity>&>(fields);
-    std::sort(tmp.begin(), tmp.end(), [](StreamerField::LevelOneEquity left, StreamerField::LevelOneEquity right) {
-        return left < right;
-    });
-    if (tmp.front() != StreamerField::LevelOneEquity::Symbol) {
-        tmp.insert(tmp.begin(), StreamerField::LevelOneEquity::Symbol);
-    }
+    std::vector<StreamerField::LevelOneEquity> sortedFields = subscribeLevelOne(RequestServiceType::LEVELONE_EQUITIES, tickers, fields);
+
+    // what the gap recovery reseeds
+    std::lock_guard lock(m_mutex_subscription);
+    m_levelOneEquitySymbols.insert(tickers.begin(), tickers.end());
+    m_levelOneEquityFields.insert(sortedFields.begin(), sortedFields.end());
+}
+
+void Streamer::subscribeLevelOneOptions(const std::vector<std::string>& contracts,
+                                        const std::vector<StreamerField::LevelOneOption>& fields)
+{
+    subscribeLevelOne(RequestServiceType::LEVELONE_OPTIONS, contracts, fields);
+}
+
+void Streamer::subscribeLevelOneFutures(const std::vector<std::string>& futures,
+                                        const std::vector<StreamerField::LevelOneFutures>& fields)
+{
+    subscribeLevelOne(RequestServiceType::LEVELONE_FUTURES, futures, fields);
+}
+
+void Streamer::subscribeLevelOneForex(const std::vector<std::string>& pairs,
+                                      const std::vector<StreamerField::LevelOneForex>& fields)
+{
+    subscribeLevelOne(RequestServiceType::LEVELONE_FOREX, pairs, fields);
+}
+
+void Streamer::subscribeAccountActivity()
+{
     std::string request = constructStreamRequest(
-        Streamer::RequestServiceType::LEVELONE_EQUITIES,
-        Streamer::RequestCommandType::ADD,
+        RequestServiceType::ACCT_ACTIVITY,
+        RequestCommandType::SUBS,
         {
-            { "keys", std::accumulate(tickers.begin(), tickers.end(), std::string(), [](std::string acc, const std::string& val) {
-                if (!acc.empty()) {
-                    acc += ",";
-                }
-                return acc + val;
-            }) },
-            { "fields", std::accumulate(fields.begin(), fields.end(), std::string(), [](std::string acc, const StreamerField::LevelOneEquity val) {
-                if (!acc.empty()) {
-                    acc += ",";
-                }
-                return acc + std::to_string(static_cast<int>(val));
-            }) },
+            { "keys", s_accountActivityKey },
+            { "fields", s_accountActivityFields },
         }
     );
 
+    // record the subscription request incase of reconnection
+    m_subscriptionRecord.push_back(request);
+    {
+        // what the gap recovery reconciles
+        std::lock_guard lock(m_mutex_subscription);
+        m_accountActivity = true;
+    }
+
+    // send
+    asyncRequest(request);
+}
+
+template <typename Field>
+std::vector<Field> Streamer::subscribeLevelOne(RequestServiceType service,
+                                               const std::vector<std::string>& symbols,
+                                               const std::vector<Field>& fields)
+{
+    std::vector<Field> sortedFields = fields;
+    std::string request = constructSubscriptionRequest(service, symbols, sortedFields);
+
     // record the subscription request incase of reconnection
     m_subscriptionRecord.push_back(request);
 
     // send
     asyncRequest(request);
+
+    return sortedFields;
 }
 
 void Streamer::stop()
 {
     LOG_TRACE("Stopping streamer...");
 
-    // update the flags
+    // update the flags, and take the recovery thread (none starts once we are not running)
+    std::thread recoveryThread;
     {
         std::lock_guard lock(m_mutex_state);
         m_state.setState(CVState::Inactive);
-        m_state.setFlag(CVState::RunRequestDaemon, false);
+        m_state.setFlag(CVState::Running, false);
+        recoveryThread = std::move(m_recoveryThread);
     }
 
-    // stop the request daemon if it is running
-    if (m_requestDaemon.joinable()) {
-        LOG_TRACE("Stopping streamer request daemon...");
-        m_cv.notify_all();
+    // the snapshot is a single blocking call, this waits for all of it (and the account
+    // reconciliation after it), the recovery only checks the running flag in between
+    if (recoveryThread.joinable()) {
+        LOG_TRACE("Waiting for the streamer gap recovery...");
+        recoveryThread.join();
     }
 
-    // release websocket
+    // release websocket (this waits for the websocket to close)
     m_websocket.reset();
+
+    // nothing is coming for the waiters anymore
+    failQuoteWaiters();
 }
 
 void Streamer::pause()
@@ -262,14 +712,14 @@ void Streamer::resume()
         lock.unlock();
 
         // start the receiver loop
-        m_websocket->startReceiverLoop(m_dataHandler);
+        m_websocket->startReceiverLoop(std::bind(&Streamer::onFrame, this, std::placeholders::_1));
 
-        // change state and notify sender
+        // change state and flush the requests queued while paused
         lock.lock();
         m_state.setState(CVState::Active);
         lock.unlock();
 
-        m_cv.notify_all();
+        flushRequests();
     } else {
         LOG_DEBUG("Streamer not paused, cannot resume.");
     }
@@ -287,61 +737,48 @@ bool Streamer::isPaused() const
     return m_state.testState(CVState::Paused);
 }
 
-void Streamer::asyncRequest(const std::string& request, std::function<void()> callback)
+void Streamer::asyncRequest(const std::string& request, WebsocketSession::SendHandler callback)
 {
     // enqueue the request
     {
         std::lock_guard<std::mutex> lock(m_mutex_requestQ);
         m_requestQueue.emplace(std::move(request), callback);
     }
-    // set the flag
-    {
-        std::lock_guard lock(m_mutex_state);
-        m_state.setFlag(CVState::RequestQueueNotEmpty, true);
-    }
-    // notify
-    m_cv.notify_one();
+    // send right away if we can
+    flushRequests();
 }
 
-void Streamer::sendRequests()
+void Streamer::flushRequests()
 {
-    std::unique_lock<std::mutex> stateLock(m_mutex_state);
-    while (m_state.testFlag(CVState::RunRequestDaemon)) {
-
-        // now we will wati until the state flag is notified and post check should wake sender
-        m_cv.wait(stateLock, [this] { return m_state.shouldWakeSender(); });
-
-        // if we woke up because the run flag is unset, break
-        if (!m_state.testFlag(CVState::RunRequestDaemon)) break;
-
-        LOG_TRACE("Streamer request queue size: {}", m_requestQueue.size());
-
-        // send all if not interrupted
-        std::unique_lock<std::mutex> queueLock(m_mutex_requestQ);
-        while (!m_requestQueue.empty() && m_state.testState(CVState::Active)) {
-            // done checking state, release
-            stateLock.unlock();
+    // only send while logged in, otherwise the requests stay queued until
+    // the login succeeded or the streamer resumed
+    std::lock_guard<std::mutex> stateLock(m_mutex_state);
+    if (!m_state.testState(CVState::Active)) {
+        return;
+    }
 
-            RequestData payload = m_requestQueue.front();
-            m_requestQueue.pop();
+    std::lock_guard<std::mutex> queueLock(m_mutex_requestQ);
 
-            // dequeue complete, release
-            queueLock.unlock();
+    LOG_TRACE("Streamer request queue size: {}", m_requestQueue.size());
 
-            // we can do async send here, this essentially pushes the payload to the
-            // websocket's internal message queue. It will schedule the send automatically.
-            // No need to sync.
-            m_websocket->asyncSend(payload.request, payload.callback);
+    while (!m_requestQueue.empty()) {
+        RequestData& payload = m_requestQueue.front();
 
-            // lock again before checking the queue and state
-            queueLock.lock();
-            stateLock.lock();
-        }
+        // This pushes the payload to the websocket's internal message queue.
+        // It will schedule the send automatically. No need to sync.
+        m_websocket->asyncSend(
+            payload.request,
+            [callback = std::move(payload.callback), request = describeRequest(payload.request)](beast::error_code ec) {
+                if (ec) {
+                    LOG_ERROR("Streamer request {} lost. Error: {}", request, ec.message());
+                }
+                if (callback) {
+                    callback(ec);
+                }
+            }
+        );
 
-        // queue and state are locked at this point
-        if (m_requestQueue.empty()) {
-            m_state.setFlag(CVState::RequestQueueNotEmpty, false);
-        }
+        m_requestQueue.pop();
     }
 }
 
@@ -381,6 +818,56 @@ std::string Streamer::constructStreamRequest(
     return std::move(requestJson.dump(-1));
 }
 
+template <typename Field>
+std::string Streamer::constructSubscriptionRequest(
+    RequestServiceType service,
+    const std::vector<std::string>& symbols,
+    std::vector<Field>& fields) const
+{
+    // NOTE: The streamer requires the symbol field to exist.
+    //       It also requires the fields to be sorted in ascending order.
+    //       Another thing to note is that the streamer does not support overwriting the existing subscribed fields.
+    //       If you try to add a new subscription with different fields of the same service type, they would not go through.
+    //       You will only get data of the old subscribed fields.
+    //       To add or change new fields to the streamer, you have to do a complete new subscription for all the tickers.
+    //       (What a trash API...)
+    //       The symbol is field 0 of every level one service.
+    fields.push_back(static_cast<Field>(0));
+    std::sort(fields.begin(), fields.end());
+    fields.erase(std::unique(fields.begin(), fields.end()), fields.end());
+
+    // tens of thousands of option contracts, join in one go
+    size_t length = 0;
+    for (const std::string& symbol : symbols) {
+        length += symbol.size() + 1;
+    }
+    std::string keys;
+    keys.reserve(length);
+    for (const std::string& symbol : symbols) {
+        if (!keys.empty()) {
+            keys += ',';
+        }
+        keys += symbol;
+    }
+
+    std::string fieldList;
+    for (Field field : fields) {
+        if (!fieldList.empty()) {
+            fieldList += ',';
+        }
+        fieldList += std::to_string(static_cast<int>(field));
+    }
+
+    return constructStreamRequest(
+        service,
+        RequestCommandType::ADD,
+        {
+            { "keys", std::move(keys) },
+            { "fields", std::move(fieldList) },
+        }
+    );
+}
+
 std::string Streamer::batchStreamRequests(const std::vector<std::string>& requests) const
 {
     // This batches the reuqests into a list with the key "requests"
@@ -397,9 +884,13 @@ std::string Streamer::requestServiceType2String(RequestServiceType type)
     switch (type) {
         case RequestServiceType::ADMIN:             return "ADMIN";
         case RequestServiceType::LEVELONE_EQUITIES: return "LEVELONE_EQUITIES";
+        case RequestServiceType::LEVELONE_OPTIONS:  return "LEVELONE_OPTIONS";
+        case RequestServiceType::LEVELONE_FUTURES:  return "LEVELONE_FUTURES";
+        case RequestServiceType::LEVELONE_FOREX:    return "LEVELONE_FOREX";
         case RequestServiceType::NYSE_BOOK:         return "NYSE_BOOK";
         case RequestServiceType::NASDAQ_BOOK:       return "NASDAQ_BOOK";
         case RequestServiceType::OPTIONS_BOOK:      return "OPTIONS_BOOK";
+        case RequestServiceType::ACCT_ACTIVITY:     return "ACCT_ACTIVITY";
     }
 
     return "";
@@ -447,13 +938,4 @@ bool Streamer::CVState::testState(State state) const
     return _state == state;
 }
 
-bool Streamer::CVState::shouldWakeSender() const
-{
-    // when should we wake the sender?
-    // 1.active and messeage queue not empty
-    // 2. when the run sender flag is unset 
-    return testState(CVState::Active) && testFlag(CVState::RequestQueueNotEmpty)
-        || !testFlag(CVState::RunRequestDaemon);
-}
-
 }
@@ -2,8 +2,13 @@
 #define __STREAMER_H__
 
 #include <unordered_map>
+#include <queue>
+#include <set>
+#include <thread>
 #include "websocket.h"
 #include "streamerField.h"
+#include "streamerDecoder.h"
+#include "streamerDispatcher.h"
 #include "schema/userPreference.h"
 
 namespace schwabcpp {
@@ -19,9 +24,35 @@ class Client;
 //   You don't have to call it if you don't care when the streamer is destroyed.
 //
 // * After `start` is called, you can use `asyncRequest(...)` ANYTIME to send your request.
-//   Note that this simply queues the requests and return immediately. The sender will send the request
-//   when appropriate (after connection established and successfully logged in).
-//   The callback will be triggered when the request is actually sent.
+//   Note that this simply queues the requests and return immediately. The queue is flushed to the
+//   websocket when appropriate (after connection established and successfully logged in).
+//   The callback will be triggered when the request is actually sent, or with the error if the
+//   write failed (the request is lost then, the failure is logged).
+//
+// * The streamer doesn't own any thread. Everything runs on the io context of the client context.
+//   (The only exception is the short lived gap recovery, see below.)
+//
+// * When the connection drops, every subscribed symbol is marked stale. After logging in again,
+//   a rest quote snapshot of the stale symbols is fetched in batches and delivered to the data
+//   handler (in the same format as the streamed data) before the receiver loop resumes, then a
+//   StreamerGapEvent is fired with the gap and recovery durations.
+//   (Equities only, the other services get their full values again from the resubscription.)
+//   With the account activity subscribed, the client's account state is reconciled against a rest
+//   snapshot of the positions once live data resumed (see Client::trackAccountActivity).
+//
+// * The received frames go to the raw data handler and/or get decoded into typed updates for the
+//   typed handlers. The decoder only converts what passes the symbol filter and the field mask.
+//   If no handler is set at all, the frames are logged. Set the handlers and filters before
+//   calling `start()`, they are not synchronized with the io context thread.
+//
+// * The typed handlers run on the io context thread unless dispatcher workers are set, then they
+//   run on the dispatcher's worker pool (ordered per symbol, see StreamerDispatcher).
+//   The account activity handler always runs on the io context thread, the events of an order
+//   have to stay in order and they are few.
+//
+// * Quote waiters are one shot: completed with the next decoded update of their symbol, or failed
+//   when the streamer stops. The symbol has to be subscribed (and pass the symbol filter).
+//
 //
 // * TODO:
 //   Create APIs to generate request for the supported subscriptions.
@@ -37,6 +68,8 @@ public:
 
     using RequestParametersType = std::unordered_map<std::string, std::string>;
 
+    using QuoteWaiterFn = std::function<void(std::exception_ptr, LevelOneEquityQuote)>;
+
 public:
                                 Streamer(Client* client);
                                 ~Streamer();
@@ -56,18 +89,81 @@ public:
 
     void                        setDataHandler(std::function<void(const std::string&)> handler) { m_dataHandler = handler; }
 
+    // -- typed data (see StreamerStateTable to keep the latest values)
+    void                        setLevelOneEquityHandler(StreamerDecoder::LevelOneEquityHandler handler);
+    void                        setLevelOneOptionHandler(StreamerDecoder::LevelOneOptionHandler handler);
+    void                        setLevelOneFuturesHandler(StreamerDecoder::LevelOneFuturesHandler handler);
+    void                        setLevelOneForexHandler(StreamerDecoder::LevelOneForexHandler handler);
+    void                        setAccountActivityHandler(StreamerDecoder::AccountActivityHandler handler);
+    void                        setSymbolFilter(const std::vector<std::string>& symbols);
+    void                        setLevelOneEquityFieldMask(const StreamerField::LevelOneEquityMask& mask) { m_decoder.setLevelOneEquityFieldMask(mask); }
+    void                        setLevelOneOptionFieldMask(const StreamerField::LevelOneOptionMask& mask) { m_decoder.setLevelOneOptionFieldMask(mask); }
+    void                        setLevelOneFuturesFieldMask(const StreamerField::LevelOneFuturesMask& mask) { m_decoder.setLevelOneFuturesFieldMask(mask); }
+    void                        setLevelOneForexFieldMask(const StreamerField::LevelOneForexMask& mask) { m_decoder.setLevelOneForexFieldMask(mask); }
+    void                        setFixedPointPrices(bool enabled, uint32_t decimals) { m_decoder.setFixedPointPrices(enabled, decimals); }
+
+    SymbolTable&                symbolTable() { return m_symbols; }
+
+    // (Thread-Safe)
+    void                        addQuoteWaiter(const std::string& symbol, QuoteWaiterFn fn);
+
+    // -- dispatching the typed handlers (0 workers -> run on the io context thread)
+    // only before `start()` (or after `stop()`), ignored while running
+    void                        setDispatcherWorkers(size_t workers);
+    std::vector<StreamerDispatcher::WorkerStats>
+                                getDispatcherStats() const;
+
     void                        updateStreamerInfo(const UserPreference::StreamerInfo& info);
 
     void                        subscribeLevelOneEquities(const std::vector<std::string>& tickers,
                                                           const std::vector<StreamerField::LevelOneEquity>& fields);
 
+    // the contracts are option symbols like "AAPL  240119C00190000" (see OptionChain)
+    void                        subscribeLevelOneOptions(const std::vector<std::string>& contracts,
+                                                         const std::vector<StreamerField::LevelOneOption>& fields);
+
+    // futures like "/ES" (the active contract) or "/ESZ24"
+    void                        subscribeLevelOneFutures(const std::vector<std::string>& futures,
+                                                         const std::vector<StreamerField::LevelOneFutures>& fields);
+
+    // currency pairs like "EUR/USD"
+    void                        subscribeLevelOneForex(const std::vector<std::string>& pairs,
+                                                       const std::vector<StreamerField::LevelOneForex>& fields);
+
+    // the orders and fills of all the linked accounts (see AccountState)
+    void                        subscribeAccountActivity();
+
 private:
     void                        onWebsocketConnected();
     void                        onWebsocketReconnected();
+    void                        onWebsocketDisconnected();
+
+    // starts the receiver loop, or the gap recovery that starts it when done
+    void                        startReceiving();
+    void                        recoverStaleSymbols(std::vector<std::string> symbols, bool staleAccounts);
 
     void                        startLoginAndReceiveProcedure();
 
-    void                        asyncRequest(const std::string& request, std::function<void()> callback = {});
+    // anyone wants the decoded updates
+    bool                        decodes() const;
+
+    // hands a frame to the decoder and the raw data handler
+    // (the owner, if any, lets the dispatcher keep the frame without copying it)
+    void                        onData(const std::string& data, std::shared_ptr<const std::string> owner = nullptr);
+    void                        onFrame(const SharedBuffer& frame) { onData(*frame, frame); }
+
+    // the decoder's handler, feeds the waiters and the typed handler (directly or through the dispatcher)
+    void                        onLevelOneEquityUpdate(const LevelOneEquityUpdate& update);
+
+    // the decoder's handler of the other services, hands the update to `handler` (directly or
+    // through the dispatcher), nullptr without a handler (the decoder skips the service)
+    template <typename Update>
+    std::function<void(const Update&)>
+                                decoderHandler(const std::function<void(const Update&)>& handler);
+
+    void                        failQuoteWaiters();
+
+    void                        asyncRequest(const std::string& request, WebsocketSession::SendHandler callback = {});
 
     std::string                 constructLoginRequest() const;
 
@@ -77,6 +173,20 @@ private:
                                     const RequestParametersType& parameters = {}
                                 ) const;
 
+    // the ADD request of a level one service, sorts the fields (symbol first) the way the streamer wants them
+    template <typename Field>
+    std::string                 constructSubscriptionRequest(
+                                    RequestServiceType service,
+                                    const std::vector<std::string>& symbols,
+                                    std::vector<Field>& fields
+                                ) const;
+
+    // sends the subscription and records it for the reconnection, returns the sorted fields
+    template <typename Field>
+    std::vector<Field>          subscribeLevelOne(RequestServiceType service,
+                                                  const std::vector<std::string>& symbols,
+                                                  const std::vector<Field>& fields);
+
     // convenience function
     // usage:
     //      std::string requests = batchStreamRequests(
@@ -91,8 +201,8 @@ private:
     std::string                 batchStreamRequests(const std::vector<std::string>& requests) const;
 
 private:
-    // -- what the sender daemon runs
-    void                        sendRequests();
+    // -- hands the queued requests to the websocket if we are logged in
+    void                        flushRequests();
 
 private:
     Client*                     m_client;  // since the client "owns" the streamer, this is always valid
@@ -105,17 +215,46 @@ private:
     std::function<void(const std::string&)>
                                 m_dataHandler;
 
+    SymbolTable                 m_symbols;
+    StreamerDecoder             m_decoder;
+    StreamerDecoder::LevelOneEquityHandler
+                                m_levelOneEquityHandler;
+    StreamerDecoder::LevelOneOptionHandler
+                                m_levelOneOptionHandler;
+    StreamerDecoder::LevelOneFuturesHandler
+                                m_levelOneFuturesHandler;
+    StreamerDecoder::LevelOneForexHandler
+                                m_levelOneForexHandler;
+    StreamerDecoder::AccountActivityHandler
+                                m_accountActivityHandler;
+    std::unique_ptr<StreamerDispatcher>
+                                m_dispatcher;
+
+    std::unordered_map<SymbolId, std::vector<QuoteWaiterFn>>
+                                m_quoteWaiters;
+    std::atomic<size_t>         m_quoteWaiterCount;
+    mutable std::mutex          m_mutex_quoteWaiters;
+
     std::vector<std::string>    m_subscriptionRecord;
 
-    // -- request queue and sender control
+    // -- what's subscribed, and what went stale during a disconnection
+    std::set<std::string>       m_levelOneEquitySymbols;
+    std::set<StreamerField::LevelOneEquity>
+                                m_levelOneEquityFields;
+    std::set<std::string>       m_staleSymbols;
+    bool                        m_accountActivity = false;
+    bool                        m_staleAccounts = false;
+    std::chrono::steady_clock::time_point
+                                m_gapStart;
+    std::thread                 m_recoveryThread;       // swapped under m_mutex_state
+    mutable std::mutex          m_mutex_subscription;
+
+    // -- request queue and state control
     class CVState {
         typedef uint8_t Flag;
     public:
-        // flag for running the request daemon
-        inline static const Flag RunRequestDaemon = 1 << 0;
-
-        // whether request queue is empty
-        inline static const Flag RequestQueueNotEmpty = 1 << 1;
+        // flag set between start() and stop()
+        inline static const Flag Running = 1 << 0;
 
         // state
         enum State {
@@ -130,20 +269,17 @@ private:
         void setState(State state);
         bool testFlag(Flag flag) const;
         bool testState(State state) const;
-        bool shouldWakeSender() const;
 
     private:
         Flag        _flag;
         uint8_t     _state;
     };
     CVState                     m_state;
-    std::thread                 m_requestDaemon;
     mutable std::mutex          m_mutex_state;
     mutable std::mutex          m_mutex_requestQ;
-    std::condition_variable     m_cv;  // for notifying the request daemon
     struct RequestData {
         std::string request;
-        std::function<void()> callback;
+        WebsocketSession::SendHandler callback;
     };
     std::queue<RequestData>     m_requestQueue;
 };
@@ -152,9 +288,13 @@ private:
 enum class Streamer::RequestServiceType : char {
     ADMIN,
     LEVELONE_EQUITIES,
+    LEVELONE_OPTIONS,
+    LEVELONE_FUTURES,
+    LEVELONE_FOREX,
     NYSE_BOOK,
     NASDAQ_BOOK,
     OPTIONS_BOOK,
+    ACCT_ACTIVITY,
 };
 
 enum class Streamer::RequestCommandType : char {
@@ -0,0 +1,123 @@
+#ifndef __STREAMER_DATA_H__
+#define __STREAMER_DATA_H__
+
+#include "schwabcpp/streamerField.h"
+#include "schwabcpp/symbolTable.h"
+#include "schwabcpp/utils/clock.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace schwabcpp {
+
+//
+// A decoded field value. Which member is valid depends on the kind of the field.
+// String values point into the received frame, they are only valid during the handler call.
+// Fixed point prices are integers in units of 10^-decimals.
+//
+struct FieldValue {
+
+    union {
+        double          d;
+        int64_t         l;
+        bool            b;
+        const char*     s;
+    };
+    uint32_t            size = 0;  // length of s, or the decimals of a fixed point value
+    StreamerField::Kind kind = StreamerField::Kind::None;
+
+    inline double           asDouble() const { return d; }
+    inline int64_t          asLong() const { return l; }
+    inline bool             asBool() const { return b; }
+    inline std::string_view asString() const { return std::string_view(s, size); }
+    inline int64_t          asFixed() const { return l; }
+    inline uint32_t         fixedDecimals() const { return size; }
+
+    // the price whether it was decoded as double or fixed point
+    inline double           asPrice() const
+    {
+        if (kind != StreamerField::Kind::Fixed) {
+            return d;
+        }
+        double scale = 1.0;
+        for (uint32_t i = 0; i < size; ++i) {
+            scale *= 10.0;
+        }
+        return static_cast<double>(l) / scale;
+    }
+
+    // the time fields are milliseconds since epoch
+    inline clock::time_point asTimePoint() const { return clock::time_point(std::chrono::milliseconds(l)); }
+};
+
+//
+// One content entry of the streamed data, i.e. the changed fields of one symbol.
+// Only the fields flagged in `fields` carry a value. Fixed layout, no allocation.
+//
+template <typename Field>
+struct StreamerUpdate {
+
+    using FieldMask = StreamerField::Mask<Field>;
+
+    SymbolId            symbolId = SymbolTable::InvalidId;
+    std::string_view    symbol;         // owned by the symbol table, always valid
+    int64_t             timestamp = 0;  // milliseconds since epoch, as stamped by the streamer
+    bool                delayed = false;
+    FieldMask           fields;
+    std::array<FieldValue, StreamerField::fieldCount<Field>>
+                        values;
+
+    inline clock::time_point    timePoint() const { return clock::time_point(std::chrono::milliseconds(timestamp)); }
+
+    inline bool                 has(Field field) const { return fields.test(static_cast<size_t>(field)); }
+    inline const FieldValue&    operator[](Field field) const { return values[static_cast<size_t>(field)]; }
+};
+
+//
+// An update that owns its string values, safe to keep around after the handler returned.
+// Copies share the storage.
+//
+template <typename Field>
+struct OwnedStreamerUpdate : StreamerUpdate<Field> {
+
+    OwnedStreamerUpdate() = default;
+
+    explicit OwnedStreamerUpdate(const StreamerUpdate<Field>& update)
+        : StreamerUpdate<Field>(update)
+    {
+        std::string strings;
+        for (size_t i = 0; i < this->values.size(); ++i) {
+            if (this->fields.test(i) && this->values[i].kind == StreamerField::Kind::String) {
+                strings.append(this->values[i].s, this->values[i].size);
+            }
+        }
+        if (strings.empty()) {
+            return;
+        }
+
+        storage = std::make_shared<const std::string>(std::move(strings));
+        const char* cursor = storage->data();
+        for (size_t i = 0; i < this->values.size(); ++i) {
+            if (this->fields.test(i) && this->values[i].kind == StreamerField::Kind::String) {
+                this->values[i].s = cursor;
+                cursor += this->values[i].size;
+            }
+        }
+    }
+
+    std::shared_ptr<const std::string>  storage;  // the string values point in here
+};
+
+using LevelOneEquityUpdate = StreamerUpdate<StreamerField::LevelOneEquity>;
+using LevelOneEquityQuote = OwnedStreamerUpdate<StreamerField::LevelOneEquity>;
+using LevelOneOptionUpdate = StreamerUpdate<StreamerField::LevelOneOption>;
+using LevelOneOptionQuote = OwnedStreamerUpdate<StreamerField::LevelOneOption>;
+using LevelOneFuturesUpdate = StreamerUpdate<StreamerField::LevelOneFutures>;
+using LevelOneFuturesQuote = OwnedStreamerUpdate<StreamerField::LevelOneFutures>;
+using LevelOneForexUpdate = StreamerUpdate<StreamerField::LevelOneForex>;
+using LevelOneForexQuote = OwnedStreamerUpdate<StreamerField::LevelOneForex>;
+
+}
+
+#endif
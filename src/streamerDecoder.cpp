@@ -0,0 +1,496 @@
+#include "streamerDecoder.h"
+#include "accountActivityDecoder.h"
+#include "utils/jsonScanner.h"
+#include "utils/numberParser.h"
+#include "utils/logger.h"
+#include <cmath>
+
+namespace schwabcpp {
+
+using Token = JsonScanner::Token;
+
+namespace {
+
+const static std::string_view s_levelOneEquityService = "LEVELONE_EQUITIES";
+const static std::string_view s_levelOneOptionService = "LEVELONE_OPTIONS";
+const static std::string_view s_levelOneFuturesService = "LEVELONE_FUTURES";
+const static std::string_view s_levelOneForexService = "LEVELONE_FOREX";
+const static std::string_view s_accountActivityService = "ACCT_ACTIVITY";
+
+// the content keys are the field numbers
+// returns -1 if the key is not a number
+int fieldIndex(std::string_view key)
+{
+    if (key.empty() || key.size() > 3) {
+        return -1;
+    }
+    int result = 0;
+    for (char c : key) {
+        if (c < '0' || c > '9') {
+            return -1;
+        }
+        result = result * 10 + (c - '0');
+    }
+    return result;
+}
+
+}
+
+StreamerDecoder::StreamerDecoder(SymbolTable& symbols)
+    : m_symbols(symbols)
+    , m_filterSymbols(false)
+    , m_fixedPointPrices(false)
+    , m_fixedPointDecimals(4)
+    , m_delivered(0)
+    , m_arena(m_arenaBuffer.data(), m_arenaBuffer.size())
+{
+    m_levelOneEquity.mask.set();
+    m_levelOneOption.mask.set();
+    m_levelOneFutures.mask.set();
+    m_levelOneForex.mask.set();
+}
+
+void StreamerDecoder::setFixedPointPrices(bool enabled, uint32_t decimals)
+{
+    if (enabled && decimals > NumberParser::MaxFixedDecimals) {
+        LOG_WARN("Fixed point prices with {} decimals are not supported, using {}.", decimals, NumberParser::MaxFixedDecimals);
+        decimals = NumberParser::MaxFixedDecimals;
+    }
+
+    m_fixedPointPrices = enabled;
+    m_fixedPointDecimals = decimals;
+}
+
+void StreamerDecoder::setSymbolFilter(const std::vector<SymbolId>& symbols)
+{
+    m_symbolFilter.clear();
+    m_filterSymbols = !symbols.empty();
+
+    for (SymbolId id : symbols) {
+        if (id == SymbolTable::InvalidId) {
+            continue;
+        }
+        if (id >= m_symbolFilter.size()) {
+            m_symbolFilter.resize(id + 1, false);
+        }
+        m_symbolFilter[id] = true;
+    }
+}
+
+bool StreamerDecoder::acceptSymbol(SymbolId id) const
+{
+    if (!m_filterSymbols) {
+        return true;
+    }
+    return id < m_symbolFilter.size() && m_symbolFilter[id];
+}
+
+bool StreamerDecoder::conform(LevelOneEquityUpdate& update) const
+{
+    if (!acceptSymbol(update.symbolId)) {
+        return false;
+    }
+
+    update.fields &= m_levelOneEquity.mask;
+
+    if (m_fixedPointPrices) {
+        double scale = std::pow(10.0, m_fixedPointDecimals);
+        for (size_t index = 0; index < update.values.size(); ++index) {
+            FieldValue& value = update.values[index];
+            if (update.fields.test(index) &&
+                value.kind == StreamerField::Kind::Double &&
+                StreamerField::isPrice(static_cast<StreamerField::LevelOneEquity>(index)))
+            {
+                // rounded like the parsed ones, dropped like them if it doesn't fit
+                double scaled = std::round(value.d * scale);
+                if (!(scaled >= -9223372036854775808.0 && scaled < 9223372036854775808.0)) {
+                    update.fields.reset(index);
+                    continue;
+                }
+                value.l = static_cast<int64_t>(scaled);
+                value.size = m_fixedPointDecimals;
+                value.kind = StreamerField::Kind::Fixed;
+            }
+        }
+    }
+
+    return true;
+}
+
+size_t StreamerDecoder::decode(std::string_view frame)
+{
+    m_delivered = 0;
+
+    // whatever the previous frame left in the arena is gone
+    m_arena.release();
+
+    // {"data":[{service}, {service}, ...]}
+    // anything else (responses, heartbeats) is ignored
+    JsonScanner scanner(frame);
+    if (scanner.next() != Token::BeginObject) {
+        return 0;
+    }
+
+    for (Token token = scanner.next(); token == Token::String; token = scanner.next()) {
+        std::string_view key = scanner.text();
+        Token value = scanner.next();
+
+        if (key != "data" || value != Token::BeginArray) {
+            if (!scanner.skipValue(value)) {
+                break;
+            }
+            continue;
+        }
+
+        for (value = scanner.next(); value == Token::BeginObject; value = scanner.next()) {
+            if (!decodeService(scanner)) {
+                return m_delivered;
+            }
+        }
+    }
+
+    return m_delivered;
+}
+
+bool StreamerDecoder::decodeService(JsonScanner& scanner)
+{
+    Service service = Service::Unknown;
+    bool serviceKnown = false;
+    int64_t timestamp = 0;
+    bool timestampKnown = false;
+    size_t contentPosition = 0;  // 0 -> no deferred content
+
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+
+        if (key == "content") {
+            // usually the service and timestamp come first, then we decode in place,
+            // otherwise remember where the content is and come back later
+            if (serviceKnown && timestampKnown) {
+                if (!wants(service)) {
+                    if (!scanner.skipValue(scanner.next())) {
+                        return false;
+                    }
+                } else if (!decodeContent(scanner, service, timestamp)) {
+                    return false;
+                }
+            } else {
+                contentPosition = scanner.position();
+                if (!scanner.skipValue(scanner.next())) {
+                    return false;
+                }
+            }
+            continue;
+        }
+
+        Token value = scanner.next();
+        if (key == "service" && value == Token::String) {
+            std::string_view name = scanner.text();
+            if (name == s_levelOneEquityService) {
+                service = Service::LevelOneEquity;
+            } else if (name == s_levelOneOptionService) {
+                service = Service::LevelOneOption;
+            } else if (name == s_levelOneFuturesService) {
+                service = Service::LevelOneFutures;
+            } else if (name == s_levelOneForexService) {
+                service = Service::LevelOneForex;
+            } else if (name == s_accountActivityService) {
+                service = Service::AccountActivity;
+            }
+            serviceKnown = true;
+        } else if (key == "timestamp" && value == Token::Number) {
+            timestampKnown = NumberParser::parseLong(scanner.text(), timestamp);
+        } else if (!scanner.skipValue(value)) {
+            return false;
+        }
+    }
+
+    if (contentPosition && wants(service)) {
+        size_t end = scanner.position();
+        scanner.seek(contentPosition);
+        if (!decodeContent(scanner, service, timestamp)) {
+            return false;
+        }
+        scanner.seek(end);
+    }
+
+    return true;
+}
+
+bool StreamerDecoder::wants(Service service) const
+{
+    switch (service) {
+        case Service::LevelOneEquity:   return static_cast<bool>(m_levelOneEquity.handler);
+        case Service::LevelOneOption:   return static_cast<bool>(m_levelOneOption.handler);
+        case Service::LevelOneFutures:  return static_cast<bool>(m_levelOneFutures.handler);
+        case Service::LevelOneForex:    return static_cast<bool>(m_levelOneForex.handler);
+        case Service::AccountActivity:  return static_cast<bool>(m_accountActivityHandler);
+        case Service::Unknown:          return false;
+    }
+
+    return false;
+}
+
+bool StreamerDecoder::decodeContent(JsonScanner& scanner, Service service, int64_t timestamp)
+{
+    switch (service) {
+        case Service::LevelOneEquity:   return decodeContent(scanner, m_levelOneEquity, timestamp);
+        case Service::LevelOneOption:   return decodeContent(scanner, m_levelOneOption, timestamp);
+        case Service::LevelOneFutures:  return decodeContent(scanner, m_levelOneFutures, timestamp);
+        case Service::LevelOneForex:    return decodeContent(scanner, m_levelOneForex, timestamp);
+        case Service::AccountActivity:  return decodeAccountActivity(scanner, timestamp);
+        case Service::Unknown:          return scanner.skipValue(scanner.next());
+    }
+
+    return false;
+}
+
+template <typename Field>
+bool StreamerDecoder::decodeContent(JsonScanner& scanner, Channel<Field>& channel, int64_t timestamp)
+{
+    if (scanner.next() != Token::BeginArray) {
+        return false;
+    }
+
+    for (Token token = scanner.next(); token != Token::EndArray; token = scanner.next()) {
+        if (token != Token::BeginObject) {
+            if (!scanner.skipValue(token)) {
+                return false;
+            }
+            continue;
+        }
+        if (!decodeEntry(scanner, channel, timestamp)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename Field>
+bool StreamerDecoder::decodeEntry(JsonScanner& scanner, Channel<Field>& channel, int64_t timestamp)
+{
+    const size_t entryPosition = scanner.position();
+
+    // find the symbol first, the streamer puts it in front but the snapshot doesn't have to
+    Token token = scanner.next();
+    if (token != Token::String) {
+        return token == Token::EndObject;
+    }
+    bool keyFirst = scanner.text() == "key";
+    if (!keyFirst) {
+        while (token == Token::String && scanner.text() != "key") {
+            if (!scanner.skipValue(scanner.next())) {
+                return false;
+            }
+            token = scanner.next();
+        }
+        if (token != Token::String) {
+            // no symbol, nothing to deliver
+            return token == Token::EndObject;
+        }
+    }
+
+    if (scanner.next() != Token::String) {
+        return skipObject(scanner);
+    }
+    std::string_view symbol = scanner.text();
+    if (scanner.hasEscape()) {
+        // e.g. "\/ES", the table knows it as "/ES"
+        char* scratch = static_cast<char*>(m_arena.allocate(symbol.size(), 1));
+        symbol = std::string_view(scratch, JsonScanner::unescape(symbol, scratch));
+    }
+
+    // filtered symbols are looked up, never interned
+    SymbolId id = m_filterSymbols ? m_symbols.find(symbol) : m_symbols.intern(symbol);
+    if (id == SymbolTable::InvalidId || !acceptSymbol(id)) {
+        return skipObject(scanner);
+    }
+
+    StreamerUpdate<Field>& update = channel.update;
+    update.symbolId = id;
+    update.symbol = m_symbols.name(id);
+    update.timestamp = timestamp;
+    update.delayed = false;
+    update.fields.reset();
+
+    // the symbol is field 0 of every service
+    if (channel.mask.test(0)) {
+        FieldValue& value = update.values[0];
+        value.s = update.symbol.data();
+        value.size = static_cast<uint32_t>(update.symbol.size());
+        value.kind = StreamerField::Kind::String;
+        update.fields.set(0);
+    }
+
+    if (!keyFirst) {
+        scanner.seek(entryPosition);
+    }
+
+    for (token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token valueToken = scanner.next();
+
+        if (key == "key" || key == "delayed") {
+            // the symbol is already handled
+            if (key == "delayed") {
+                update.delayed = valueToken == Token::True;
+            }
+            if (!scanner.skipValue(valueToken)) {
+                return false;
+            }
+            continue;
+        }
+
+        int index = fieldIndex(key);
+        if (index < 0 ||
+            index >= static_cast<int>(StreamerField::fieldCount<Field>) ||
+            !channel.mask.test(index))
+        {
+            // not interested, don't even convert it
+            if (!scanner.skipValue(valueToken)) {
+                return false;
+            }
+            continue;
+        }
+
+        FieldValue& value = update.values[index];
+        value.kind = StreamerField::kindOf(static_cast<Field>(index));
+        if (m_fixedPointPrices && StreamerField::isPrice(static_cast<Field>(index))) {
+            value.kind = StreamerField::Kind::Fixed;
+        }
+
+        // the numbers are parsed straight from the frame bytes
+        bool valid = true;
+        switch (value.kind) {
+            case StreamerField::Kind::Double:
+                valid = valueToken == Token::Number && NumberParser::parseDouble(scanner.text(), value.d);
+                break;
+            case StreamerField::Kind::Long:
+                valid = valueToken == Token::Number && NumberParser::parseLong(scanner.text(), value.l);
+                break;
+            case StreamerField::Kind::Fixed:
+                valid = valueToken == Token::Number && NumberParser::parseFixed(scanner.text(), m_fixedPointDecimals, value.l);
+                if (valid) value.size = m_fixedPointDecimals;
+                break;
+            case StreamerField::Kind::Bool:
+                valid = valueToken == Token::True || valueToken == Token::False;
+                if (valid) value.b = valueToken == Token::True;
+                break;
+            case StreamerField::Kind::String:
+                valid = valueToken == Token::String;
+                if (valid) {
+                    std::string_view text = scanner.text();
+                    if (scanner.hasEscape()) {
+                        char* scratch = static_cast<char*>(m_arena.allocate(text.size(), 1));
+                        text = std::string_view(scratch, JsonScanner::unescape(text, scratch));
+                    }
+                    value.s = text.data();
+                    value.size = static_cast<uint32_t>(text.size());
+                }
+                break;
+            default:
+                valid = false;
+                break;
+        }
+
+        if (valid) {
+            update.fields.set(index);
+        } else if (!scanner.skipValue(valueToken)) {
+            return false;
+        }
+    }
+
+    channel.handler(update);
+    ++m_delivered;
+
+    return true;
+}
+
+bool StreamerDecoder::decodeAccountActivity(JsonScanner& scanner, int64_t timestamp)
+{
+    if (scanner.next() != Token::BeginArray) {
+        return false;
+    }
+
+    for (Token token = scanner.next(); token != Token::EndArray; token = scanner.next()) {
+        if (token != Token::BeginObject) {
+            if (!scanner.skipValue(token)) {
+                return false;
+            }
+            continue;
+        }
+        if (!decodeAccountActivityEntry(scanner, timestamp)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool StreamerDecoder::decodeAccountActivityEntry(JsonScanner& scanner, int64_t timestamp)
+{
+    // {"seq":0, "key":"Account Activity", "1":"<account>", "2":"<message type>", "3":"<message data>"}
+    AccountActivity& activity = m_accountActivity;
+    std::vector<AccountActivity::Leg> legs = std::move(activity.legs);
+    legs.clear();
+    activity = AccountActivity();
+    activity.legs = std::move(legs);
+    activity.timestamp = timestamp;
+
+    for (Token token = scanner.next(); token != Token::EndObject; token = scanner.next()) {
+        if (token != Token::String) {
+            return false;
+        }
+        std::string_view key = scanner.text();
+        Token valueToken = scanner.next();
+
+        if ((key != "1" && key != "2" && key != "3") || valueToken != Token::String) {
+            if (!scanner.skipValue(valueToken)) {
+                return false;
+            }
+            continue;
+        }
+
+        // the message data is a json document in a string, full of escaped quotes
+        std::string_view text = scanner.text();
+        if (scanner.hasEscape()) {
+            char* scratch = static_cast<char*>(m_arena.allocate(text.size(), 1));
+            text = std::string_view(scratch, JsonScanner::unescape(text, scratch));
+        }
+
+        switch (key[0]) {
+            case '1': activity.accountNumber = text; break;
+            case '2': activity.messageType = text; break;
+            case '3': activity.data = text; break;
+        }
+    }
+
+    activity.type = AccountActivity::toType(activity.messageType);
+
+    // a malformed document still delivers the event, without the order (nothing to apply)
+    if (!activity.data.empty() &&
+        !AccountActivityDecoder::decode(activity.data, m_symbols, m_arena, activity))
+    {
+        activity.orderId = {};
+    }
+
+    m_accountActivityHandler(activity);
+    ++m_delivered;
+
+    return true;
+}
+
+bool StreamerDecoder::skipObject(JsonScanner& scanner)
+{
+    // the '{' is already consumed
+    return scanner.skipValue(Token::BeginObject);
+}
+
+}
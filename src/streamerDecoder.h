@@ -0,0 +1,142 @@
+#ifndef __STREAMER_DECODER_H__
+#define __STREAMER_DECODER_H__
+
+#include <array>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "streamerData.h"
+#include "accountActivity.h"
+
+namespace schwabcpp {
+
+class JsonScanner;
+
+//
+// Decodes the streamed frames into typed updates in a single pass, without building a json tree.
+//
+// * A symbol filter and a field mask can be registered. They are consulted while scanning:
+//   content entries of uninteresting symbols are skipped as a whole (and their symbols never
+//   interned), fields outside of the mask are skipped without converting their values.
+//
+// * The update passed to the handler is reused between calls. Copy what you need.
+//
+// * The scratch space of a frame (the strings with escapes) comes from a monotonic arena that is
+//   rewound for every frame. It only falls back to the heap for unusually large frames.
+//
+// * Not thread-safe. Configure it before the frames start coming in, `decode(...)` is
+//   only called from the io context thread.
+//
+class StreamerDecoder
+{
+public:
+    using LevelOneEquityHandler = std::function<void(const LevelOneEquityUpdate&)>;
+    using LevelOneOptionHandler = std::function<void(const LevelOneOptionUpdate&)>;
+    using LevelOneFuturesHandler = std::function<void(const LevelOneFuturesUpdate&)>;
+    using LevelOneForexHandler = std::function<void(const LevelOneForexUpdate&)>;
+    using AccountActivityHandler = std::function<void(const AccountActivity&)>;
+
+    explicit                            StreamerDecoder(SymbolTable& symbols);
+
+    // the services without a handler are skipped
+    void                                setLevelOneEquityHandler(LevelOneEquityHandler handler) { m_levelOneEquity.handler = handler; }
+    void                                setLevelOneOptionHandler(LevelOneOptionHandler handler) { m_levelOneOption.handler = handler; }
+    void                                setLevelOneFuturesHandler(LevelOneFuturesHandler handler) { m_levelOneFutures.handler = handler; }
+    void                                setLevelOneForexHandler(LevelOneForexHandler handler) { m_levelOneForex.handler = handler; }
+    // the symbol filter doesn't apply to the account activity
+    void                                setAccountActivityHandler(AccountActivityHandler handler) { m_accountActivityHandler = handler; }
+
+    // only these symbols are decoded, an empty list removes the filter
+    void                                setSymbolFilter(const std::vector<SymbolId>& symbols);
+
+    // only these fields are converted (all by default)
+    void                                setLevelOneEquityFieldMask(const StreamerField::LevelOneEquityMask& mask) { m_levelOneEquity.mask = mask; }
+    void                                setLevelOneOptionFieldMask(const StreamerField::LevelOneOptionMask& mask) { m_levelOneOption.mask = mask; }
+    void                                setLevelOneFuturesFieldMask(const StreamerField::LevelOneFuturesMask& mask) { m_levelOneFutures.mask = mask; }
+    void                                setLevelOneForexFieldMask(const StreamerField::LevelOneForexMask& mask) { m_levelOneForex.mask = mask; }
+
+    // Decodes the price fields (see `StreamerField::isPrice`) as fixed point integers with the
+    // given decimals instead of doubles, for every service (forex quotes have 5). Off by default.
+    // At most 9 decimals, more are clamped (and logged).
+    void                                setFixedPointPrices(bool enabled, uint32_t decimals = 4);
+
+    bool                                hasHandlers() const
+    {
+        return m_levelOneEquity.handler || m_levelOneOption.handler || m_levelOneFutures.handler || m_levelOneForex.handler ||
+               m_accountActivityHandler;
+    }
+
+    // returns the number of updates delivered
+    size_t                              decode(std::string_view frame);
+
+    // Gives an update that didn't come from a frame (e.g. a rest snapshot) the symbol filter,
+    // field mask and price format of the streamed ones. Returns false if its symbol is filtered out.
+    bool                                conform(LevelOneEquityUpdate& update) const;
+
+private:
+    enum class Service : char {
+        Unknown,
+        LevelOneEquity,
+        LevelOneOption,
+        LevelOneFutures,
+        LevelOneForex,
+        AccountActivity,
+    };
+
+    // the decoding state of a service
+    template <typename Field>
+    struct Channel {
+        StreamerField::Mask<Field>      mask;
+        std::function<void(const StreamerUpdate<Field>&)>
+                                        handler;
+        StreamerUpdate<Field>           update;  // reused between entries
+    };
+
+    // the scanner is positioned right after the '{' of the object
+    bool                                decodeService(JsonScanner& scanner);
+    // false for the services not decoded (unknown or no handler)
+    bool                                wants(Service service) const;
+    bool                                decodeContent(JsonScanner& scanner, Service service, int64_t timestamp);
+    template <typename Field>
+    bool                                decodeContent(JsonScanner& scanner, Channel<Field>& channel, int64_t timestamp);
+    template <typename Field>
+    bool                                decodeEntry(JsonScanner& scanner, Channel<Field>& channel, int64_t timestamp);
+    bool                                decodeAccountActivity(JsonScanner& scanner, int64_t timestamp);
+    bool                                decodeAccountActivityEntry(JsonScanner& scanner, int64_t timestamp);
+
+    bool                                acceptSymbol(SymbolId id) const;
+
+    // skips to the end of the current object
+    static bool                         skipObject(JsonScanner& scanner);
+
+private:
+    SymbolTable&                        m_symbols;
+
+    std::vector<bool>                   m_symbolFilter;  // indexed by symbol id
+    bool                                m_filterSymbols;
+
+    bool                                m_fixedPointPrices;
+    uint32_t                            m_fixedPointDecimals;
+
+    Channel<StreamerField::LevelOneEquity>
+                                        m_levelOneEquity;
+    Channel<StreamerField::LevelOneOption>
+                                        m_levelOneOption;
+    Channel<StreamerField::LevelOneFutures>
+                                        m_levelOneFutures;
+    Channel<StreamerField::LevelOneForex>
+                                        m_levelOneForex;
+    AccountActivityHandler              m_accountActivityHandler;
+    AccountActivity                     m_accountActivity;  // reused between entries
+
+    size_t                              m_delivered;
+
+    // -- per frame scratch
+    std::array<std::byte, 4096>         m_arenaBuffer;
+    std::pmr::monotonic_buffer_resource m_arena;
+};
+
+}
+
+#endif
@@ -0,0 +1,323 @@
+#include "streamerDispatcher.h"
+#include "utils/logger.h"
+
+namespace schwabcpp {
+
+namespace {
+
+// updates handled from one lane before giving the other lanes a chance
+const static size_t s_laneBatchSize = 64;
+
+// how often an idle worker looks for lanes to steal
+const static std::chrono::milliseconds s_stealInterval(5);
+
+// of the strings of an item, always on the heap (the small string buffer is 15)
+const static size_t s_minStringsCapacity = 32;
+
+size_t homeWorker(SymbolId id, size_t workerCount)
+{
+    // the ids are dense, spread the neighbours out
+    return static_cast<size_t>((static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ull) >> 32) % workerCount;
+}
+
+}
+
+StreamerDispatcher::StreamerDispatcher(size_t workerCount)
+    : m_running(true)
+    , m_startTime(std::chrono::steady_clock::now())
+    , m_currentFrame(nullptr)
+{
+    workerCount = std::max<size_t>(workerCount, 1);
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // start after all the workers exist, they steal from each other
+    for (size_t i = 0; i < workerCount; ++i) {
+        m_workers[i]->thread = std::thread(&StreamerDispatcher::run, this, i);
+    }
+
+    LOG_DEBUG("Streamer dispatcher started with {} worker(s).", workerCount);
+}
+
+StreamerDispatcher::~StreamerDispatcher()
+{
+    m_running = false;
+
+    for (auto& worker : m_workers) {
+        {
+            std::lock_guard lock(worker->mutex);
+        }
+        worker->cv.notify_all();
+    }
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    LOG_TRACE("Streamer dispatcher stopped.");
+}
+
+void StreamerDispatcher::beginFrame(const std::string& frame, std::shared_ptr<const std::string> owner)
+{
+    m_currentFrame = &frame;
+    m_currentFrameOwner = std::move(owner);
+}
+
+void StreamerDispatcher::endFrame()
+{
+    m_currentFrame = nullptr;
+    m_currentFrameOwner.reset();
+}
+
+void StreamerDispatcher::post(const LevelOneEquityUpdate& update)
+{
+    postUpdate(update);
+}
+
+void StreamerDispatcher::post(const LevelOneOptionUpdate& update)
+{
+    postUpdate(update);
+}
+
+void StreamerDispatcher::post(const LevelOneFuturesUpdate& update)
+{
+    postUpdate(update);
+}
+
+void StreamerDispatcher::post(const LevelOneForexUpdate& update)
+{
+    postUpdate(update);
+}
+
+template <typename Field>
+void StreamerDispatcher::postUpdate(const StreamerUpdate<Field>& update)
+{
+    // The string values point into the frame (or into the decoder's scratch if they had escapes).
+    // Point them to something that lives as long as the item.
+    auto inFrame = [this](const FieldValue& value) {
+        return m_currentFrame &&
+               value.s >= m_currentFrame->data() &&
+               value.s + value.size <= m_currentFrame->data() + m_currentFrame->size();
+    };
+    // owned by the symbol table
+    auto inSymbolTable = [&update](const FieldValue& value) {
+        return value.s == update.symbol.data();
+    };
+
+    size_t outside = 0;
+    for (size_t i = 0; i < update.values.size(); ++i) {
+        const FieldValue& value = update.values[i];
+        if (!update.fields.test(i) || value.kind != StreamerField::Kind::String) {
+            continue;
+        }
+        if (inFrame(value)) {
+            if (!m_currentFrameOwner) {
+                m_currentFrameOwner = std::make_shared<const std::string>(*m_currentFrame);
+            }
+        } else if (!inSymbolTable(value)) {
+            outside += value.size;
+        }
+    }
+
+    Lane* lane = getLane(update.symbolId);
+
+    bool schedule = false;
+    {
+        std::lock_guard lock(lane->mutex);
+
+        // filled in place, the slot keeps the capacity of its strings
+        Item& item = lane->items.pushBack();
+        StreamerUpdate<Field>& queued = item.update.emplace<StreamerUpdate<Field>>(update);
+        item.frame = m_currentFrameOwner;
+        item.strings.clear();
+        if (outside > 0) {
+            // past the small string buffer, the values stay put when the item is moved or swapped
+            item.strings.reserve(std::max(outside, s_minStringsCapacity));
+        }
+
+        for (size_t i = 0; i < queued.values.size(); ++i) {
+            FieldValue& value = queued.values[i];
+            if (!queued.fields.test(i) || value.kind != StreamerField::Kind::String || inSymbolTable(value)) {
+                continue;
+            }
+            if (inFrame(value)) {
+                value.s = m_currentFrameOwner->data() + (value.s - m_currentFrame->data());
+            } else {
+                size_t offset = item.strings.size();
+                item.strings.append(value.s, value.size);
+                value.s = item.strings.data() + offset;
+            }
+        }
+
+        if (!lane->scheduled) {
+            lane->scheduled = true;
+            schedule = true;
+        }
+    }
+
+    if (schedule) {
+        this->schedule(lane);
+    }
+}
+
+std::vector<StreamerDispatcher::WorkerStats> StreamerDispatcher::stats() const
+{
+    const double elapsed = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_startTime).count()
+    );
+
+    std::vector<WorkerStats> result;
+    for (const auto& worker : m_workers) {
+        WorkerStats stats;
+        stats.processed = worker->processed;
+        stats.stolen = worker->stolen;
+        {
+            std::lock_guard lock(worker->mutex);
+            stats.pending = worker->ready.size();
+        }
+        stats.utilization = elapsed > 0 ? static_cast<double>(worker->busyNs) / elapsed : 0.0;
+        result.push_back(stats);
+    }
+
+    return result;
+}
+
+void StreamerDispatcher::run(size_t index)
+{
+    LOG_TRACE("Streamer dispatcher worker {} started.", index);
+
+    while (Lane* lane = takeLane(index)) {
+        process(index, lane);
+    }
+
+    LOG_TRACE("Streamer dispatcher worker {} terminated.", index);
+}
+
+StreamerDispatcher::Lane* StreamerDispatcher::takeLane(size_t index)
+{
+    Worker& self = *m_workers[index];
+
+    while (m_running) {
+        // our own lanes first
+        {
+            std::lock_guard lock(self.mutex);
+            if (!self.ready.empty()) {
+                Lane* lane = self.ready.front();
+                self.ready.popFront();
+                return lane;
+            }
+        }
+
+        // then steal a whole lane from the back of someone else's queue
+        for (size_t k = 1; k < m_workers.size(); ++k) {
+            Worker& other = *m_workers[(index + k) % m_workers.size()];
+            std::lock_guard lock(other.mutex);
+            if (!other.ready.empty()) {
+                Lane* lane = other.ready.back();
+                other.ready.popBack();
+                ++self.stolen;
+                return lane;
+            }
+        }
+
+        // nothing to do, wait for our own lanes (or check again for lanes to steal)
+        std::unique_lock lock(self.mutex);
+        self.cv.wait_for(lock, s_stealInterval, [this, &self] { return !self.ready.empty() || !m_running; });
+    }
+
+    return nullptr;
+}
+
+void StreamerDispatcher::schedule(Lane* lane)
+{
+    Worker& home = *m_workers[lane->home];
+
+    bool busy = false;
+    {
+        std::lock_guard lock(home.mutex);
+        home.ready.pushBack(lane);
+        busy = home.ready.size() > 1;
+    }
+    home.cv.notify_one();
+
+    // the home worker is behind, wake a neighbour to steal
+    if (busy && m_workers.size() > 1) {
+        m_workers[(lane->home + 1) % m_workers.size()]->cv.notify_one();
+    }
+}
+
+void StreamerDispatcher::process(size_t index, Lane* lane)
+{
+    Worker& self = *m_workers[index];
+
+    auto start = std::chrono::steady_clock::now();
+
+    // nobody else touches this lane until we hand it back
+    size_t count = 0;
+    Item& item = self.item;
+    while (count < s_laneBatchSize) {
+        {
+            // swapped, the slot gets the storage of the last handled item to reuse
+            std::lock_guard lock(lane->mutex);
+            if (lane->items.empty()) {
+                break;
+            }
+            std::swap(item, lane->items.front());
+            lane->items.popFront();
+        }
+
+        // don't let a handler take the worker down
+        try {
+            std::visit([this](const auto& update) {
+                if (const auto& handler = handlerOf(update)) {
+                    handler(update);
+                }
+            }, item.update);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Streamer handler threw: {}", e.what());
+        } catch (...) {
+            LOG_ERROR("Streamer handler threw.");
+        }
+        // the frame goes back to the receiver's pool, not into the slot
+        item.frame.reset();
+        ++count;
+    }
+
+    self.processed += count;
+    self.busyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // hand it back, or keep it in our queue if there is more
+    bool more = false;
+    {
+        std::lock_guard lock(lane->mutex);
+        more = !lane->items.empty();
+        lane->scheduled = more;
+    }
+    if (more) {
+        std::lock_guard lock(self.mutex);
+        self.ready.pushBack(lane);
+    }
+}
+
+StreamerDispatcher::Lane* StreamerDispatcher::getLane(SymbolId id)
+{
+    {
+        std::shared_lock lock(m_mutexLanes);
+        if (id < m_lanes.size()) {
+            return m_lanes[id].get();
+        }
+    }
+
+    std::unique_lock lock(m_mutexLanes);
+    while (m_lanes.size() <= id) {
+        auto lane = std::make_unique<Lane>();
+        lane->home = homeWorker(static_cast<SymbolId>(m_lanes.size()), m_workers.size());
+        m_lanes.push_back(std::move(lane));
+    }
+
+    return m_lanes[id].get();
+}
+
+}
@@ -0,0 +1,146 @@
+#ifndef __STREAMER_DISPATCHER_H__
+#define __STREAMER_DISPATCHER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include "schwabcpp/streamerData.h"
+#include "utils/ringQueue.h"
+
+namespace schwabcpp {
+
+//
+// Runs the typed streamer handlers on a pool of worker threads instead of the io context thread.
+//
+// * Every symbol has a lane, the updates of one symbol are handled in the order they arrived,
+//   one at a time. A lane is scheduled on the home worker of its symbol (picked by hashing the
+//   symbol id). An idle worker steals whole lanes from the others, never single updates, so the
+//   order within a symbol is kept.
+//
+// * The queued updates keep the frame they came from alive (shared with its owner, or copied once
+//   per frame if it has none and something got queued), so the string values stay valid in the handler.
+//   The few values that don't live in the frame (unescaped ones) are copied into the item.
+//
+// * The queues are rings of reused items, with the frames shared (and pooled by the receiver)
+//   posting and handling an update doesn't allocate once the rings are warmed up.
+//
+// * `beginFrame`/`endFrame`/`post` are called from the io context thread only.
+//
+class StreamerDispatcher
+{
+public:
+    using LevelOneEquityHandler = std::function<void(const LevelOneEquityUpdate&)>;
+    using LevelOneOptionHandler = std::function<void(const LevelOneOptionUpdate&)>;
+    using LevelOneFuturesHandler = std::function<void(const LevelOneFuturesUpdate&)>;
+    using LevelOneForexHandler = std::function<void(const LevelOneForexUpdate&)>;
+
+    struct WorkerStats {
+        size_t                          processed = 0;      // updates handled
+        size_t                          stolen = 0;         // lanes taken from other workers
+        size_t                          pending = 0;        // lanes waiting in the queue
+        double                          utilization = 0.0;  // busy time / lifetime, [0, 1]
+    };
+
+    explicit                            StreamerDispatcher(size_t workerCount);
+                                        ~StreamerDispatcher();
+
+    // set this before anything is posted
+    void                                setLevelOneEquityHandler(LevelOneEquityHandler handler) { m_levelOneEquityHandler = handler; }
+    void                                setLevelOneOptionHandler(LevelOneOptionHandler handler) { m_levelOneOptionHandler = handler; }
+    void                                setLevelOneFuturesHandler(LevelOneFuturesHandler handler) { m_levelOneFuturesHandler = handler; }
+    void                                setLevelOneForexHandler(LevelOneForexHandler handler) { m_levelOneForexHandler = handler; }
+
+    size_t                              workerCount() const { return m_workers.size(); }
+
+    // The frame the following posts are decoded from.
+    // If the frame has an owner, the queued updates share it, otherwise the frame is copied.
+    void                                beginFrame(const std::string& frame, std::shared_ptr<const std::string> owner = nullptr);
+    void                                endFrame();
+
+    // queues a copy of the update on the lane of its symbol
+    void                                post(const LevelOneEquityUpdate& update);
+    void                                post(const LevelOneOptionUpdate& update);
+    void                                post(const LevelOneFuturesUpdate& update);
+    void                                post(const LevelOneForexUpdate& update);
+
+    std::vector<WorkerStats>            stats() const;
+
+private:
+    using Frame = std::shared_ptr<const std::string>;
+
+    struct Item {
+        std::variant<LevelOneEquityUpdate,
+                     LevelOneOptionUpdate,
+                     LevelOneFuturesUpdate,
+                     LevelOneForexUpdate>
+                                        update;
+        Frame                           frame;
+        std::string                     strings;  // the string values that don't live in the frame
+    };
+
+    struct Lane {
+        std::mutex                      mutex;
+        RingQueue<Item>                 items;
+        bool                            scheduled = false;
+        size_t                          home = 0;
+    };
+
+    struct Worker {
+        std::thread                     thread;
+        std::mutex                      mutex;
+        std::condition_variable         cv;
+        RingQueue<Lane*>                ready;
+        Item                            item;  // the one being handled, swapped with the queued ones
+
+        std::atomic<size_t>             processed = 0;
+        std::atomic<size_t>             stolen = 0;
+        std::atomic<int64_t>            busyNs = 0;
+    };
+
+    template <typename Field>
+    void                                postUpdate(const StreamerUpdate<Field>& update);
+
+    // the handler of an update type
+    const LevelOneEquityHandler&        handlerOf(const LevelOneEquityUpdate&) const { return m_levelOneEquityHandler; }
+    const LevelOneOptionHandler&        handlerOf(const LevelOneOptionUpdate&) const { return m_levelOneOptionHandler; }
+    const LevelOneFuturesHandler&       handlerOf(const LevelOneFuturesUpdate&) const { return m_levelOneFuturesHandler; }
+    const LevelOneForexHandler&         handlerOf(const LevelOneForexUpdate&) const { return m_levelOneForexHandler; }
+
+    void                                run(size_t index);
+    Lane*                               takeLane(size_t index);  // nullptr when stopped
+    void                                schedule(Lane* lane);
+    void                                process(size_t index, Lane* lane);
+
+    Lane*                               getLane(SymbolId id);
+
+private:
+    LevelOneEquityHandler               m_levelOneEquityHandler;
+    LevelOneOptionHandler               m_levelOneOptionHandler;
+    LevelOneFuturesHandler              m_levelOneFuturesHandler;
+    LevelOneForexHandler                m_levelOneForexHandler;
+
+    // lanes indexed by symbol id, the pointers are stable
+    std::deque<std::unique_ptr<Lane>>   m_lanes;
+    mutable std::shared_mutex           m_mutexLanes;
+
+    std::vector<std::unique_ptr<Worker>>
+                                        m_workers;
+    std::atomic<bool>                   m_running;
+    std::chrono::steady_clock::time_point
+                                        m_startTime;
+
+    // -- current frame (io context thread only)
+    const std::string*                  m_currentFrame;
+    Frame                               m_currentFrameOwner;
+};
+
+}
+
+#endif
@@ -16,4 +16,46 @@ StreamerField::toLevelOneEquityField(const std::string& key)
     return result;
 }
 
+StreamerField::LevelOneOption
+StreamerField::toLevelOneOptionField(const std::string& key)
+{
+    LevelOneOption result(LevelOneOption::Unknown);
+
+    try {
+        result = static_cast<LevelOneOption>(std::stoi(key));
+    } catch (...) {
+        // do nothing
+    }
+
+    return result;
+}
+
+StreamerField::LevelOneFutures
+StreamerField::toLevelOneFuturesField(const std::string& key)
+{
+    LevelOneFutures result(LevelOneFutures::Unknown);
+
+    try {
+        result = static_cast<LevelOneFutures>(std::stoi(key));
+    } catch (...) {
+        // do nothing
+    }
+
+    return result;
+}
+
+StreamerField::LevelOneForex
+StreamerField::toLevelOneForexField(const std::string& key)
+{
+    LevelOneForex result(LevelOneForex::Unknown);
+
+    try {
+        result = static_cast<LevelOneForex>(std::stoi(key));
+    } catch (...) {
+        // do nothing
+    }
+
+    return result;
+}
+
 }
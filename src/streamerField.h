@@ -2,11 +2,23 @@
 #define __STREAMER_FIELD_H__
 
 #include <string>
+#include <bitset>
+#include <initializer_list>
 
 namespace schwabcpp {
 
 struct StreamerField {
 
+    // how the value of a field is decoded
+    enum class Kind : char {
+        None,
+        Double,
+        Long,
+        Bool,
+        String,
+        Fixed,      // a price decoded as fixed point, see `StreamerDecoder::setFixedPointPrices`
+    };
+
     enum class LevelOneEquity : int {
         Symbol = 0,
         BidPrice = 1,
@@ -64,7 +76,445 @@ struct StreamerField {
         Unknown,
     };
 
+    enum class LevelOneOption : int {
+        Symbol = 0,
+        Description = 1,
+        BidPrice = 2,
+        AskPrice = 3,
+        LastPrice = 4,
+        HighPrice = 5,
+        LowPrice = 6,
+        ClosePrice = 7,
+        TotalVolume = 8,
+        OpenInterest = 9,
+        Volatility = 10,
+        MoneyIntrinsicValue = 11,
+        ExpirationYear = 12,
+        Multiplier = 13,
+        Digits = 14,
+        OpenPrice = 15,
+        BidSize = 16,
+        AskSize = 17,
+        LastSize = 18,
+        NetChange = 19,
+        StrikePrice = 20,
+        ContractType = 21,
+        Underlying = 22,
+        ExpirationMonth = 23,
+        Deliverables = 24,
+        TimeValue = 25,
+        ExpirationDay = 26,
+        DaysToExpiration = 27,
+        Delta = 28,
+        Gamma = 29,
+        Theta = 30,
+        Vega = 31,
+        Rho = 32,
+        SecurityStatus = 33,
+        TheoreticalOptionValue = 34,
+        UnderlyingPrice = 35,
+        UVExpirationType = 36,
+        MarkPrice = 37,
+        QuoteTimeInLong = 38,
+        TradeTimeInLong = 39,
+        Exchange = 40,
+        ExchangeName = 41,
+        LastTradingDay = 42,
+        SettlementType = 43,
+        NetPercentChange = 44,
+        MarkPriceNetChange = 45,
+        MarkPricePercentChange = 46,
+        ImpliedYield = 47,
+        IsPennyPilot = 48,
+        OptionRoot = 49,
+        _52WeekHigh = 50,
+        _52WeekLow = 51,
+        IndicativeAskPrice = 52,
+        IndicativeBidPrice = 53,
+        IndicativeQuoteTime = 54,
+        ExerciseType = 55,
+
+        Unknown,
+    };
+
+    enum class LevelOneFutures : int {
+        Symbol = 0,
+        BidPrice = 1,
+        AskPrice = 2,
+        LastPrice = 3,
+        BidSize = 4,
+        AskSize = 5,
+        BidID = 6,
+        AskID = 7,
+        TotalVolume = 8,
+        LastSize = 9,
+        QuoteTimeInLong = 10,
+        TradeTimeInLong = 11,
+        HighPrice = 12,
+        LowPrice = 13,
+        ClosePrice = 14,
+        ExchangeID = 15,
+        Description = 16,
+        LastID = 17,
+        OpenPrice = 18,
+        NetChange = 19,
+        PercentChange = 20,
+        ExchangeName = 21,
+        SecurityStatus = 22,
+        OpenInterest = 23,
+        MarkPrice = 24,
+        Tick = 25,
+        TickAmount = 26,
+        Product = 27,
+        PriceFormat = 28,
+        TradingHours = 29,
+        IsTradable = 30,
+        Multiplier = 31,
+        IsActive = 32,
+        SettlementPrice = 33,
+        ActiveSymbol = 34,
+        ExpirationDate = 35,
+        ExpirationStyle = 36,
+        AskTime = 37,
+        BidTime = 38,
+        QuotedInSession = 39,
+        SettlementDate = 40,
+
+        Unknown,
+    };
+
+    enum class LevelOneForex : int {
+        Symbol = 0,
+        BidPrice = 1,
+        AskPrice = 2,
+        LastPrice = 3,
+        BidSize = 4,
+        AskSize = 5,
+        TotalVolume = 6,
+        LastSize = 7,
+        QuoteTimeInLong = 8,
+        TradeTimeInLong = 9,
+        HighPrice = 10,
+        LowPrice = 11,
+        ClosePrice = 12,
+        Exchange = 13,
+        Description = 14,
+        OpenPrice = 15,
+        NetChange = 16,
+        PercentChange = 17,
+        ExchangeName = 18,
+        Digits = 19,
+        SecurityStatus = 20,
+        Tick = 21,
+        TickAmount = 22,
+        Product = 23,
+        TradingHours = 24,
+        IsTradable = 25,
+        MarketMaker = 26,
+        _52WeekHigh = 27,
+        _52WeekLow = 28,
+        MarkPrice = 29,
+
+        Unknown,
+    };
+
     static LevelOneEquity toLevelOneEquityField(const std::string& key);
+    static LevelOneOption toLevelOneOptionField(const std::string& key);
+    static LevelOneFutures toLevelOneFuturesField(const std::string& key);
+    static LevelOneForex toLevelOneForexField(const std::string& key);
+
+    // number of fields of a field enum
+    template <typename Field>
+    static constexpr size_t fieldCount = static_cast<size_t>(Field::Unknown);
+
+    // a set of fields, one bit per field
+    template <typename Field>
+    using Mask = std::bitset<fieldCount<Field>>;
+
+    using LevelOneEquityMask = Mask<LevelOneEquity>;
+    using LevelOneOptionMask = Mask<LevelOneOption>;
+    using LevelOneFuturesMask = Mask<LevelOneFutures>;
+    using LevelOneForexMask = Mask<LevelOneForex>;
+
+    // usage:
+    //      auto mask = StreamerField::mask({ StreamerField::LevelOneEquity::BidPrice, StreamerField::LevelOneEquity::AskPrice });
+    template <typename Field>
+    static Mask<Field> mask(std::initializer_list<Field> fields)
+    {
+        Mask<Field> result;
+        for (Field field : fields) {
+            result.set(static_cast<size_t>(field));
+        }
+        return result;
+    }
+
+    static constexpr Kind kindOf(LevelOneEquity field)
+    {
+        switch (field) {
+            case LevelOneEquity::Symbol:
+            case LevelOneEquity::AskID:
+            case LevelOneEquity::BidID:
+            case LevelOneEquity::ExchangeID:
+            case LevelOneEquity::Description:
+            case LevelOneEquity::LastID:
+            case LevelOneEquity::ExchangeName:
+            case LevelOneEquity::DividendDate:
+            case LevelOneEquity::SecurityStatus:
+            case LevelOneEquity::AskMICID:
+            case LevelOneEquity::BidMICID:
+            case LevelOneEquity::LastMICID:
+                return Kind::String;
+
+            case LevelOneEquity::BidSize:
+            case LevelOneEquity::AskSize:
+            case LevelOneEquity::TotalVolume:
+            case LevelOneEquity::LastSize:
+            case LevelOneEquity::RegularMarketLastSize:
+            case LevelOneEquity::QuoteTimeInLong:
+            case LevelOneEquity::TradeTimeInLong:
+            case LevelOneEquity::RegularMarketTradeTimeInLong:
+            case LevelOneEquity::BidTime:
+            case LevelOneEquity::AskTime:
+            case LevelOneEquity::HardToBorrowQuantity:
+            case LevelOneEquity::HardToBorrow:
+            case LevelOneEquity::Shortable:
+                return Kind::Long;
+
+            case LevelOneEquity::Marginable:
+            case LevelOneEquity::RegularMarketQuote:
+            case LevelOneEquity::RegularMarketTrade:
+                return Kind::Bool;
+
+            case LevelOneEquity::Unknown:
+                return Kind::None;
+
+            default:
+                return Kind::Double;
+        }
+    }
+
+    static constexpr Kind kindOf(LevelOneOption field)
+    {
+        switch (field) {
+            case LevelOneOption::Symbol:
+            case LevelOneOption::Description:
+            case LevelOneOption::ContractType:
+            case LevelOneOption::Underlying:
+            case LevelOneOption::Deliverables:
+            case LevelOneOption::SecurityStatus:
+            case LevelOneOption::UVExpirationType:
+            case LevelOneOption::Exchange:
+            case LevelOneOption::ExchangeName:
+            case LevelOneOption::SettlementType:
+            case LevelOneOption::OptionRoot:
+            case LevelOneOption::ExerciseType:
+                return Kind::String;
+
+            case LevelOneOption::TotalVolume:
+            case LevelOneOption::OpenInterest:
+            case LevelOneOption::ExpirationYear:
+            case LevelOneOption::Digits:
+            case LevelOneOption::BidSize:
+            case LevelOneOption::AskSize:
+            case LevelOneOption::LastSize:
+            case LevelOneOption::ExpirationMonth:
+            case LevelOneOption::ExpirationDay:
+            case LevelOneOption::DaysToExpiration:
+            case LevelOneOption::QuoteTimeInLong:
+            case LevelOneOption::TradeTimeInLong:
+            case LevelOneOption::LastTradingDay:
+            case LevelOneOption::IndicativeQuoteTime:
+                return Kind::Long;
+
+            case LevelOneOption::IsPennyPilot:
+                return Kind::Bool;
+
+            case LevelOneOption::Unknown:
+                return Kind::None;
+
+            default:
+                return Kind::Double;
+        }
+    }
+
+    static constexpr Kind kindOf(LevelOneFutures field)
+    {
+        switch (field) {
+            case LevelOneFutures::Symbol:
+            case LevelOneFutures::BidID:
+            case LevelOneFutures::AskID:
+            case LevelOneFutures::ExchangeID:
+            case LevelOneFutures::Description:
+            case LevelOneFutures::LastID:
+            case LevelOneFutures::ExchangeName:
+            case LevelOneFutures::SecurityStatus:
+            case LevelOneFutures::Product:
+            case LevelOneFutures::PriceFormat:
+            case LevelOneFutures::TradingHours:
+            case LevelOneFutures::ActiveSymbol:
+            case LevelOneFutures::ExpirationStyle:
+                return Kind::String;
+
+            case LevelOneFutures::BidSize:
+            case LevelOneFutures::AskSize:
+            case LevelOneFutures::TotalVolume:
+            case LevelOneFutures::LastSize:
+            case LevelOneFutures::QuoteTimeInLong:
+            case LevelOneFutures::TradeTimeInLong:
+            case LevelOneFutures::OpenInterest:
+            case LevelOneFutures::ExpirationDate:
+            case LevelOneFutures::AskTime:
+            case LevelOneFutures::BidTime:
+            case LevelOneFutures::SettlementDate:
+                return Kind::Long;
+
+            case LevelOneFutures::IsTradable:
+            case LevelOneFutures::IsActive:
+            case LevelOneFutures::QuotedInSession:
+                return Kind::Bool;
+
+            case LevelOneFutures::Unknown:
+                return Kind::None;
+
+            default:
+                return Kind::Double;
+        }
+    }
+
+    static constexpr Kind kindOf(LevelOneForex field)
+    {
+        switch (field) {
+            case LevelOneForex::Symbol:
+            case LevelOneForex::Exchange:
+            case LevelOneForex::Description:
+            case LevelOneForex::ExchangeName:
+            case LevelOneForex::SecurityStatus:
+            case LevelOneForex::Product:
+            case LevelOneForex::TradingHours:
+            case LevelOneForex::MarketMaker:
+                return Kind::String;
+
+            case LevelOneForex::BidSize:
+            case LevelOneForex::AskSize:
+            case LevelOneForex::TotalVolume:
+            case LevelOneForex::LastSize:
+            case LevelOneForex::QuoteTimeInLong:
+            case LevelOneForex::TradeTimeInLong:
+            case LevelOneForex::Digits:
+                return Kind::Long;
+
+            case LevelOneForex::IsTradable:
+                return Kind::Bool;
+
+            case LevelOneForex::Unknown:
+                return Kind::None;
+
+            default:
+                return Kind::Double;
+        }
+    }
+
+    // the fields that can be decoded as fixed point (prices and price changes, not ratios)
+    static constexpr bool isPrice(LevelOneEquity field)
+    {
+        switch (field) {
+            case LevelOneEquity::BidPrice:
+            case LevelOneEquity::AskPrice:
+            case LevelOneEquity::LastPrice:
+            case LevelOneEquity::HighPrice:
+            case LevelOneEquity::LowPrice:
+            case LevelOneEquity::ClosePrice:
+            case LevelOneEquity::OpenPrice:
+            case LevelOneEquity::NetChange:
+            case LevelOneEquity::_52WeekHigh:
+            case LevelOneEquity::_52WeekLow:
+            case LevelOneEquity::AnnualDividendAmount:
+            case LevelOneEquity::NAV:
+            case LevelOneEquity::RegularMarketLastPrice:
+            case LevelOneEquity::RegularMarketNetChange:
+            case LevelOneEquity::MarkPrice:
+            case LevelOneEquity::MarkPriceNetChange:
+            case LevelOneEquity::PostMarketNetChange:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    static constexpr bool isPrice(LevelOneOption field)
+    {
+        switch (field) {
+            case LevelOneOption::BidPrice:
+            case LevelOneOption::AskPrice:
+            case LevelOneOption::LastPrice:
+            case LevelOneOption::HighPrice:
+            case LevelOneOption::LowPrice:
+            case LevelOneOption::ClosePrice:
+            case LevelOneOption::MoneyIntrinsicValue:
+            case LevelOneOption::OpenPrice:
+            case LevelOneOption::NetChange:
+            case LevelOneOption::StrikePrice:
+            case LevelOneOption::TimeValue:
+            case LevelOneOption::TheoreticalOptionValue:
+            case LevelOneOption::UnderlyingPrice:
+            case LevelOneOption::MarkPrice:
+            case LevelOneOption::MarkPriceNetChange:
+            case LevelOneOption::_52WeekHigh:
+            case LevelOneOption::_52WeekLow:
+            case LevelOneOption::IndicativeAskPrice:
+            case LevelOneOption::IndicativeBidPrice:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    static constexpr bool isPrice(LevelOneFutures field)
+    {
+        switch (field) {
+            case LevelOneFutures::BidPrice:
+            case LevelOneFutures::AskPrice:
+            case LevelOneFutures::LastPrice:
+            case LevelOneFutures::HighPrice:
+            case LevelOneFutures::LowPrice:
+            case LevelOneFutures::ClosePrice:
+            case LevelOneFutures::OpenPrice:
+            case LevelOneFutures::NetChange:
+            case LevelOneFutures::MarkPrice:
+            case LevelOneFutures::Tick:
+            case LevelOneFutures::TickAmount:
+            case LevelOneFutures::SettlementPrice:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    static constexpr bool isPrice(LevelOneForex field)
+    {
+        switch (field) {
+            case LevelOneForex::BidPrice:
+            case LevelOneForex::AskPrice:
+            case LevelOneForex::LastPrice:
+            case LevelOneForex::HighPrice:
+            case LevelOneForex::LowPrice:
+            case LevelOneForex::ClosePrice:
+            case LevelOneForex::OpenPrice:
+            case LevelOneForex::NetChange:
+            case LevelOneForex::Tick:
+            case LevelOneForex::TickAmount:
+            case LevelOneForex::_52WeekHigh:
+            case LevelOneForex::_52WeekLow:
+            case LevelOneForex::MarkPrice:
+                return true;
+
+            default:
+                return false;
+        }
+    }
 
 };
 
@@ -0,0 +1,236 @@
+#ifndef __STREAMER_STATE_TABLE_H__
+#define __STREAMER_STATE_TABLE_H__
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "schwabcpp/streamerData.h"
+
+namespace schwabcpp {
+
+//
+// The latest value of every field of every symbol, merged from the streamed updates.
+//
+// * Dense: the rows are indexed by symbol id (see `SymbolTable`), a row is a fixed array of field
+//   values. Tens of thousands of option contracts are one flat vector, applying an update copies
+//   its fields into the row, no lookup and no node per symbol.
+//
+// * Applying doesn't allocate once the row exists (`reserve(...)` the rows up front). The string
+//   values are copied into strings of the row that keep their capacity, most of them are short
+//   enough to be stored in place anyway.
+//
+// * Not thread-safe. The rows are independent though: with the rows reserved, the updates of
+//   different symbols can be applied concurrently (e.g. from the typed handler running on the
+//   dispatcher workers, which keeps the updates of a symbol in order). Only read a row that is
+//   not being applied.
+//
+// usage:
+//      LevelOneOptionState state;
+//      for (const std::string& contract : contracts) {
+//          state.reserve(client.getStreamerSymbolId(contract) + 1);
+//      }
+//      client.setStreamerLevelOneOptionHandler([&](const LevelOneOptionUpdate& update) {
+//          auto changed = state.apply(update);
+//          if (changed.test(static_cast<size_t>(StreamerField::LevelOneOption::MarkPrice))) {
+//              double mark = state.value(update.symbolId, StreamerField::LevelOneOption::MarkPrice).asPrice();
+//              ...
+//          }
+//      });
+//      client.startStreamer();
+//      client.subscribeLevelOneOptions(contracts, fields);
+//
+template <typename Field>
+class StreamerStateTable
+{
+public:
+    using Update = StreamerUpdate<Field>;
+    using FieldMask = StreamerField::Mask<Field>;
+
+    static constexpr size_t         FieldCount = StreamerField::fieldCount<Field>;
+
+    // rows for the ids below `symbols`
+    void                            reserve(size_t symbols) { if (symbols > m_rows.size()) m_rows.resize(symbols); }
+    size_t                          size() const { return m_rows.size(); }
+
+    // merges the fields of the update into the row of its symbol, returns the fields that changed
+    FieldMask                       apply(const Update& update);
+
+    // forgets a symbol (e.g. unsubscribed), the row keeps its storage
+    void                            erase(SymbolId id);
+    void                            clear() { for (SymbolId id = 0; id < m_rows.size(); ++id) erase(id); }
+
+    // -- the row of a symbol
+    bool                            contains(SymbolId id) const { return id < m_rows.size() && m_rows[id].fields.any(); }
+    // the fields received so far
+    FieldMask                       fields(SymbolId id) const { return id < m_rows.size() ? m_rows[id].fields : FieldMask(); }
+    // of the last update
+    int64_t                         timestamp(SymbolId id) const { return id < m_rows.size() ? m_rows[id].timestamp : 0; }
+    bool                            delayed(SymbolId id) const { return id < m_rows.size() && m_rows[id].delayed; }
+
+    // Kind::None if never received, a string value points into the table (valid until the row changes)
+    FieldValue                      value(SymbolId id, Field field) const;
+
+    // the whole row as an update, its string values point into the table (valid until the row changes)
+    Update                          snapshot(SymbolId id) const;
+
+private:
+    // the string fields get a slot in the row
+    static constexpr uint8_t        NoSlot = UINT8_MAX;
+
+    static constexpr std::array<uint8_t, FieldCount>
+                                    s_stringSlots = [] {
+                                        std::array<uint8_t, FieldCount> slots{};
+                                        uint8_t count = 0;
+                                        for (size_t i = 0; i < FieldCount; ++i) {
+                                            slots[i] = StreamerField::kindOf(static_cast<Field>(i)) == StreamerField::Kind::String ? count++ : NoSlot;
+                                        }
+                                        return slots;
+                                    }();
+
+    static constexpr size_t         StringCount = [] {
+                                        size_t count = 0;
+                                        for (uint8_t slot : s_stringSlots) {
+                                            count += slot != NoSlot;
+                                        }
+                                        return count;
+                                    }();
+
+    struct Row {
+        std::string_view            symbol;
+        int64_t                     timestamp = 0;
+        bool                        delayed = false;
+        FieldMask                   fields;
+        // the string values only keep their size, the characters are in `strings`
+        std::array<FieldValue, FieldCount>
+                                    values;
+        std::array<std::string, StringCount>
+                                    strings;
+    };
+
+    static bool                     equal(const FieldValue& left, const FieldValue& right);
+
+private:
+    std::vector<Row>                m_rows;
+};
+
+template <typename Field>
+typename StreamerStateTable<Field>::FieldMask StreamerStateTable<Field>::apply(const Update& update)
+{
+    reserve(static_cast<size_t>(update.symbolId) + 1);
+
+    Row& row = m_rows[update.symbolId];
+    row.symbol = update.symbol;
+    row.timestamp = update.timestamp;
+    row.delayed = update.delayed;
+
+    FieldMask changed;
+    for (size_t i = 0; i < FieldCount; ++i) {
+        if (!update.fields.test(i)) {
+            continue;
+        }
+
+        const FieldValue& value = update.values[i];
+        FieldValue& stored = row.values[i];
+
+        if (value.kind == StreamerField::Kind::String) {
+            std::string& text = row.strings[s_stringSlots[i]];
+            if (!row.fields.test(i) || text != value.asString()) {
+                text.assign(value.s, value.size);
+                changed.set(i);
+            }
+            stored.s = nullptr;
+            stored.size = value.size;
+            stored.kind = value.kind;
+        } else {
+            if (!row.fields.test(i) || !equal(stored, value)) {
+                changed.set(i);
+            }
+            stored = value;
+        }
+    }
+    row.fields |= update.fields;
+
+    return changed;
+}
+
+template <typename Field>
+void StreamerStateTable<Field>::erase(SymbolId id)
+{
+    if (id >= m_rows.size()) {
+        return;
+    }
+
+    Row& row = m_rows[id];
+    row.timestamp = 0;
+    row.delayed = false;
+    row.fields.reset();
+    for (std::string& text : row.strings) {
+        text.clear();
+    }
+}
+
+template <typename Field>
+FieldValue StreamerStateTable<Field>::value(SymbolId id, Field field) const
+{
+    const size_t index = static_cast<size_t>(field);
+    if (id >= m_rows.size() || index >= FieldCount || !m_rows[id].fields.test(index)) {
+        return FieldValue();
+    }
+
+    const Row& row = m_rows[id];
+    FieldValue result = row.values[index];
+    if (result.kind == StreamerField::Kind::String) {
+        result.s = row.strings[s_stringSlots[index]].data();
+    }
+
+    return result;
+}
+
+template <typename Field>
+typename StreamerStateTable<Field>::Update StreamerStateTable<Field>::snapshot(SymbolId id) const
+{
+    Update result;
+    if (!contains(id)) {
+        return result;
+    }
+
+    const Row& row = m_rows[id];
+    result.symbolId = id;
+    result.symbol = row.symbol;
+    result.timestamp = row.timestamp;
+    result.delayed = row.delayed;
+    result.fields = row.fields;
+    for (size_t i = 0; i < FieldCount; ++i) {
+        if (row.fields.test(i)) {
+            result.values[i] = value(id, static_cast<Field>(i));
+        }
+    }
+
+    return result;
+}
+
+template <typename Field>
+bool StreamerStateTable<Field>::equal(const FieldValue& left, const FieldValue& right)
+{
+    if (left.kind != right.kind) {
+        return false;
+    }
+
+    switch (left.kind) {
+        case StreamerField::Kind::Double: return left.d == right.d;
+        case StreamerField::Kind::Long:   return left.l == right.l;
+        case StreamerField::Kind::Bool:   return left.b == right.b;
+        case StreamerField::Kind::Fixed:  return left.l == right.l && left.size == right.size;
+        default:                          return false;
+    }
+}
+
+using LevelOneEquityState = StreamerStateTable<StreamerField::LevelOneEquity>;
+using LevelOneOptionState = StreamerStateTable<StreamerField::LevelOneOption>;
+using LevelOneFuturesState = StreamerStateTable<StreamerField::LevelOneFutures>;
+using LevelOneForexState = StreamerStateTable<StreamerField::LevelOneForex>;
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+#include "symbolTable.h"
+
+namespace schwabcpp {
+
+SymbolId SymbolTable::intern(std::string_view symbol)
+{
+    // most of the time the symbol is already there
+    {
+        std::shared_lock lock(m_mutex);
+        auto it = m_ids.find(symbol);
+        if (it != m_ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock(m_mutex);
+
+    // someone else might have added it in the meantime
+    auto it = m_ids.find(symbol);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+
+    SymbolId id = static_cast<SymbolId>(m_names.size());
+    m_names.emplace_back(symbol);
+    m_ids.emplace(m_names.back(), id);
+
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view symbol) const
+{
+    std::shared_lock lock(m_mutex);
+
+    auto it = m_ids.find(symbol);
+    return it != m_ids.end() ? it->second : InvalidId;
+}
+
+std::string_view SymbolTable::name(SymbolId id) const
+{
+    std::shared_lock lock(m_mutex);
+
+    return id < m_names.size() ? std::string_view(m_names[id]) : std::string_view();
+}
+
+size_t SymbolTable::size() const
+{
+    std::shared_lock lock(m_mutex);
+
+    return m_names.size();
+}
+
+}
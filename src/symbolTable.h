@@ -0,0 +1,46 @@
+#ifndef __SYMBOL_TABLE_H__
+#define __SYMBOL_TABLE_H__
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+#include <cstdint>
+
+namespace schwabcpp {
+
+using SymbolId = uint32_t;
+
+//
+// Interns symbols into dense ids (0, 1, 2, ...) so that per symbol data can live in flat arrays
+// and symbol sets can be bitsets. Ids are never reused. (Thread-Safe)
+//
+class SymbolTable
+{
+public:
+    inline static const SymbolId InvalidId = UINT32_MAX;
+
+    // returns the id of the symbol, assigns a new one if never seen
+    SymbolId                                    intern(std::string_view symbol);
+
+    // returns InvalidId if never seen
+    SymbolId                                    find(std::string_view symbol) const;
+
+    // the returned view stays valid for the lifetime of the table
+    std::string_view                            name(SymbolId id) const;
+
+    size_t                                      size() const;
+
+private:
+    // the keys are views into m_names, a deque doesn't move its elements
+    std::unordered_map<std::string_view, SymbolId>
+                                                m_ids;
+    std::deque<std::string>                     m_names;
+    mutable std::shared_mutex                   m_mutex;
+};
+
+}
+
+#endif
@@ -0,0 +1,28 @@
+#include "bufferPool.h"
+#include <atomic>
+
+namespace schwabcpp {
+
+SharedBuffer BufferPool::acquire()
+{
+    // round robin, the buffer we just handed out is the most likely to be still in use
+    for (size_t i = 0; i < m_buffers.size(); ++i) {
+        SharedBuffer& buffer = m_buffers[(m_next + i) % m_buffers.size()];
+        if (buffer.use_count() == 1) {
+            // the last owner released it on another thread, make sure we see what it did
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            m_next = (m_next + i + 1) % m_buffers.size();
+            buffer->clear();
+            return buffer;
+        }
+    }
+
+    SharedBuffer buffer = std::make_shared<std::string>();
+    if (m_buffers.size() < m_maxSize) {
+        m_buffers.push_back(buffer);
+    }
+    return buffer;
+}
+
+}
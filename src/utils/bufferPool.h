@@ -0,0 +1,44 @@
+#ifndef __BUFFER_POOL_H__
+#define __BUFFER_POOL_H__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace schwabcpp {
+
+// a received frame, shared by whoever still needs it
+using SharedBuffer = std::shared_ptr<std::string>;
+
+//
+// Recycles the receive buffers.
+//
+// * A buffer handed out by `acquire()` goes back to the pool on its own once every other owner
+//   released it (nobody but the pool holds a reference). Its capacity is kept, so after a few
+//   frames the buffers are large enough and receiving doesn't allocate anymore.
+//
+// * If every pooled buffer is still held somewhere (e.g. by queued updates), a new one is added,
+//   up to the max pool size. Beyond that the buffers are not pooled.
+//
+// * Not thread-safe, only the owner (the websocket session strand) acquires. The other owners
+//   may release their references from any thread.
+//
+class BufferPool
+{
+public:
+    explicit                            BufferPool(size_t maxSize = 64) : m_maxSize(maxSize), m_next(0) {}
+
+    // returns an empty buffer
+    SharedBuffer                        acquire();
+
+    size_t                              size() const { return m_buffers.size(); }
+
+private:
+    std::vector<SharedBuffer>           m_buffers;
+    size_t                              m_maxSize;
+    size_t                              m_next;
+};
+
+}
+
+#endif
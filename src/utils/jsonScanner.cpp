@@ -0,0 +1,206 @@
+#include "jsonScanner.h"
+
+namespace schwabcpp {
+
+namespace {
+
+inline bool isSeparator(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ':' || c == ',';
+}
+
+inline bool isNumberChar(char c)
+{
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+inline int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// returns the end of the written sequence (at most 4 chars)
+char* writeUtf8(unsigned codepoint, char* out)
+{
+    if (codepoint < 0x80) {
+        *out++ = static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (codepoint >> 6));
+        *out++ = static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (codepoint >> 12));
+        *out++ = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (codepoint >> 18));
+        *out++ = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+    return out;
+}
+
+}
+
+JsonScanner::Token JsonScanner::next()
+{
+    const size_t size = m_input.size();
+
+    while (m_pos < size && isSeparator(m_input[m_pos])) {
+        ++m_pos;
+    }
+
+    if (m_pos >= size) {
+        return Token::End;
+    }
+
+    const char c = m_input[m_pos];
+    switch (c) {
+        case '{': ++m_pos; return Token::BeginObject;
+        case '}': ++m_pos; return Token::EndObject;
+        case '[': ++m_pos; return Token::BeginArray;
+        case ']': ++m_pos; return Token::EndArray;
+
+        case '"': {
+            size_t begin = ++m_pos;
+            m_escaped = false;
+            while (m_pos < size && m_input[m_pos] != '"') {
+                if (m_input[m_pos] == '\\') {
+                    m_escaped = true;
+                    ++m_pos;  // skip the escaped char
+                }
+                ++m_pos;
+            }
+            if (m_pos >= size) {
+                return Token::Error;
+            }
+            m_text = m_input.substr(begin, m_pos - begin);
+            ++m_pos;  // closing quote
+            return Token::String;
+        }
+
+        case 't':
+        case 'f':
+        case 'n': {
+            size_t begin = m_pos;
+            while (m_pos < size && m_input[m_pos] >= 'a' && m_input[m_pos] <= 'z') {
+                ++m_pos;
+            }
+            m_text = m_input.substr(begin, m_pos - begin);
+            if (m_text == "true")  return Token::True;
+            if (m_text == "false") return Token::False;
+            if (m_text == "null")  return Token::Null;
+            return Token::Error;
+        }
+
+        default: {
+            if (!isNumberChar(c)) {
+                return Token::Error;
+            }
+            size_t begin = m_pos;
+            while (m_pos < size && isNumberChar(m_input[m_pos])) {
+                ++m_pos;
+            }
+            m_text = m_input.substr(begin, m_pos - begin);
+            return Token::Number;
+        }
+    }
+}
+
+bool JsonScanner::skipValue(Token first)
+{
+    if (first != Token::BeginObject && first != Token::BeginArray) {
+        return first != Token::End && first != Token::Error &&
+               first != Token::EndObject && first != Token::EndArray;
+    }
+
+    // we don't need to match the brackets, the input is assumed to be valid json
+    int depth = 1;
+    while (depth > 0) {
+        switch (next()) {
+            case Token::BeginObject:
+            case Token::BeginArray:
+                ++depth;
+                break;
+            case Token::EndObject:
+            case Token::EndArray:
+                --depth;
+                break;
+            case Token::End:
+            case Token::Error:
+                return false;
+            default:
+                break;
+        }
+    }
+
+    return true;
+}
+
+size_t JsonScanner::unescape(std::string_view raw, char* out)
+{
+    // (every escape sequence is at least as long as what it decodes to)
+    char* const begin = out;
+
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '\\' || i + 1 >= raw.size()) {
+            *out++ = c;
+            continue;
+        }
+
+        c = raw[++i];
+        switch (c) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                unsigned codepoint = 0;
+                bool valid = i + 4 < raw.size();
+                for (size_t k = 1; valid && k <= 4; ++k) {
+                    int h = hexValue(raw[i + k]);
+                    valid = h >= 0;
+                    codepoint = (codepoint << 4) | static_cast<unsigned>(h);
+                }
+                if (!valid) {
+                    *out++ = '?';
+                    break;
+                }
+                i += 4;
+
+                // surrogate pair
+                if (codepoint >= 0xD800 && codepoint <= 0xDBFF &&
+                    i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u')
+                {
+                    unsigned low = 0;
+                    bool validLow = true;
+                    for (size_t k = 3; validLow && k <= 6; ++k) {
+                        int h = hexValue(raw[i + k]);
+                        validLow = h >= 0;
+                        low = (low << 4) | static_cast<unsigned>(h);
+                    }
+                    if (validLow && low >= 0xDC00 && low <= 0xDFFF) {
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+
+                out = writeUtf8(codepoint, out);
+                break;
+            }
+            default:
+                // '"', '\\', '/'
+                *out++ = c;
+                break;
+        }
+    }
+
+    return out - begin;
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef __JSON_SCANNER_H__
+#define __JSON_SCANNER_H__
+
+#include <string_view>
+
+namespace schwabcpp {
+
+//
+// A minimal pull tokenizer over a json text that never allocates.
+//
+// * Tokens are views into the input. Strings are returned without the quotes and with their
+//   escape sequences untouched, use `unescape(...)` if `hasEscape()` is set.
+//
+// * ':' and ',' are treated as whitespace, the caller knows the structure it expects.
+//   Numbers are not converted, the caller decides whether it needs them.
+//
+class JsonScanner
+{
+public:
+    enum class Token : char {
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        End,
+        Error,
+    };
+
+    explicit                JsonScanner(std::string_view input) : m_input(input), m_pos(0), m_escaped(false) {}
+
+    Token                   next();
+
+    // raw text of the last String/Number/literal token
+    std::string_view        text() const { return m_text; }
+    bool                    hasEscape() const { return m_escaped; }
+
+    // skips the rest of the value whose first token is `first`
+    // returns false on malformed input
+    bool                    skipValue(Token first);
+
+    size_t                  position() const { return m_pos; }
+    void                    seek(size_t pos) { m_pos = pos; }
+
+    // Decodes the escape sequences of a raw string into `out`, returns the decoded length.
+    // The decoded string is never longer than the raw one, `out` must hold raw.size() chars.
+    static size_t           unescape(std::string_view raw, char* out);
+
+private:
+    std::string_view        m_input;
+    size_t                  m_pos;
+    std::string_view        m_text;
+    bool                    m_escaped;
+};
+
+}
+
+#endif
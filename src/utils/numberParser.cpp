@@ -0,0 +1,156 @@
+#include "numberParser.h"
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <iterator>
+
+namespace schwabcpp {
+
+namespace {
+
+const static int64_t s_pow10[] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL,
+};
+static_assert(std::size(s_pow10) == NumberParser::MaxFixedDecimals + 1);
+
+// the doubles that convert to an int64_t, 2^63 itself doesn't
+inline bool fitsLong(double value)
+{
+    return value >= -9223372036854775808.0 && value < 9223372036854775808.0;
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+}
+
+namespace NumberParser {
+
+bool parseDouble(std::string_view text, double& out)
+{
+    if (text.empty()) {
+        return false;
+    }
+
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto [ptr, ec] = std::from_chars(begin, end, out);
+    return ec == std::errc() && ptr == end;
+#else
+    // no floating point from_chars on this standard library, strtod needs a terminated string
+    char buffer[64];
+    if (text.size() >= sizeof(buffer)) {
+        return false;
+    }
+    text.copy(buffer, text.size());
+    buffer[text.size()] = '\0';
+    char* parsedEnd = nullptr;
+    out = std::strtod(buffer, &parsedEnd);
+    return parsedEnd == buffer + text.size();
+#endif
+}
+
+bool parseLong(std::string_view text, int64_t& out)
+{
+    if (text.empty()) {
+        return false;
+    }
+
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+
+    auto [ptr, ec] = std::from_chars(begin, end, out);
+    if (ec == std::errc() && ptr == end) {
+        return true;
+    }
+
+    // "1.0", "1e3"
+    double value = 0;
+    if (!parseDouble(text, value) || !fitsLong(value)) {
+        return false;
+    }
+    out = static_cast<int64_t>(value);
+    return true;
+}
+
+bool parseFixed(std::string_view text, uint32_t decimals, int64_t& out)
+{
+    if (text.empty() || decimals > MaxFixedDecimals) {
+        return false;
+    }
+
+    const char* p = text.data();
+    const char* end = text.data() + text.size();
+
+    bool negative = *p == '-';
+    if (negative) {
+        ++p;
+    }
+
+    const char* integerBegin = p;
+    int64_t integer = 0;
+    while (p != end && isDigit(*p)) {
+        if (__builtin_mul_overflow(integer, 10, &integer) ||
+            __builtin_add_overflow(integer, *p - '0', &integer))
+        {
+            return false;
+        }
+        ++p;
+    }
+    if (p == integerBegin) {
+        return false;
+    }
+
+    int64_t fraction = 0;
+    uint32_t fractionDigits = 0;
+    bool roundUp = false;
+    if (p != end && *p == '.') {
+        ++p;
+        while (p != end && isDigit(*p)) {
+            if (fractionDigits < decimals) {
+                fraction = fraction * 10 + (*p - '0');
+                ++fractionDigits;
+            } else if (fractionDigits == decimals) {
+                roundUp = *p >= '5';
+                ++fractionDigits;  // only the first extra digit matters
+            }
+            ++p;
+        }
+    }
+
+    if (p != end) {
+        // exponent (rare), go through double
+        double value = 0;
+        if (!parseDouble(text, value)) {
+            return false;
+        }
+        double scaled = std::round(value * static_cast<double>(s_pow10[decimals]));
+        if (!fitsLong(scaled)) {
+            return false;
+        }
+        out = static_cast<int64_t>(scaled);
+        return true;
+    }
+
+    for (uint32_t i = std::min(fractionDigits, decimals); i < decimals; ++i) {
+        fraction *= 10;
+    }
+
+    int64_t result = 0;
+    if (__builtin_mul_overflow(integer, s_pow10[decimals], &result) ||
+        __builtin_add_overflow(result, fraction + (roundUp ? 1 : 0), &result))
+    {
+        return false;
+    }
+    out = negative ? -result : result;
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,33 @@
+#ifndef __NUMBER_PARSER_H__
+#define __NUMBER_PARSER_H__
+
+#include <cstdint>
+#include <string_view>
+
+namespace schwabcpp {
+
+//
+// Converts json numbers straight from the received bytes, no copies, no locale.
+// The text doesn't need to be null terminated. Returns false if the text is not a number.
+//
+namespace NumberParser {
+
+bool parseDouble(std::string_view text, double& out);
+
+// numbers with a fraction or an exponent are converted through double and truncated,
+// fails if they don't fit
+bool parseLong(std::string_view text, int64_t& out);
+
+// the most decimals of a fixed point number
+inline constexpr uint32_t MaxFixedDecimals = 9;
+
+// Fixed point with the given decimals (e.g. "123.4567" with 2 decimals -> 12346).
+// Extra digits are rounded half away from zero. Fails if the decimals are over the max or the
+// value doesn't fit.
+bool parseFixed(std::string_view text, uint32_t decimals, int64_t& out);
+
+}
+
+}
+
+#endif
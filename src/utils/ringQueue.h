@@ -0,0 +1,78 @@
+#ifndef __RING_QUEUE_H__
+#define __RING_QUEUE_H__
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace schwabcpp {
+
+//
+// A fifo over a ring of slots.
+//
+// * The ring only grows (doubling), the slots are reused. Once it is large enough pushing and
+//   popping don't allocate, unlike a deque which allocates and frees its nodes as it goes.
+//
+// * The slots are not destroyed when popped, they keep whatever they hold (and its capacity)
+//   until they are reused. `pushBack()` hands out such a slot to be filled in place.
+//
+// * Not thread-safe.
+//
+template <typename T>
+class RingQueue
+{
+public:
+    explicit                            RingQueue(size_t capacity = 0) { reserve(capacity); }
+
+    bool                                empty() const { return m_size == 0; }
+    size_t                              size() const { return m_size; }
+    size_t                              capacity() const { return m_slots.size(); }
+
+    T&                                  front() { return m_slots[m_head]; }
+    T&                                  back() { return m_slots[slot(m_size - 1)]; }
+
+    // the new back slot, holding what it held before
+    T&                                  pushBack()
+    {
+        if (m_size == m_slots.size()) {
+            reserve(std::max<size_t>(m_slots.size() * 2, 8));
+        }
+        ++m_size;
+        return back();
+    }
+    void                                pushBack(T value) { pushBack() = std::move(value); }
+
+    void                                popFront() { m_head = slot(1); --m_size; }
+    void                                popBack() { --m_size; }
+
+    // rounded up to a power of two
+    void                                reserve(size_t capacity)
+    {
+        if (capacity <= m_slots.size()) {
+            return;
+        }
+        size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+
+        std::vector<T> slots(size);
+        for (size_t i = 0; i < m_size; ++i) {
+            slots[i] = std::move(m_slots[slot(i)]);
+        }
+        m_slots.swap(slots);
+        m_head = 0;
+    }
+
+private:
+    size_t                              slot(size_t i) const { return (m_head + i) & (m_slots.size() - 1); }
+
+private:
+    std::vector<T>                      m_slots;
+    size_t                              m_head = 0;
+    size_t                              m_size = 0;
+};
+
+}
+
+#endif
@@ -3,15 +3,18 @@
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast/ssl.hpp>
+#include <future>
 
 static std::string __port = "443";
 static std::string __path = "/ws";
 
 namespace schwabcpp {
 
-Websocket::Websocket(const std::string& url)
-    : m_sslContext(boost::asio::ssl::context::sslv23)
-    , m_workGuard(net::make_work_guard(m_ioContext))
+Websocket::Websocket(const std::string& url, net::io_context& ioContext, ssl::context& sslContext, const IoOptions& ioOptions)
+    : m_ioContext(ioContext)
+    , m_sslContext(sslContext)
+    , m_ioOptions(ioOptions)
+    , m_waitTimer(ioContext)
 {
     LOG_DEBUG("Initializing websocket...");
 
@@ -26,28 +29,35 @@ Websocket::Websocket(const std::string& url)
     if (pos != std::string::npos) {
         m_host = m_host.substr(0, pos);
     }
-
-    // ssl context settings
-    m_sslContext.set_verify_mode(boost::asio::ssl::verify_peer);
-    m_sslContext.load_verify_file("/etc/ssl/cert.pem");  // THIS IS REQUIRED
 }
 
 Websocket::~Websocket()
 {
-    LOG_TRACE("Shutting down websocket session...");
-    m_session->shutdown();
-    m_session.reset();
-
-    LOG_TRACE("Stopping websocket io context...");
-    // not using boost::asio::io_context::stop so that the io context
-    // will wait for the pending disconnect call to finish before exiting
-    m_workGuard.reset();
-    if (m_ioContextThread.joinable()) {
-        m_ioContextThread.join();
+    m_waitTimer.cancel();
+
+    if (m_session) {
+        LOG_TRACE("Shutting down websocket session...");
+
+        // The io context is shared, so we can't join it to wait for the pending disconnect call.
+        // Wait for the session to report back instead (unless we are on the io context thread,
+        // in which case the disconnect can't make progress until we return).
+        auto closed = std::make_shared<std::promise<void>>();
+        std::future<void> closedFuture = closed->get_future();
+        m_session->shutdown([closed] { closed->set_value(); });
+
+        if (!m_ioContext.get_executor().running_in_this_thread() &&
+            closedFuture.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+            LOG_WARN("Timed out waiting for the websocket session to close.");
+        }
+
+        m_session.reset();
     }
 }
 
-void Websocket::asyncConnect(std::function<void()> onConnected, std::function<void()> onReconnected)
+void Websocket::asyncConnect(
+    std::function<void()> onConnected,
+    std::function<void()> onReconnected,
+    std::function<void()> onDisconnected)
 {
     // session
     m_session = std::make_shared<WebsocketSession>(
@@ -55,23 +65,18 @@ void Websocket::asyncConnect(std::function<void()> onConnected, std::function<vo
         m_sslContext,
         m_host,
         __port,
-        __path
+        __path,
+        m_ioOptions
     );
 
-    // reconnect callback
+    // reconnect and disconnect callbacks
     m_session->onReconnect(onReconnected);
-    // queue connect call
+    m_session->onDisconnect(onDisconnected);
+    // queue connect call, the io context is already running
     m_session->asyncConnect(onConnected);
-    // run the io context
-    m_ioContextThread = std::thread(
-        [this]() {
-            m_ioContext.run();
-            LOG_TRACE("IO context thread terminated.");
-        }
-    );
 }
 
-void Websocket::asyncSend(const std::string& request, std::function<void()> callback)
+void Websocket::asyncSend(const std::string& request, WebsocketSession::SendHandler callback)
 {
     m_session->asyncSend(request, callback);
 }
@@ -81,7 +86,7 @@ void Websocket::asyncReceive(std::function<void(const std::string&)> callback)
     m_session->asyncReceive(callback);
 }
 
-void Websocket::startReceiverLoop(std::function<void(const std::string&)> callback)
+void Websocket::startReceiverLoop(WebsocketSession::FrameHandler callback)
 {
     m_session->startReceiverLoop(callback);
 }
@@ -91,4 +96,16 @@ void Websocket::stopReceiverLoop()
     m_session->stopReceiverLoop();
 }
 
+void Websocket::asyncWait(std::chrono::steady_clock::duration delay, std::function<void()> callback)
+{
+    m_waitTimer.expires_after(delay);
+    m_waitTimer.async_wait(
+        [callback](beast::error_code ec) {
+            if (!ec && callback) {
+                callback();
+            }
+        }
+    );
+}
+
 }
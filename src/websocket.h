@@ -2,7 +2,7 @@
 #define __WEBSOCKET_H__
 
 #include "websocketSession.h"
-#include <thread>
+#include <chrono>
 
 namespace schwabcpp {
 
@@ -13,30 +13,44 @@ class Websocket
     using ConnectionHandle = beast::websocket::stream<boost::asio::ssl::stream<beast::tcp_stream>>;
 
 public:
-                                            Websocket(const std::string& url);
+    // The io context and ssl context are not owned. They usually come from the ClientContext
+    // and are shared by every websocket of the context, so they must outlive the websocket.
+                                            Websocket(
+                                                const std::string& url,
+                                                net::io_context& ioContext,
+                                                ssl::context& sslContext,
+                                                const IoOptions& ioOptions = {}
+                                            );
                                             ~Websocket();
 
     // This is the entry point. The constructor doesn't connect but configures the websocket.
     // This should be called explicitly to establish the connection.
-    void                                    asyncConnect(std::function<void()> onConnected = {}, std::function<void()> onReconnected = {});
-    void                                    asyncSend(const std::string& request, std::function<void()> callback = {});
+    void                                    asyncConnect(
+                                                std::function<void()> onConnected = {},
+                                                std::function<void()> onReconnected = {},
+                                                std::function<void()> onDisconnected = {}
+                                            );
+    void                                    asyncSend(const std::string& request, WebsocketSession::SendHandler callback = {});
     void                                    asyncReceive(std::function<void(const std::string&)> callback);
 
-    void                                    startReceiverLoop(std::function<void(const std::string&)> callback);
+    void                                    startReceiverLoop(WebsocketSession::FrameHandler callback);
     void                                    stopReceiverLoop();
 
+    // Runs the callback on the io context after the delay, without blocking the io context.
+    // Pending waits are cancelled when the websocket is destroyed.
+    void                                    asyncWait(std::chrono::steady_clock::duration delay, std::function<void()> callback);
+
     bool                                    isConnected() const { return m_session ? m_session->isConnected() : false; }
 
 private:
     std::string                             m_host;
 
-    boost::asio::io_context                 m_ioContext;
-    boost::asio::ssl::context               m_sslContext;
+    boost::asio::io_context&                m_ioContext;
+    boost::asio::ssl::context&              m_sslContext;
+    IoOptions                               m_ioOptions;
     std::shared_ptr<WebsocketSession>       m_session;
 
-    net::executor_work_guard
-        <net::io_context::executor_type>    m_workGuard;
-    std::thread                             m_ioContextThread;
+    net::steady_timer                       m_waitTimer;
 };
 
 }
@@ -12,45 +12,38 @@ WebsocketSession::WebsocketSession(
     ssl::context& sslContext,
     const std::string& host,
     const std::string& port,
-    const std::string& path
+    const std::string& path,
+    const IoOptions& ioOptions
 )
     : m_ioContext(ioContext)
     , m_sslContext(sslContext)
     , m_host(host)
     , m_port(port)
     , m_path(path)
-    , m_state(CVState::Disconnected)
-    , m_resolver(net::make_strand(ioContext))
+    , m_ioOptions(ioOptions)
+    , m_strand(net::make_strand(ioContext))
+    , m_retryTimer(m_strand)
+    , m_stopped(false)
+    , m_resolver(m_strand)
     , m_receiverLoopRunning(false)
     , m_shouldReconnectReceiverLoop(false)
+    , m_state(CVState::Disconnected)
+    , m_writeInProgress(false)
 {
 }
 
 WebsocketSession::~WebsocketSession()
 {
-    shutdown();
-
-    // join here
-    if (m_senderDaemon.joinable()) {
-        m_senderDaemon.join();
-    }
+    // Nothing to do here. Every pending handler holds a reference to the session,
+    // so there is no outstanding operation left by the time we get destroyed.
 }
 
 void WebsocketSession::asyncConnect(std::function<void()> onFinalHandshake)
 {
-    // set the run sender daemon flag
-    // don't need mutex here, sender not launched yet
-    m_state.setFlag(CVState::RunSenderDaemon, true);
-
-    // launch the sender
-    // it will wait unitl connection established to start doing things
-    m_senderDaemon = std::thread(
-        &WebsocketSession::sendMessages,
-        shared_from_this()
-    );
+    m_stopped = false;
 
     // we need to create a new stream for every connection call
-    m_websocketStream = std::make_unique<WebsocketStream>(net::make_strand(m_ioContext), m_sslContext);
+    m_websocketStream = std::make_unique<WebsocketStream>(m_strand, m_sslContext);
 
     // start the procedure
     m_resolver.async_resolve(
@@ -73,20 +66,7 @@ void WebsocketSession::onResolve(
         LOG_WARN("Resolve failed. Error: {}. (Will retry in 10 seconds...)", ec.message());
 
         // retry after 10 seconds
-        std::this_thread::sleep_for(std::chrono::seconds(10));
-
-        // we need to create a new stream for reconnection
-        m_websocketStream = std::make_unique<WebsocketStream>(net::make_strand(m_ioContext), m_sslContext);
-
-        m_resolver.async_resolve(
-            m_host,
-            m_port,
-            beast::bind_front_handler(
-                &WebsocketSession::onResolve,
-                shared_from_this(),
-                onFinalHandshake
-            )
-        );
+        asyncRetryConnect(onFinalHandshake);
     } else {
         {
             std::lock_guard<std::mutex> lock(m_mutex_state);
@@ -118,21 +98,10 @@ void WebsocketSession::onConnect(
         LOG_ERROR("Connection failed. Error: {}. (Will retry in 10 seconds...)", ec.message());
 
         // retry after 10 seconds, restart from the very first step
-        std::this_thread::sleep_for(std::chrono::seconds(10));
-
-        // we need to create a new stream for reconnection
-        m_websocketStream = std::make_unique<WebsocketStream>(net::make_strand(m_ioContext), m_sslContext);
-
-        m_resolver.async_resolve(
-            m_host,
-            m_port,
-            beast::bind_front_handler(
-                &WebsocketSession::onResolve,
-                shared_from_this(),
-                onFinalHandshake
-            )
-        );
+        asyncRetryConnect(onFinalHandshake);
     } else {
+        configureSocket();
+
         // Set SNI Hostname (many hosts need this to handshake successfully)
         if (!SSL_set_tlsext_host_name(
                 m_websocketStream->next_layer().native_handle(),
@@ -164,6 +133,31 @@ void WebsocketSession::onConnect(
     }
 }
 
+void WebsocketSession::configureSocket()
+{
+    tcp::socket& socket = beast::get_lowest_layer(*m_websocketStream).socket();
+    beast::error_code ec;
+
+    if (m_ioOptions.tcpNoDelay) {
+        socket.set_option(tcp::no_delay(true), ec);
+        if (ec) {
+            LOG_WARN("Unable to set TCP_NODELAY. Error: {}", ec.message());
+        }
+    }
+    if (m_ioOptions.socketReceiveBufferSize > 0) {
+        socket.set_option(net::socket_base::receive_buffer_size(m_ioOptions.socketReceiveBufferSize), ec);
+        if (ec) {
+            LOG_WARN("Unable to set the socket receive buffer size. Error: {}", ec.message());
+        }
+    }
+    if (m_ioOptions.socketSendBufferSize > 0) {
+        socket.set_option(net::socket_base::send_buffer_size(m_ioOptions.socketSendBufferSize), ec);
+        if (ec) {
+            LOG_WARN("Unable to set the socket send buffer size. Error: {}", ec.message());
+        }
+    }
+}
+
 void WebsocketSession::onSSLHandshake(
     std::function<void()> onFinalHandshake,
     beast::error_code ec)
@@ -172,20 +166,7 @@ void WebsocketSession::onSSLHandshake(
         LOG_ERROR("SSL handshake failed. Error: {}. (Will retry in 10 seconds...)", ec.message());
 
         // retry after 10 seconds, restart from the very first step
-        std::this_thread::sleep_for(std::chrono::seconds(10));
-
-        // we need to create a new stream for reconnection
-        m_websocketStream = std::make_unique<WebsocketStream>(net::make_strand(m_ioContext), m_sslContext);
-
-        m_resolver.async_resolve(
-            m_host,
-            m_port,
-            beast::bind_front_handler(
-                &WebsocketSession::onResolve,
-                shared_from_this(),
-                onFinalHandshake
-            )
-        );
+        asyncRetryConnect(onFinalHandshake);
     } else {
         {
             std::lock_guard<std::mutex> lock(m_mutex_state);
@@ -237,20 +218,7 @@ void WebsocketSession::onWebsocketHandshake(
         LOG_ERROR("Websocket handshake failed. Error: {}. (Will retry in 10 seconds...)", ec.message());
 
         // retry after 10 seconds, restart from the very first step
-        std::this_thread::sleep_for(std::chrono::seconds(10));
-
-        // we need to create a new stream for reconnection
-        m_websocketStream = std::make_unique<WebsocketStream>(net::make_strand(m_ioContext), m_sslContext);
-
-        m_resolver.async_resolve(
-            m_host,
-            m_port,
-            beast::bind_front_handler(
-                &WebsocketSession::onResolve,
-                shared_from_this(),
-                onFinalHandshake
-            )
-        );
+        asyncRetryConnect(onFinalHandshake);
     } else {
         LOG_DEBUG("Websocket successfully connected to {}.", m_host);
 
@@ -261,8 +229,8 @@ void WebsocketSession::onWebsocketHandshake(
             m_state.setState(CVState::WebsocketHandshaked);
         }
 
-        // notify the connection status
-        m_cv.notify_all();
+        // flush whatever got queued while we were connecting
+        doWrite();
 
         // invoke the callback
         if (onFinalHandshake) {
@@ -273,25 +241,45 @@ void WebsocketSession::onWebsocketHandshake(
     }
 }
 
+void WebsocketSession::asyncRetryConnect(std::function<void()> onFinalHandshake)
+{
+    // wait on the timer instead of sleeping, the io context might be serving other sessions
+    m_retryTimer.expires_after(std::chrono::seconds(10));
+    m_retryTimer.async_wait(
+        [self = shared_from_this(), onFinalHandshake](beast::error_code ec) {
+            if (ec || self->m_stopped) {
+                LOG_TRACE("Connection retry cancelled.");
+                return;
+            }
+
+            // we need to create a new stream for reconnection
+            self->m_websocketStream = std::make_unique<WebsocketStream>(self->m_strand, self->m_sslContext);
+
+            self->m_resolver.async_resolve(
+                self->m_host,
+                self->m_port,
+                beast::bind_front_handler(
+                    &WebsocketSession::onResolve,
+                    self,
+                    onFinalHandshake
+                )
+            );
+        }
+    );
+}
+
 void WebsocketSession::asyncDisconnect(std::function<void()> callback)
 {
     // update the flag to Disconnected
-    // unset RunSenderDaemon and RunReceiverLoop
+    // unset RunReceiverLoop
     // should stop auto reconnection when disconnect is called
     {
         std::lock_guard<std::mutex> lock(m_mutex_state);
         m_state.setState(CVState::Disconnected);
         m_state.setFlag(CVState::RunReceiverLoop, false);
-        m_state.setFlag(CVState::RunSenderDaemon, false);
         m_shouldReconnectReceiverLoop = false;
     }
 
-    // stop the sender daemon if it is running
-    if (m_senderDaemon.joinable()) {
-        LOG_TRACE("Stopping websocket session sender daemon...");
-        m_cv.notify_all();
-    }
-
     if (m_websocketStream) {
         if (m_websocketStream->is_open()) {
             // close if open
@@ -362,8 +350,16 @@ void WebsocketSession::onClose(
         }
 
     } else if (ec) {
-        // this is error
+        // this is error, nothing more we can do with the stream
         LOG_ERROR("Close failed. Error: {}", ec.message());
+
+        // release (must do it before triggering callback)
+        m_websocketStream.reset();
+
+        // callback
+        if (callback) {
+            callback();
+        }
     } else {
         // drain
         LOG_TRACE("Draining websocket stream...");
@@ -396,8 +392,16 @@ void WebsocketSession::drainOnClose(
             callback();
         }
     } else if (ec) {
-        // this is error
+        // this is error, nothing more we can do with the stream
         LOG_ERROR("Unable to drain websocket stream. Error: {}", ec.message());
+
+        // release (must do it before triggering callback)
+        m_websocketStream.reset();
+
+        // callback
+        if (callback) {
+            callback();
+        }
     } else {
         // recursive read
         LOG_TRACE("Draining websocket stream...");
@@ -412,46 +416,87 @@ void WebsocketSession::drainOnClose(
     }
 }
 
-void WebsocketSession::asyncSend(const std::string& request, std::function<void()> callback)
+void WebsocketSession::asyncSend(const std::string& request, SendHandler callback)
 {
     // put things in the message queue
     {
         std::lock_guard lock(m_mutex_messageQ);
         m_messageQueue.emplace(std::move(request), callback);
     }
-    // set the flag
+    // kick the writer
+    net::post(m_strand, [self = shared_from_this()] { self->doWrite(); });
+}
+
+void WebsocketSession::doWrite()
+{
+    // one write at a time, the completion handler picks up the next message
+    if (m_writeInProgress || !m_websocketStream) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex_state);
+        if (!m_state.testState(CVState::WebsocketHandshaked)) {
+            // the handshake handler will flush the queue
+            return;
+        }
+    }
+
     {
-        std::lock_guard lock(m_mutex_state);
-        m_state.setFlag(CVState::MessageQueueNotEmpty, true);
+        std::lock_guard<std::mutex> lock(m_mutex_messageQ);
+        if (m_messageQueue.empty()) {
+            return;
+        }
+        m_pendingWrite = std::move(m_messageQueue.front());
+        m_messageQueue.pop();
     }
-    // notify sender
-    m_cv.notify_one();
+
+    LOG_TRACE("Websocket session sending message...");
+
+    m_writeInProgress = true;
+    m_websocketStream->async_write(
+        net::buffer(m_pendingWrite.request),
+        beast::bind_front_handler(
+            &WebsocketSession::onWrite,
+            shared_from_this(),
+            m_pendingWrite.callback
+        )
+    );
 }
 
 void WebsocketSession::onWrite(
-    std::function<void()> callback,
+    SendHandler callback,
     beast::error_code ec,
     std::size_t bytesTransferred)
 {
+    m_writeInProgress = false;
+
+    // A failed write usually means the connection is gone, and the owner resends what it needs
+    // after reconnecting (e.g. the streamer's login and subscriptions). Not requeued, the sender
+    // gets the error instead.
     if (ec) {
-        LOG_ERROR("Websocket write failed. Error: {}", ec.message());
-    } else {
-        if (callback) {
-            callback();
-        }
+        LOG_ERROR("Websocket write failed, a {} byte message is lost. Error: {}", m_pendingWrite.request.size(), ec.message());
     }
+    if (callback) {
+        callback(ec);
+    }
+
+    // next one
+    doWrite();
 }
 
 void WebsocketSession::asyncReceive(std::function<void(const std::string&)> callback)
 {
-    m_websocketStream->async_read(
-        m_buffer,
-        beast::bind_front_handler(
-            &WebsocketSession::onRead,
-            shared_from_this(),
-            callback
-        )
-    );
+    net::post(m_strand, [self = shared_from_this(), callback] {
+        self->m_websocketStream->async_read(
+            self->m_buffer,
+            beast::bind_front_handler(
+                &WebsocketSession::onRead,
+                self,
+                callback
+            )
+        );
+    });
 }
 
 void WebsocketSession::onRead(
@@ -473,7 +518,7 @@ void WebsocketSession::onRead(
     m_buffer.clear();
 }
 
-void WebsocketSession::startReceiverLoop(std::function<void(const std::string&)> callback)
+void WebsocketSession::startReceiverLoop(FrameHandler callback)
 {
     LOG_DEBUG("Websocket session starting receiver loop...");
 
@@ -483,24 +528,35 @@ void WebsocketSession::startReceiverLoop(std::function<void(const std::string&)>
         m_state.setFlag(CVState::RunReceiverLoop, true);
     }
 
-    if (!m_receiverLoopRunning) {
-        m_receiverLoopRunning = true;
-        m_shouldReconnectReceiverLoop = true;  // auto reconnect
+    net::post(m_strand, [self = shared_from_this(), callback] {
+        if (!self->m_receiverLoopRunning) {
+            self->m_receiverLoopRunning = true;
+            self->m_shouldReconnectReceiverLoop = true;  // auto reconnect
+            self->m_receiverLoopCallback = callback;
 
-        // put a timeout for the read op
-        beast::get_lowest_layer(*m_websocketStream).expires_after(std::chrono::seconds(30));
+            self->readNextFrame();
+        } else {
+            LOG_TRACE("Websocket session receiver loop already running.");
+        }
+    });
+}
 
-        m_websocketStream->async_read(
-            m_buffer,
-            beast::bind_front_handler(
-                &WebsocketSession::onReceiveLoop,
-                shared_from_this(),
-                callback
-            )
-        );
-    } else {
-        LOG_TRACE("Websocket session receiver loop already running.");
-    }
+void WebsocketSession::readNextFrame()
+{
+    // a recycled buffer unless the previous frames are still held somewhere
+    m_frameBuffer = m_bufferPool.acquire();
+    m_frameReadBuffer.emplace(*m_frameBuffer);
+
+    // put a timeout for the read op
+    beast::get_lowest_layer(*m_websocketStream).expires_after(std::chrono::seconds(30));
+
+    m_websocketStream->async_read(
+        *m_frameReadBuffer,
+        beast::bind_front_handler(
+            &WebsocketSession::onReceiveLoop,
+            shared_from_this()
+        )
+    );
 }
 
 void WebsocketSession::stopReceiverLoop()
@@ -521,7 +577,6 @@ void WebsocketSession::stopReceiverLoop()
 }
 
 void WebsocketSession::onReceiveLoop(
-    std::function<void(const std::string&)> callback,
     beast::error_code ec,
     std::size_t bytesTransferred)
 {
@@ -537,6 +592,9 @@ void WebsocketSession::onReceiveLoop(
 
         // reconnect
         if (m_shouldReconnectReceiverLoop) {
+            if (m_onDisconnection) {
+                m_onDisconnection();
+            }
             asyncReconnect();
         }
     } else {
@@ -549,27 +607,20 @@ void WebsocketSession::onReceiveLoop(
             lock.unlock();
 
             LOG_TRACE("Websocket not connected, stopping websocket session receiver loop...");
-            m_buffer.clear();
+            m_frameBuffer.reset();
         } else if (m_state.testFlag(CVState::RunReceiverLoop)) {
             lock.unlock();
 
-            if (callback) {
-                callback(beast::buffers_to_string(m_buffer.data()));
-            }
-            m_buffer.clear();
+            // the string might have some room prepared beyond the frame
+            m_frameBuffer->resize(m_frameReadBuffer->size());
 
-            // put a timeout for the next read op
-            beast::get_lowest_layer(*m_websocketStream).expires_after(std::chrono::seconds(30));
+            if (m_receiverLoopCallback) {
+                m_receiverLoopCallback(m_frameBuffer);
+            }
+            m_frameBuffer.reset();
 
             // queue the next read
-            m_websocketStream->async_read(
-                m_buffer,
-                beast::bind_front_handler(
-                    &WebsocketSession::onReceiveLoop,
-                    shared_from_this(),
-                    callback
-                )
-            );
+            readNextFrame();
         } else {
             lock.unlock();
             m_receiverLoopRunning = false;
@@ -586,10 +637,6 @@ void WebsocketSession::asyncReconnect()
 
     // disconnect then connect for a fresh restart
     asyncDisconnect([self = shared_from_this()] {
-        if (self->m_senderDaemon.joinable()) {
-            self->m_senderDaemon.join();
-        }
-
         // connect
         self->asyncConnect(self->m_onReconnection);
     });
@@ -601,58 +648,14 @@ bool WebsocketSession::isConnected() const
     return m_state.testState(CVState::WebsocketHandshaked);
 }
 
-void WebsocketSession::shutdown()
+void WebsocketSession::shutdown(std::function<void()> callback)
 {
-    asyncDisconnect();
-}
-
-// -- sender daemon
-void WebsocketSession::sendMessages()
-{
-    std::unique_lock<std::mutex> stateLock(m_mutex_state);
-    while (m_state.testFlag(CVState::RunSenderDaemon)) {
-
-        // now we will wati until the state flag is notified and post check should wake sender
-        m_cv.wait(stateLock, [self = shared_from_this()] { return self->m_state.shouldWakeSender(); });
-
-        // if we woke up because the run flag is unset, break
-        if (!m_state.testFlag(CVState::RunSenderDaemon)) break;
-
-        LOG_TRACE("Websocket session message queue size: {}", m_messageQueue.size());
-
-        // send all while connected
-        std::unique_lock<std::mutex> queueLock(m_mutex_messageQ);
-        while (!m_messageQueue.empty() && m_state.testState(CVState::WebsocketHandshaked)) {
-            // done checking state, release
-            stateLock.unlock();
-
-            MessageData payload = m_messageQueue.front();
-            m_messageQueue.pop();
-
-            // dequeue complete, release
-            queueLock.unlock();
-
-            // consecutive writes has to be blocking
-            // TODO:
-            // add error handling here, this is not guaranteed to succeed
-            m_websocketStream->write(net::buffer(payload.request));
-            // run the callback
-            if (payload.callback) {
-                payload.callback();
-            }
-
-            // lock before checking the queue and state
-            queueLock.lock();
-            stateLock.lock();
-        }
-
-        // queue and state are locked at this point
-        if (m_messageQueue.empty()) {
-            m_state.setFlag(CVState::MessageQueueNotEmpty, false);
-        }
-    }
+    net::post(m_strand, [self = shared_from_this(), callback] {
+        self->m_stopped = true;
+        self->m_retryTimer.cancel();
+        self->asyncDisconnect(callback);
+    });
 }
-
 // -- CVState
 WebsocketSession::CVState::CVState(State state)
     : _flag(0x0)
@@ -683,13 +686,4 @@ bool WebsocketSession::CVState::testState(State state) const
     return _state == state;
 }
 
-bool WebsocketSession::CVState::shouldWakeSender() const
-{
-    // when should we wake the sender?
-    // 1. websocket handshake successful and messeage queue not empty
-    // 2. when the run sender flag is unset 
-    return testState(CVState::WebsocketHandshaked) && testFlag(CVState::MessageQueueNotEmpty)
-        || !testFlag(CVState::RunSenderDaemon);
-}
-
 }
@@ -2,8 +2,11 @@
 #define __WEBSOCKET_SESSION_H__
 
 #include <memory>
+#include <mutex>
 #include <queue>
-#include <thread>
+#include <optional>
+#include "utils/bufferPool.h"
+#include "ioOptions.h"
 
 // NOTE: boost is very heavy, maintain minimal include headers
 // Required types are:
@@ -13,12 +16,18 @@
 //      boost::asio::ssl::stream
 //      boost::beast::core::tcp_stream
 //      boost::beast::websocket::stream
+//      boost::asio::strand
+//      boost::asio::steady_timer
+//      boost::asio::dynamic_string_buffer
 #include <boost/beast/core/tcp_stream.hpp>
 #include <boost/beast/websocket/stream.hpp>
 #include <boost/asio/ssl/context.hpp>
 #include <boost/asio/ssl/stream.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/buffer.hpp>
 
 namespace schwabcpp {
 
@@ -31,13 +40,22 @@ using tcp = boost::asio::ip::tcp;       // from <boost/asio/ip/tcp.hpp>
 class WebsocketSession : public std::enable_shared_from_this<WebsocketSession>
 {
     using WebsocketStream = websocket::stream<ssl::stream<beast::tcp_stream>>;
+    using ReadBuffer = net::dynamic_string_buffer<char, std::char_traits<char>, std::allocator<char>>;
 public:
+    // The frames of the receiver loop come in pooled buffers. Keep the reference to keep the
+    // frame, the buffer is recycled once every reference is gone.
+    using FrameHandler = std::function<void(const SharedBuffer&)>;
+
+    // called once the message is written, or with the error if the write failed (the message is lost)
+    using SendHandler = std::function<void(beast::error_code)>;
+
     explicit                                            WebsocketSession(
                                                             net::io_context& ioContext,
                                                             ssl::context& sslContext,
                                                             const std::string& host,
                                                             const std::string& port,
-                                                            const std::string& path
+                                                            const std::string& path,
+                                                            const IoOptions& ioOptions = {}
                                                         );
                                                         ~WebsocketSession();
 
@@ -46,17 +64,22 @@ public:
     // desgin.
     void                                                asyncConnect(std::function<void()> onFinalHandshake = {});
 
-    void                                                asyncSend(const std::string& request, std::function<void()> callback = {});
+    void                                                asyncSend(const std::string& request, SendHandler callback = {});
     void                                                asyncReceive(std::function<void(const std::string&)> callback);
 
-    void                                                startReceiverLoop(std::function<void(const std::string&)> callback);
+    void                                                startReceiverLoop(FrameHandler callback);
     void                                                stopReceiverLoop();
 
     bool                                                isConnected() const;
 
     void                                                onReconnect(std::function<void()> callback) { m_onReconnection = callback; }
 
-    void                                                shutdown();
+    // invoked when the receiver loop fails unexpectedly, right before reconnecting
+    void                                                onDisconnect(std::function<void()> callback) { m_onDisconnection = callback; }
+
+    // Closes the connection and stops any auto reconnection.
+    // The callback is invoked once the stream is released.
+    void                                                shutdown(std::function<void()> callback = {});
 
 private:
     void                                                onResolve(
@@ -83,12 +106,11 @@ private:
                                                             std::size_t bytesTransferred
                                                         );
     void                                                onWrite(
-                                                            std::function<void()> callback,
+                                                            SendHandler callback,
                                                             beast::error_code ec,
                                                             std::size_t bytesTransferred
                                                         );
     void                                                onReceiveLoop(
-                                                            std::function<void(const std::string&)> callback,
                                                             beast::error_code ec,
                                                             std::size_t bytesTransferred
                                                         );
@@ -107,9 +129,19 @@ private:
     // this is for reconnecting when the read loop fails
     void                                                asyncReconnect();
 
-    // what the sender daemon runs
+    // this is for retrying when any step of the connection procedure fails
+    void                                                asyncRetryConnect(std::function<void()> onFinalHandshake);
+
+    // applies the socket options of the io options to the connected socket
+    void                                                configureSocket();
+
+    // writes the message queue one message at a time, always runs on the strand
 private:
-    void                                                sendMessages();
+    void                                                doWrite();
+
+    // queues the next read of the receiver loop into a pooled buffer, always runs on the strand
+private:
+    void                                                readNextFrame();
 
 private:
     // -- need a reference to these to reconnect the stream
@@ -120,31 +152,40 @@ private:
     std::string                                         m_host;
     std::string                                         m_port;
     std::string                                         m_path;
+    IoOptions                                           m_ioOptions;
     beast::flat_buffer                                  m_buffer;
 
+    // -- every operation of this session runs on this strand
+    //    the io context may be shared by many sessions
+    net::strand<net::io_context::executor_type>         m_strand;
+    net::steady_timer                                   m_retryTimer;
+    bool                                                m_stopped;
+
     // -- callback on reconnection
     std::function<void()>                               m_onReconnection;
 
+    // -- callback on unexpected disconnection
+    std::function<void()>                               m_onDisconnection;
+
     // -- handles
     tcp::resolver                                       m_resolver;
     std::unique_ptr<WebsocketStream>                    m_websocketStream;
 
     // -- receiver loop
+    //    (the callback is kept here instead of being bound to every read, copying it allocates)
+    FrameHandler                                        m_receiverLoopCallback;
+    BufferPool                                          m_bufferPool;
+    SharedBuffer                                        m_frameBuffer;
+    std::optional<ReadBuffer>                           m_frameReadBuffer;
     bool                                                m_receiverLoopRunning;
     bool                                                m_shouldReconnectReceiverLoop;
 
-    // -- message queue and sender control
+    // -- connection state and receiver control
     class CVState {
         typedef uint8_t Flag;
     public:
-        // flag for running the sender daemon
-        inline static const Flag RunSenderDaemon = 1 << 0;
-
         // flag for running the receiver loop
-        inline static const Flag RunReceiverLoop = 1 << 1;
-
-        // whether message queue is empty
-        inline static const Flag MessageQueueNotEmpty = 1 << 2;
+        inline static const Flag RunReceiverLoop = 1 << 0;
 
         enum State {
             // connection info
@@ -161,22 +202,21 @@ private:
         void setState(State state);
         bool testFlag(Flag flag) const;
         bool testState(State state) const;
-        bool shouldWakeSender() const;
 
     private:
         Flag        _flag;
         uint8_t     _state;
     };
     CVState                                             m_state;
-    std::thread                                         m_senderDaemon;
     mutable std::mutex                                  m_mutex_state;        // mutex for connection flag
     mutable std::mutex                                  m_mutex_messageQ;     // mutex for message queue
-    std::condition_variable                             m_cv;                 // for notifying the sender daemon
     struct MessageData {
         std::string request;
-        std::function<void()> callback;
+        SendHandler callback;
     };
     std::queue<MessageData>                             m_messageQueue;
+    MessageData                                         m_pendingWrite;       // keeps the buffer alive during the write
+    bool                                                m_writeInProgress;
 };
 
 }